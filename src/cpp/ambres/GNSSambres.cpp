@@ -2,6 +2,7 @@
 #include "GNSSambres.hpp"
 #include "testUtils.hpp"
 
+#include <algorithm>
 #include <math.h>
 
 #define LOG_PI          1.14472988584940017
@@ -156,33 +157,97 @@ int interat_round(
 }
 
 
+/** LᵀDL factorisation of a covariance matrix, P = Lᵀ * diag(D) * L, with L unit lower triangular.
+* Columns are eliminated from the last, as rank-1 updates of the remaining lower triangle
+*/
 bool LTDL_factorization(
-	GinAR_mtx& mtrx)		///< Reference to structure containing float values and covariance
+	const MatrixXd&	P,		///< Covariance matrix to factorise (only the lower triangle is used)
+	MatrixXd&		L,		///< Unit lower triangular factor
+	VectorXd&		D)		///< Diagonal factor
 {
-	int n = mtrx.aflt.size();
-	MatrixXd P = mtrx.Paflt;
-	
-	MatrixXd L = MatrixXd::Zero(n,n);
-	VectorXd D = VectorXd::Zero(n);
-	
-	for (int i=n-1; i>=0; i--)
+	int n = P.rows();
+	MatrixXd A = P;
+
+	L = MatrixXd::Identity(n, n);
+	D = VectorXd::Zero(n);
+
+	for (int i = n - 1; i >= 0; i--)
 	{
-		if (P(i,i)<=0)
+		double d = A(i, i);
+		if (d <= 0)
 			return false;
-		
-		D(i) = P(i,i);
-		double a=sqrt(P(i,i));
-		L.block(i, 0, 1, i+1) = P.block(i, 0, 1, i+1)/a;
-		for (int j=0;j<i;j++)
-			P.block(j, 0, 1, j+1)-= L(i,j)*L.block(i, 0, 1, j+1);
-		L.block(i, 0, 1, i+1)/= L(i,i);
+
+		D(i) = d;
+		VectorXd v = A.row(i).head(i).transpose();
+
+		A.topLeftCorner(i, i).selfadjointView<Eigen::Lower>().rankUpdate(v, -1 / d);
+		L.row(i).head(i) = v.transpose() / d;
 	}
-	
-	mtrx.Ltrs = L;
-	mtrx.Dtrs = D;
+
 	return true;
 }
 
+bool LTDL_factorization(
+	GinAR_mtx& mtrx)		///< Reference to structure containing float values and covariance
+{
+	return LTDL_factorization(mtrx.Paflt, mtrx.Ltrs, mtrx.Dtrs);
+}
+
+/** Lambda decorrelation of LᵀDL factors in place, by integer Gauss transformations and permutations (Teunissen 1995).
+* Z accumulates the transformation as column operations, such that z = Zᵀ * a
+*/
+void lambda_reduction(
+	MatrixXd&	L,		///< Unit lower triangular factor
+	VectorXd&	D,		///< Diagonal factor
+	MatrixXd&	Z)		///< Transformation to update
+{
+	int n = D.size();
+
+	int k = n - 2;
+	int j = n - 2;
+	while (j >= 0)
+	{
+		if (j <= k)
+		for (int i = j + 1; i < n; i++)
+		{
+			double mu = ROUND(L(i, j));
+			if (mu != 0)
+			{
+				//L is lower triangular, only the tail of the columns are non-zero
+				L.col(j).tail(n - i) -= mu * L.col(i).tail(n - i);
+				Z.col(j)			 -= mu * Z.col(i);
+			}
+		}
+
+		double del = D(j) + L(j+1, j) * L(j+1, j) * D(j+1);
+		if ((del + 1E-6) < D(j+1))
+		{
+			double eta = D(j)					/ del;
+			double lam = D(j+1) * L(j+1, j)		/ del;
+
+			D(j)	= eta * D(j+1);
+			D(j+1)	= del;
+
+			for (int c = 0; c < j; c++)
+			{
+				double a0 = L(j,	c);
+				double a1 = L(j+1,	c);
+				L(j,	c) = a1 - L(j+1, j) * a0;
+				L(j+1,	c) = lam * a1 + eta * a0;
+			}
+			L(j+1, j) = lam;
+
+			L.col(j).tail(n - j - 2).swap(L.col(j+1).tail(n - j - 2));
+			Z.col(j)				.swap(Z.col(j+1));
+
+			k = j;
+			j = n - 2;
+		}
+		else
+			j--;
+	}
+}
+
 /** Lambda decorrelation (trough Z transform) */
 int Ztrans_reduction(
 	Trace& trace,		///< Debug trace
@@ -198,80 +263,203 @@ int Ztrans_reduction(
 		return -1;
 	}
 	
-	VectorXd x = mtrx.aflt;
-	VectorXd D = mtrx.Dtrs;
-	MatrixXd L = mtrx.Ltrs;
-	MatrixXd Z = MatrixXd::Identity(n, n);
-	
 	if (AR_VERBO)
 	{
 		trace << std::setprecision(8); 
-		trace << std::endl << "x =" << std::endl << x.transpose() << std::endl;
-		trace << std::endl << "Px=" << std::endl << mtrx.Paflt    << std::endl;
-		trace << std::endl << "Lx=" << std::endl << L             << std::endl;
-		trace << std::endl << "Dx=" << std::endl << D.transpose() << std::endl;
+		trace << std::endl << "x =" << std::endl << mtrx.aflt.transpose()	<< std::endl;
+		trace << std::endl << "Px=" << std::endl << mtrx.Paflt				<< std::endl;
+		trace << std::endl << "Lx=" << std::endl << mtrx.Ltrs				<< std::endl;
+		trace << std::endl << "Dx=" << std::endl << mtrx.Dtrs.transpose()	<< std::endl;
 	}	
 	
-	int k=n-2;
-	int j=n-2;
-	while (j>=0)
+	MatrixXd Z = MatrixXd::Identity(n, n);
+	
+	lambda_reduction(mtrx.Ltrs, mtrx.Dtrs, Z);
+
+	mtrx.Ztrs = Z.transpose();
+	mtrx.zflt = mtrx.Ztrs * mtrx.aflt;
+
+	if (AR_VERBO)
+	{
+		trace << std::setprecision(8);
+		trace << std::endl << "z =" << std::endl << mtrx.zflt.transpose()	<< std::endl;
+		trace << std::endl << "Zt=" << std::endl << mtrx.Ztrs				<< std::endl;
+		trace << std::endl << "Lz=" << std::endl << mtrx.Ltrs				<< std::endl;
+		trace << std::endl << "Dz=" << std::endl << mtrx.Dtrs.transpose()	<< std::endl;
+	}
+	
+	return n;
+}
+
+/** Number of decorrelated ambiguities, counted from the last, that may be fixed while the bootstrapped success rate remains above a threshold
+*/
+int bootstrap_subset(
+	const VectorXd&	D,			///< Diagonal factor of the decorrelated covariance
+	double			sucthr)		///< Success rate threshold
+{
+	double	succ = 1;
+	int		zsiz = 0;
+
+	for (int k = D.size() - 1; k >= 0; k--)
+	{
+		succ *= erf(sqrt(1 / (8 * D(k))));
+		if (succ < sucthr)
+			break;
+
+		zsiz++;
+	}
+
+	return zsiz;
+}
+
+/** Depth first search for the integer candidates closest to the decorrelated float ambiguities (Chang et al 2005).
+* Candidates are kept in fixed capacity storage, with the search space shrinking to the worst kept candidate once the set is full.
+* Returns the number of candidates found, sorted by ascending distance, or -1 if the search did not complete within the loop limit
+*/
+int lambda_candidates(
+	const MatrixXd&	L,			///< Unit lower triangular factor of the decorrelated covariance
+	const VectorXd&	D,			///< Diagonal factor of the decorrelated covariance
+	const VectorXd&	zflt,		///< Decorrelated float ambiguities
+	LambdaSearch&	search,		///< Search options
+	MatrixXd&		cands,		///< Integer candidates, one per column
+	VectorXd&		dists)		///< Squared distances of the candidates from the float solution
+{
+	int n		= D.size();
+	int kmax	= n - 1;
+	int kmin	= search.kmin;
+	int nset	= std::max(search.nset, 0);
+	int cap		= search.stopFull ? nset + 1 : nset;
+
+	cands	= MatrixXd::Zero(n, cap);
+	dists	= VectorXd::Zero(cap);
+
+	if	( n		<= 0
+		||cap	<= 0)
 	{
-		if (j<=k)
-		for (int i=j+1; i<n; i++)
+		return 0;
+	}
+
+	VectorXd dist = VectorXd::Zero(n);
+	VectorXd zadj = VectorXd::Zero(n);
+	VectorXd zfix = VectorXd::Zero(n);
+	VectorXd zdif = VectorXd::Zero(n);
+	VectorXd step = VectorXd::Zero(n);
+
+	int		k		= kmax;
+	int		ncand	= 0;
+	int		worst	= 0;
+	double	maxdist	= 1e99;
+
+	zadj(k) = zflt(k);
+	zfix(k) = ROUND(zadj(k));
+	zdif(k) = zadj(k) - zfix(k);
+	step(k) = zdif(k) <= 0 ? -1 : 1;
+
+	long int loops = 0;
+	while (true)
+	{
+		if	( search.maxLoops > 0
+			&&loops++ >= search.maxLoops)
 		{
-			double mu = ROUND(L(i, j));
-			if (mu != 0)
+			return -1;
+		}
+
+		double newdist = dist(k) + zdif(k) * zdif(k) / D(k);
+
+		if (newdist < maxdist)
+		{
+			if (k != kmin)
 			{
-				L.col(j) -= mu * L.col(i);
-				Z.col(j) -= mu * Z.col(i);
+				k--;
+				dist(k) = newdist;
+
+				int len = kmax - k;
+				zadj(k) = zflt(k) - L.col(k).tail(len).dot(zdif.tail(len));
+				zfix(k) = ROUND(zadj(k));
+				zdif(k) = zadj(k) - zfix(k);
+				step(k) = zdif(k) <= 0 ? -1 : 1;
+
+				continue;
+			}
+
+			//candidate found, store it in place of an equal distance candidate, a free slot, or the worst one
+			int slot = -1;
+			for (int i = 0; i < ncand; i++)
+			{
+				if (dists(i) == newdist)
+				{
+					slot = i;
+					break;
+				}
+			}
+
+			if		(slot >= 0)		{}
+			else if (ncand < cap)	slot = ncand++;
+			else					slot = worst;
+
+			cands.col(slot)	= zfix;
+			dists(slot)		= newdist;
+
+			worst = 0;
+			for (int i = 1; i < ncand; i++)
+				if (dists(i) > dists(worst))
+					worst = i;
+
+			double maxd = newdist * search.ratthr;
+			if	( search.ratthr > 0
+				&&ncand > 1
+				&&maxd < maxdist)
+			{
+				maxdist = maxd;
+			}
+
+			if	( search.stopFull
+				&&ncand > nset)
+			{
+				break;
+			}
+
+			if	( ncand == nset
+				&&dists(worst) < maxdist)
+			{
+				maxdist = dists(worst);
 			}
+
+			zfix(kmin) += step(kmin);
+			zdif(kmin) = zadj(kmin) - zfix(kmin);
+			step(kmin) = -step(kmin) + (step(kmin) < 0 ? 1 : -1);
 		}
-		
-		double del = D(j) + L(j+1,j)*L(j+1,j)*D(j+1);
-		if ((del+1E-6)<D(j+1)) 
+		else
 		{
-			double eta = D(j) / del;
-			double lam = D(j+1) * L(j+1,j) / del;
-			
-			D(j)   = eta * D(j+1);
-			D(j+1) = del;
-			
-			MatrixXd a0 = L.block(j,   0, 1, j); 
-    		MatrixXd a1 = L.block(j+1, 0, 1, j);
-    		L.block(j,   0, 1, j) = a1 - L(j+1,j)*a0;
-			L.block(j+1, 0, 1, j) = lam*a1 + eta*a0;
-			L(j+1,j) = lam;
-			
-			VectorXd Ltmp = L.block(j+2, j, n-j-2, 1);
-			L.block(j+2, j,   n-j-2, 1) = L.block(j+2, j+1, n-j-2, 1);
-			L.block(j+2, j+1, n-j-2, 1) = Ltmp;
-			
-			VectorXd Ztmp = Z.col(j);
-			Z.col(j)   = Z.col(j+1);
-			Z.col(j+1) = Ztmp;
-			
-			k=j;
-			j=n-2;
+			if (k == kmax)
+				break;
+
+			k++;
+			zfix(k) += step(k);
+			zdif(k) = zadj(k) - zfix(k);
+			step(k) = -step(k) + (step(k) < 0 ? 1 : -1);
 		}
-		else
-			j--;
 	}
 
-	mtrx.Ztrs = Z.transpose();
-	mtrx.zflt = mtrx.Ztrs * x;
-	mtrx.Ltrs = L;
-	mtrx.Dtrs = D;
+	//sort the candidates by distance
+	vector<int> order(ncand);
+	for (int i = 0; i < ncand; i++)
+		order[i] = i;
 
-	if (AR_VERBO)
+	std::sort(order.begin(), order.end(), [&](int a, int b) { return dists(a) < dists(b); });
+
+	MatrixXd sortedCands(n, ncand);
+	VectorXd sortedDists(ncand);
+	for (int i = 0; i < ncand; i++)
 	{
-		trace << std::setprecision(8);
-		trace << std::endl << "z =" << std::endl << mtrx.zflt.transpose()	<< std::endl;
-		trace << std::endl << "Zt=" << std::endl << mtrx.Ztrs				<< std::endl;
-		trace << std::endl << "Lz=" << std::endl << L						<< std::endl;
-		trace << std::endl << "Dz=" << std::endl << D.transpose()			<< std::endl;
+		sortedCands.col(i)	= cands.col(order[i]);
+		sortedDists(i)		= dists(order[i]);
 	}
-	
-	return n;
+
+	cands = sortedCands;
+	dists = sortedDists;
+
+	return ncand;
 }
 
 /** Integer bootstrapping */
@@ -312,126 +500,24 @@ int lambda_search(
 
 	
 	int nmax = mtrx.Dtrs.size();
-	int k = nmax - 1;
-	int kmax = k;
-
-	double succ = erf(sqrt(1 / (8 * mtrx.Dtrs(k--))));
-	
-	if (succ < opt.sucthr) 
+	int zsiz = bootstrap_subset(mtrx.Dtrs, opt.sucthr);
+	if (zsiz < 3)
 		return 0;
-
-	int zsiz = 1;
-
-	while (k >= 0)
-	{
-		succ *= erf(sqrt(1 / (8 * mtrx.Dtrs(k--))));
-		if (succ < opt.sucthr)
-			break;
-		zsiz++;
-	}
-	if(zsiz<3)
-		return 0;
-	
-	int kmin=kmax-zsiz+1;
-
-	map<double, VectorXd> zfixList;
-
-	MatrixXd L = mtrx.Ltrs;
-	VectorXd D = mtrx.Dtrs;
-	VectorXd zflt = mtrx.zflt;
 	
-	VectorXd dist = VectorXd::Zero(nmax);
-	VectorXd zadj = VectorXd::Zero(nmax);
-	VectorXd zfix = VectorXd::Zero(nmax);
-	VectorXd zdif = VectorXd::Zero(nmax);
-	VectorXd step = VectorXd::Zero(nmax);
-	
-	k = kmax;
-	zadj(k) = zflt(k);
-	zfix(k) = ROUND(zadj(k));
-	zdif(k) = zadj(k) - zfix(k);
-	step(k) = zdif(k) < 0 ? -1 : 1;
-	bool search = true;
-	double maxdist = 1e99;
-	int ncand = 0;
-	
-	while (search)
-	{
-		double newdist = dist(k) + zdif(k) * zdif(k) / D(k);
-
-		if (newdist < maxdist)
-		{
-			if (k != kmin)
-			{
-				k--;
-				dist(k) = newdist;
-				
-				zadj(k) = zflt(k);
-				for(int j = k+1; j<nmax; j++)
-					zadj(k)-= zdif(j)*L(j,k);
-				
-				zfix(k) = ROUND(zadj(k));
-				zdif(k) = zadj(k) - zfix(k);
-				step(k) = zdif(k) < 0 ? -1 : 1;
-			}
-			else
-			{
-				VectorXd zcut = zfix.tail(zsiz);
-				zfixList[newdist] = zcut;
-				ncand = zfixList.size();
-				double maxd = newdist * opt.ratthr;
-				
-				if (ncand > 1
-				 && maxd  < maxdist) 
-					maxdist = maxd;
-
-				if(ncand > opt.nset)
-					break;
-				
-				if (opt.nset>0
-				&& (ncand >= opt.nset))
-				{
-					int ntot = 0;
-					for (auto it = zfixList.begin(); it != zfixList.end(); )
-					{
-						if (ntot++ >= opt.nset)
-							it = zfixList.erase(it);
-						else
-						{
-							maxd = it->first;
-							++it;
-						}
-					}
-					
-					if(maxd < maxdist) 
-						maxdist = maxd;
-			
-					ncand = zfixList.size();
-				}
-
-				zfix(kmin)+= step(kmin);
-				zdif(kmin) = zadj(kmin) - zfix(kmin);
-				step(kmin) =-step(kmin) + (step(kmin) < 0 ? 1 : -1);
-			}
-		}
-		else
-		{
-			if (k == kmax) break;
-			else
-			{
-				k++;
-				zfix(k)+= step(k);
-				zdif(k) = zadj(k) - zfix(k);
-				step(k) =-step(k) + (step(k) < 0 ? 1 : -1);
-			}
-		}
-	}
-
-	if (zfixList.size() < 1) 
+	LambdaSearch search;
+	search.kmin		= nmax - zsiz;
+	search.nset		= opt.nset;
+	search.ratthr	= opt.ratthr;
+	search.stopFull	= true;
+
+	MatrixXd cands;
+	VectorXd dists;
+	int ncand = lambda_candidates(mtrx.Ltrs, mtrx.Dtrs, mtrx.zflt, search, cands, dists);
+	if (ncand < 1) 
 		return 0;
 
-	double mindist = zfixList.begin()->first;
-	VectorXd zfix0 = zfixList.begin()->second;
+	double mindist = dists(0);
+	VectorXd zfix0 = cands.col(0).tail(zsiz);
 	mtrx.zfix = zfix0;
 	MatrixXd Z = mtrx.Ztrs.bottomRows(zsiz);
 	mtrx.Ztrs = Z;
@@ -446,14 +532,10 @@ int lambda_search(
 			
 		case E_ARmode::LAMBDA_ALT:
 		{
-			double first  = 0;
+			double first  = dists(0);
 			double second = 0;
-			for (auto& [dis, fixvec] : zfixList)
-			{
-				if		(first	== 0)	first	= dis;
-				else if	(second	== 0)	second	= dis;
-				else					break;
-			}
+			if (ncand > 1)
+				second = dists(1);
 			
 			if ((second/first) < opt.ratthr)	return 0;
 			else                                return zfix0.size();
@@ -461,11 +543,13 @@ int lambda_search(
 		
 		case E_ARmode::LAMBDA_AL2:
 		{
-			for (auto& [dis, fixvec] : zfixList)
+			for (int c = 0; c < ncand; c++)
 			{
+				double dis = dists(c);
 				if ((dis / mindist) > opt.ratthr) 
 					break;
 				
+				VectorXd fixvec = cands.col(c).tail(zsiz);
 				for (int l = 0; l < zfix0.size(); l++)
 				{
 					if (zfix0(l) == -99999.5) 
@@ -496,16 +580,18 @@ int lambda_search(
 		{
 			double acum = 0;
 
-			for (auto& [dis, fixvec] : zfixList)
+			for (int c = 0; c < ncand; c++)
 			{
-				double fct  = exp(-0.5 * (dis-mindist));
+				double fct  = exp(-0.5 * (dists(c)-mindist));
 				acum += fct;
 			}
 
 			VectorXd zbie = VectorXd::Zero(zsiz);
 
-			for (auto& [dis, fixvec] : zfixList)
+			for (int c = 0; c < ncand; c++)
 			{
+				double		dis		= dists(c);
+				VectorXd	fixvec	= cands.col(c).tail(zsiz);
 				double fct  = exp(-0.5 * (dis-mindist)) / acum;
 				if (AR_VERBO) 
 					trace << std::endl << "BIE Candidate found:" << fixvec.transpose() << ";   dist= " << dis << ";   fact= " << fct;
@@ -103,6 +103,17 @@ struct GinAR_bia
 	double outvari = 0;
 };
 
+/** Options for the integer least squares candidate search
+*/
+struct LambdaSearch
+{
+	int		kmin		= 0;		///< Lowest decorrelated ambiguity to search, those below are left at zero (partial AR)
+	int		nset		= 2;		///< Number of candidates to keep
+	double	ratthr		= 0;		///< Shrink the search space to this multiple of each new candidate distance, <= 0 to disable
+	bool	stopFull	= false;	///< Stop as soon as a candidate improves on a full set, rather than searching for the best set
+	int		maxLoops	= 0;		///< Maximum number of search iterations, 0 for unlimited
+};
+
 typedef map<KFKey,double> Z_Amb; 
 
 struct GinAR_rec
@@ -153,7 +164,7 @@ int  enduserAmbigResl(Trace& trace, ObsList& obsList, KFState& kfState, Vector3d
 int  smoothdAmbigResl(KFState& kfState);																				/* Ambiguity resolution on smoothed KF*/
 bool sys_frq(short int sys, E_FType& frq1, E_FType& frq2, E_FType& frq3);
 bool ARsol_ready();
-KFState retrieve_last_ARcopy ();
+KFState& retrieve_last_ARcopy ();
 GinAR_sat* GinAR_sat_metadata(SatSys sat);
 
 /* Output fuctions */
@@ -179,6 +190,12 @@ int		apply_ambigt(Trace& trace, KFState& kfState, GinAR_opt opt);
 void	updt_usr_pivot(Trace& trace, GTime time, GinAR_opt& opt);
 void	updt_net_pivot(Trace& trace, GTime time, GinAR_opt& opt);
 
+/* Integer least squares engine */
+bool	LTDL_factorization(const MatrixXd& P, MatrixXd& L, VectorXd& D);
+void	lambda_reduction(MatrixXd& L, VectorXd& D, MatrixXd& Z);
+int		lambda_candidates(const MatrixXd& L, const VectorXd& D, const VectorXd& zflt, LambdaSearch& search, MatrixXd& cands, VectorXd& dists);
+int		bootstrap_subset(const VectorXd& D, double sucthr);
+
 /* Core ambiguity resolution function */
 int		GNSS_AR(Trace& trace, GinAR_mtx& mtrx, GinAR_opt opt);
 
@@ -3,6 +3,7 @@
 map<KFKey,map<int,GinAR_amb>> WL_archive;
 map<KFKey, int> WL_arch_ind;
 map<string,map<E_AmbTyp,map<E_Sys,KFState>>> WL_ambfilt;
+map<string,map<E_AmbTyp,map<E_Sys,KFState>>> WL_fixfilt;		///< Snapshots of the WL filters with resolved ambiguities applied
 
 /** Remove ambiguity states from filter when they are not measured for an epoch.
  ** This effectively reinitialises them on the following epoch as a new state, and can be used for simple
@@ -78,6 +79,8 @@ void reset_WLfilt(
 	if (WL_ambfilt[rec][typ].find(sys) != WL_ambfilt[rec][typ].end()) 
 		WL_ambfilt[rec][typ].erase(sys);
 	
+	WL_fixfilt[rec][typ].erase(sys);
+	
 	for (auto & [key,WLmap] : WL_archive)
 	{
 		if (key.str     != rec) 												continue;
@@ -351,11 +354,10 @@ void  reslv_WLambg(
 	
 	tracepdeex(ARTRCLVL, trace, "\n#ARES_WLAR Resolving WL ambiguities %s %s %s %4d %4d", time.to_string(0).c_str(), rec.c_str(), sys._to_string(), ambState.aflt.size(), nfix);
 	
-	KFState KFcopy = WLambKF;
+	KFState& KFcopy = WL_fixfilt[rec][typ][sys];
+	KFcopy.snapshot(WLambKF);
 	VectorXd fixX = ambState.zfix;
 
-	KFcopy.initFilterEpoch();
-
 	InitialState ini0;
 	KFMeasEntryList	FixedList;
 
@@ -384,7 +386,6 @@ void  reslv_WLambg(
 		FixedList.push_back(ARMeas);
 	}
 
-	KFcopy.stateTransition(trace, time);
 	KFMeas combined = KFcopy.combineKFMeasList(FixedList);
 
 	KFcopy.filterKalman(trace, combined, false);
@@ -693,7 +693,7 @@ int  networkAmbigResl(
 	if (AR_VERBO) 
 		kfState.outputStates(trace, "/AR");
 		
-	ARcopy = kfState;
+	ARcopy.snapshot(kfState);
 	return nfix;
 }
 
@@ -718,7 +718,7 @@ int  enduserAmbigResl(
 	GinAR_opt opt = defAR_WL;
 	opt.recv = recv;
 	
-	ARstations[recv].kfState_fixed = kfState_float;
+	ARstations[recv].kfState_fixed.snapshot(kfState_float);
 	
 	TestStack::testMat(recv + "fixedx0", ARstations[recv].kfState_fixed.x);
 	TestStack::testMat(recv + "fixedP0", ARstations[recv].kfState_fixed.P);
@@ -866,7 +866,7 @@ int smoothdAmbigResl(
 	if (AR_VERBO) 
 		kfState.outputStates(trace, "/AR");
 	
-	ARcopy = kfState;
+	ARcopy.snapshot(kfState);
 	
 	return nfix;
 }
@@ -878,7 +878,7 @@ bool ARsol_ready()
 }
 
 /** Retrieved the last ambiguity resolved Kalman filter state */
-KFState retrieve_last_ARcopy()
+KFState& retrieve_last_ARcopy()
 {
 	return 	ARcopy;
 }
@@ -0,0 +1,168 @@
+
+#include <iostream>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include <chrono>
+#include <tuple>
+
+using std::vector;
+using std::tuple;
+
+#include "common.hpp"
+
+/** Reference extraction of a field one bit at a time, as it was done before fields were extracted a word at a time
+*/
+unsigned int getbituBitwise(
+	const unsigned char*	buff,		///< Byte data to read from
+	int						pos,		///< Bit position from start of data
+	int						len)		///< Bit length of field
+{
+	unsigned int bits = 0;
+	for (int i = pos; i < pos + len; i++)
+		bits = (bits << 1) + ((buff[i/8] >> (7 - i%8)) & 1u);
+
+	return bits;
+}
+
+/** Reference insertion of a field one bit at a time, as it was done before fields were inserted a word at a time
+*/
+void setbituBitwise(
+	unsigned char*	buff,		///< Byte data to modify
+	int				pos,		///< Bit position from start of data
+	int				len,		///< Bit length of field (1-32)
+	unsigned int	data)		///< Data to insert
+{
+	unsigned int mask = 1u << (len - 1);
+
+	for (int i = pos; i < pos + len; i++, mask >>= 1)
+	{
+		if (data & mask)	buff[i/8] |=  (1u << (7 - i%8));
+		else				buff[i/8] &= ~(1u << (7 - i%8));
+	}
+}
+
+/** Returns the time taken per call by a function over a number of repetitions (ns)
+*/
+template<typename FUNC>
+double timePerCall(
+	int		repetitions,	///< Number of times to repeat the function
+	int		callsPerRep,	///< Number of calls made by each repetition
+	FUNC	func)			///< Function to time
+{
+	auto start = std::chrono::steady_clock::now();
+
+	for (int r = 0; r < repetitions; r++)
+	{
+		func();
+	}
+
+	auto stop = std::chrono::steady_clock::now();
+
+	return std::chrono::duration<double, std::nano>(stop - start).count() / ((double) repetitions * callsPerRep);
+}
+
+/** Compares the word-wise RTCM bit field functions against the previous bit-by-bit implementation.
+* Random fields are extracted and inserted at random positions and must give identical results and buffers,
+* then sequential extraction and insertion of mixed-length fields, as done by the RTCM decoders and encoder, is timed.
+* Returns non-zero if any results differ.
+*/
+int main(
+	int		argc,
+	char**	argv)
+{
+	const int bufferBytes	= 1024;
+	const int numFields		= 2000000;
+
+	std::mt19937					gen(12345);
+	std::uniform_int_distribution<>	byteDist	(0, 255);
+	std::uniform_int_distribution<>	lenDist		(1, 32);
+	std::uniform_int_distribution<>	posDist		(0, (bufferBytes - 4) * 8);
+
+	vector<unsigned char> buffer(bufferBytes);
+	for (auto& byte : buffer)
+		byte = byteDist(gen);
+
+	long int mismatches = 0;
+
+	//random extraction
+	for (int n = 0; n < numFields; n++)
+	{
+		int pos = posDist(gen);
+		int len = lenDist(gen);
+
+		if (getbitu(buffer.data(), pos, len) != getbituBitwise(buffer.data(), pos, len))
+		{
+			mismatches++;
+		}
+	}
+
+	//random insertion, into separate copies of the same data
+	vector<unsigned char> wordBuffer	= buffer;
+	vector<unsigned char> bitBuffer		= buffer;
+
+	for (int n = 0; n < numFields; n++)
+	{
+		int pos = posDist(gen);
+		int len = lenDist(gen);
+
+		unsigned int data = gen();
+		if (len < 32)
+			data &= (1u << len) - 1;
+
+		setbituInc		(wordBuffer	.data(), pos, len, data);
+		setbituBitwise	(bitBuffer	.data(), pos, len, data);
+	}
+
+	if (wordBuffer != bitBuffer)
+	{
+		mismatches++;
+	}
+
+	//sequential mixed-length fields, as found in MSM messages
+	vector<tuple<int, int>> fields;
+	for (int pos = 0; ; )
+	{
+		int len = lenDist(gen);
+		if (pos + len > bufferBytes * 8)
+			break;
+
+		fields.push_back({pos, len});
+		pos += len;
+	}
+
+	const int repetitions = 2000;
+
+	unsigned int checksumWord	= 0;
+	unsigned int checksumBit	= 0;
+
+	double getWord	= timePerCall(repetitions, fields.size(), [&]{ for (auto& [pos, len] : fields)	checksumWord	+= getbitu			(buffer.data(), pos, len); });
+	double getBit	= timePerCall(repetitions, fields.size(), [&]{ for (auto& [pos, len] : fields)	checksumBit		+= getbituBitwise	(buffer.data(), pos, len); });
+
+	if (checksumWord != checksumBit)
+	{
+		mismatches++;
+	}
+
+	double setWord	= timePerCall(repetitions, fields.size(), [&]{ for (auto& [pos, len] : fields)	setbituInc		(wordBuffer	.data(), pos, len, getbituBitwise(buffer.data(), pos, len)); });
+	double setBit	= timePerCall(repetitions, fields.size(), [&]{ for (auto& [pos, len] : fields)	setbituBitwise	(bitBuffer	.data(), pos, len, getbituBitwise(buffer.data(), pos, len)); });
+
+	if	( wordBuffer	!= buffer
+		||bitBuffer		!= buffer)
+	{
+		mismatches++;
+	}
+
+	std::cout << "Fields compared        : " << numFields		<< " extracted, " << numFields << " inserted" << std::endl;
+	std::cout << "Mismatches             : " << mismatches		<< std::endl;
+	std::cout << "getbitu    word / bit  : " << getWord			<< " / " << getBit << " ns per field" << std::endl;
+	std::cout << "setbitu    word / bit  : " << setWord			<< " / " << setBit << " ns per field (including a reference read)" << std::endl;
+
+	if (mismatches)
+	{
+		std::cout << "FAILED: word-wise results differ from bit-by-bit results" << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,529 @@
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+
+using std::string;
+using std::vector;
+
+#include "GNSSambres.hpp"
+
+/** Recorded ambiguity resolution problem, with the results of the previous implementation
+*/
+struct LambdaFixture
+{
+	int			m		= 2;	///< Number of candidates requested
+	VectorXd	aflt;			///< Float ambiguities (cycles)
+	MatrixXd	Qa;				///< Covariance of float ambiguities (cycles^2)
+	MatrixXd	Fref;			///< Fixed ambiguity candidates found by the previous implementation, one per column
+	VectorXd	sref;			///< Squared distances of the candidates found by the previous implementation
+};
+
+/** Previous LAMBDA implementation (rtklib lambda.c, Takasu 2007-2008), kept as the reference that the shared engine must reproduce
+*/
+namespace previous
+{
+	double round(double x)	{	return floor(x + 0.5);		}
+	double sgn(double x)	{	return x <= 0 ? -1 : 1;		}
+
+	/** LD factorization (Q=L'*diag(D)*L)
+	*/
+	int LD(int n, const double* Q, double* L, double* D)
+	{
+		int info = 0;
+		vector<double> A(Q, Q + n * n);
+
+		for (int i = n - 1; i >= 0; i--)
+		{
+			if ((D[i] = A[i+i*n]) <= 0)	{	info = -1;	break;	}
+			double a = sqrt(D[i]);
+			for (int j = 0; j <= i;		j++)							L[i+j*n]	= A[i+j*n] / a;
+			for (int j = 0; j <= i - 1;	j++)	for (int k = 0; k <= j; k++)	A[j+k*n]	-= L[i+k*n] * L[i+j*n];
+			for (int j = 0; j <= i;		j++)							L[i+j*n]	/= L[i+i*n];
+		}
+		return info;
+	}
+
+	/** Integer gauss transformation
+	*/
+	void gauss(int n, double* L, double* Z, int i, int j)
+	{
+		int mu = (int) round(L[i+j*n]);
+		if (mu != 0)
+		{
+			for (int k = i; k < n; k++)	L[k+n*j] -= (double) mu * L[k+i*n];
+			for (int k = 0; k < n; k++)	Z[k+n*j] -= (double) mu * Z[k+i*n];
+		}
+	}
+
+	/** Permutations
+	*/
+	void perm(int n, double* L, double* D, int j, double del, double* Z)
+	{
+		double eta	= D[j] / del;
+		double lam	= D[j+1] * L[j+1+j*n] / del;
+		D[j]	= eta * D[j+1];
+		D[j+1]	= del;
+		for (int k = 0; k <= j - 1; k++)
+		{
+			double a0 = L[j+k*n];
+			double a1 = L[j+1+k*n];
+			L[j+k*n]	= -L[j+1+j*n] * a0 + a1;
+			L[j+1+k*n]	= eta * a0 + lam * a1;
+		}
+		L[j+1+j*n] = lam;
+		for (int k = j + 2;	k < n; k++)	std::swap(L[k+j*n], L[k+(j+1)*n]);
+		for (int k = 0;		k < n; k++)	std::swap(Z[k+j*n], Z[k+(j+1)*n]);
+	}
+
+	/** Lambda reduction (z=Z'*a, Qz=Z'*Q*Z=L'*diag(D)*L)
+	*/
+	void reduction(int n, double* L, double* D, double* Z)
+	{
+		int j = n - 2;
+		int k = n - 2;
+		while (j >= 0)
+		{
+			if (j <= k)
+				for (int i = j + 1; i < n; i++)
+					gauss(n, L, Z, i, j);
+			double del = D[j] + L[j+1+j*n] * L[j+1+j*n] * D[j+1];
+			if (del + 1E-6 < D[j+1])
+			{
+				perm(n, L, D, j, del, Z);
+				k = j;
+				j = n - 2;
+			}
+			else j--;
+		}
+	}
+
+	/** Modified lambda (mlambda) search
+	*/
+	int search(int n, int m, const double* L, const double* D, const double* zs, double* zn, double* s)
+	{
+		const int loopMax = 10000;
+		int nn = 0;
+		int imax = 0;
+		double maxdist = 1E99;
+		double y;
+		vector<double> S(n * n, 0), dist(n), zb(n), z(n), step(n);
+
+		int k = n - 1;
+		dist[k] = 0;
+		zb[k]	= zs[k];
+		z[k]	= round(zb[k]);
+		y		= zb[k] - z[k];
+		step[k]	= sgn(y);
+		int c;
+		for (c = 0; c < loopMax; c++)
+		{
+			double newdist = dist[k] + y * y / D[k];
+			if (newdist < maxdist)
+			{
+				if (k != 0)
+				{
+					dist[--k] = newdist;
+					for (int i = 0; i <= k; i++)
+						S[k+i*n] = S[k+1+i*n] + (z[k+1] - zb[k+1]) * L[k+1+i*n];
+					zb[k]	= zs[k] + S[k+k*n];
+					z[k]	= round(zb[k]);
+					y		= zb[k] - z[k];
+					step[k]	= sgn(y);
+				}
+				else
+				{
+					if (nn < m)
+					{
+						if (nn == 0 || newdist > s[imax])
+							imax = nn;
+						for (int i = 0; i < n; i++)
+							zn[i+nn*n] = z[i];
+						s[nn++] = newdist;
+					}
+					else
+					{
+						if (newdist < s[imax])
+						{
+							for (int i = 0; i < n; i++)
+								zn[i+imax*n] = z[i];
+							s[imax] = newdist;
+							imax = 0;
+							for (int i = 0; i < m; i++)
+								if (s[imax] < s[i])
+									imax = i;
+						}
+						maxdist = s[imax];
+					}
+					z[0]	+= step[0];
+					y		= zb[0] - z[0];
+					step[0]	= -step[0] - sgn(step[0]);
+				}
+			}
+			else
+			{
+				if (k == n - 1)
+					break;
+				k++;
+				z[k]	+= step[k];
+				y		= zb[k] - z[k];
+				step[k]	= -step[k] - sgn(step[k]);
+			}
+		}
+		for (int i = 0; i < m - 1; i++)
+		for (int j = i + 1; j < m; j++)
+		{
+			if (s[i] < s[j])
+				continue;
+			std::swap(s[i], s[j]);
+			for (int k = 0; k < n; k++)
+				std::swap(zn[k+i*n], zn[k+j*n]);
+		}
+
+		if (c >= loopMax)
+			return -1;
+		return 0;
+	}
+
+	/** Full integer least squares estimation, returns the fixed candidates in the original ambiguity space
+	*/
+	bool lambda(const VectorXd& aflt, const MatrixXd& Qa, int m, MatrixXd& F, VectorXd& s)
+	{
+		int n = aflt.size();
+		MatrixXd L = MatrixXd::Zero(n, n);
+		VectorXd D = VectorXd::Zero(n);
+		MatrixXd Z = MatrixXd::Identity(n, n);
+		MatrixXd E = MatrixXd::Zero(n, m);
+		s = VectorXd::Zero(m);
+
+		if (LD(n, Qa.data(), L.data(), D.data()))
+			return false;
+
+		reduction(n, L.data(), D.data(), Z.data());
+
+		VectorXd z = Z.transpose() * aflt;
+
+		if (search(n, m, L.data(), D.data(), z.data(), E.data(), s.data()))
+			return false;
+
+		F = Z.transpose().partialPivLu().solve(E);
+		return true;
+	}
+}
+
+/** Integer least squares estimation using the shared LAMBDA engine, as called by rtklib lambda()
+*/
+bool sharedLambda(
+	const VectorXd&	aflt,
+	const MatrixXd&	Qa,
+	int				m,
+	MatrixXd&		F,
+	VectorXd&		s)
+{
+	int n = aflt.size();
+	MatrixXd L;
+	VectorXd D;
+
+	if (LTDL_factorization(Qa, L, D) == false)
+		return false;
+
+	MatrixXd Z = MatrixXd::Identity(n, n);
+	lambda_reduction(L, D, Z);
+
+	VectorXd z = Z.transpose() * aflt;
+
+	LambdaSearch search;
+	search.nset		= m;
+	search.maxLoops	= 10000;
+
+	MatrixXd E;
+	int ncand = lambda_candidates(L, D, z, search, E, s);
+	if (ncand != m)
+		return false;
+
+	F = Z.transpose().partialPivLu().solve(E);
+	return true;
+}
+
+/** Generate float ambiguities and covariances from simulated double differenced carrier phase and code geometries.
+* Ambiguities from short observation spans are strongly correlated, as in practice, which is what the decorrelation and search must handle
+*/
+vector<LambdaFixture> simulateFixtures()
+{
+	std::mt19937					gen(20261018);
+	std::normal_distribution<>		normal;
+	std::uniform_real_distribution<>uniform(0, 1);
+
+	const double lambda		= 0.1903;	//L1 wavelength (m)
+	const double sigmaPhase	= 0.003;
+	const double sigmaCode	= 0.3;
+
+	vector<LambdaFixture> fixtures;
+
+	for (int n : {3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30})
+	for (int epochs : {1, 3, 10})
+	{
+		//satellite directions, with the last one as the double difference reference
+		vector<Vector3d> dirs(n + 1);
+		vector<Vector3d> rates(n + 1);
+		for (int i = 0; i <= n; i++)
+		{
+			double az = uniform(gen) * 2 * M_PI;
+			double el = (10 + uniform(gen) * 80) * M_PI / 180;
+			dirs[i]		= Vector3d(cos(el) * sin(az), cos(el) * cos(az), sin(el));
+			rates[i]	= Vector3d(normal(gen), normal(gen), normal(gen)) * 1e-3;
+		}
+
+		//normal equations for position and ambiguities, accumulated over epochs of phase and code
+		int numX = 3 + n;
+		MatrixXd N = MatrixXd::Zero(numX, numX);
+		for (int e = 0; e < epochs; e++)
+		for (int type = 0; type < 2; type++)
+		{
+			MatrixXd H = MatrixXd::Zero(n, numX);
+			for (int i = 0; i < n; i++)
+			{
+				Vector3d ui = (dirs[i] + rates[i] * e * 30).normalized();
+				Vector3d ur = (dirs[n] + rates[n] * e * 30).normalized();
+				H.row(i).head(3) = (ur - ui).transpose();
+				if (type == 0)
+					H(i, 3 + i) = lambda;
+			}
+
+			//double differencing correlates the measurements through the reference satellite
+			double sigma = type == 0 ? sigmaPhase : sigmaCode;
+			MatrixXd R = (MatrixXd::Identity(n, n) + MatrixXd::Ones(n, n)) * 2 * sigma * sigma;
+
+			N += H.transpose() * R.inverse() * H;
+		}
+
+		LambdaFixture fixture;
+		fixture.m	= 2;
+		fixture.Qa	= N.inverse().bottomRightCorner(n, n);
+		fixture.Qa	= (fixture.Qa + fixture.Qa.transpose()) / 2;
+
+		//float ambiguities are integers plus correlated noise
+		MatrixXd	C = fixture.Qa.llt().matrixL();
+		VectorXd	noise(n);
+		for (int i = 0; i < n; i++)
+			noise(i) = normal(gen);
+
+		fixture.aflt = VectorXd(n);
+		for (int i = 0; i < n; i++)
+			fixture.aflt(i) = std::floor(uniform(gen) * 200 - 100);
+		fixture.aflt += C * noise;
+
+		fixtures.push_back(fixture);
+	}
+
+	return fixtures;
+}
+
+/** Write fixtures, with the results of the previous implementation, to a file
+*/
+bool writeFixtures(
+	const string&					filename,
+	vector<LambdaFixture>&			fixtures)
+{
+	std::ofstream out(filename);
+	if (!out)
+	{
+		std::cout << "Error opening " << filename << std::endl;
+		return false;
+	}
+
+	out << "# Float ambiguities and covariances (cycles) from simulated double differenced L1 phase and code, with the fixed candidates of the previous LAMBDA implementation" << std::endl;
+	out << "# n m, aflt, Qa (column major), then m columns of fixed candidates, then m squared distances" << std::endl;
+	out << std::setprecision(17);
+
+	for (auto& fixture : fixtures)
+	{
+		int n = fixture.aflt.size();
+
+		if (previous::lambda(fixture.aflt, fixture.Qa, fixture.m, fixture.Fref, fixture.sref) == false)
+		{
+			std::cout << "Previous implementation failed on a fixture of size " << n << ", not recorded" << std::endl;
+			continue;
+		}
+
+		out << n << " " << fixture.m << std::endl;
+		for (int i = 0; i < n;				i++)	out << fixture.aflt(i)			<< " ";		out << std::endl;
+		for (int i = 0; i < n * n;			i++)	out << fixture.Qa.data()[i]		<< " ";		out << std::endl;
+		for (int i = 0; i < n * fixture.m;	i++)	out << fixture.Fref.data()[i]	<< " ";		out << std::endl;
+		for (int i = 0; i < fixture.m;		i++)	out << fixture.sref(i)			<< " ";		out << std::endl;
+	}
+
+	return true;
+}
+
+/** Read recorded fixtures from a file
+*/
+vector<LambdaFixture> readFixtures(
+	const string&	filename)
+{
+	vector<LambdaFixture> fixtures;
+
+	std::ifstream in(filename);
+	if (!in)
+	{
+		std::cout << "Error opening " << filename << std::endl;
+		return fixtures;
+	}
+
+	string line;
+	while (in.peek() == '#')
+		std::getline(in, line);
+
+	int n;
+	int m;
+	while (in >> n >> m)
+	{
+		LambdaFixture fixture;
+		fixture.m		= m;
+		fixture.aflt	= VectorXd(n);
+		fixture.Qa		= MatrixXd(n, n);
+		fixture.Fref	= MatrixXd(n, m);
+		fixture.sref	= VectorXd(m);
+
+		for (int i = 0; i < n;		i++)	in >> fixture.aflt(i);
+		for (int i = 0; i < n * n;	i++)	in >> fixture.Qa.data()[i];
+		for (int i = 0; i < n * m;	i++)	in >> fixture.Fref.data()[i];
+		for (int i = 0; i < m;		i++)	in >> fixture.sref(i);
+
+		fixtures.push_back(fixture);
+	}
+
+	return fixtures;
+}
+
+/** Returns the time taken per call by a function over a number of repetitions (us)
+*/
+template<typename FUNC>
+double timePerCall(
+	int		repetitions,	///< Number of times to repeat the function
+	FUNC	func)			///< Function to time
+{
+	auto start = std::chrono::steady_clock::now();
+
+	for (int r = 0; r < repetitions; r++)
+	{
+		func();
+	}
+
+	auto stop = std::chrono::steady_clock::now();
+
+	return std::chrono::duration<double, std::micro>(stop - start).count() / repetitions;
+}
+
+/** Regression check and benchmark of the shared LAMBDA engine (LTDL_factorization, lambda_reduction, lambda_candidates).
+* Recorded fixtures are resolved by the engine and by the previous implementation, the factors and fixed candidates must agree with the recorded
+* and live results of the previous implementation, and both are timed.
+* Usage: lambda_benchmark <fixture file>, or lambda_benchmark --record <fixture file> to regenerate the fixtures.
+* Returns non-zero if any results differ.
+*/
+int main(
+	int		argc,
+	char**	argv)
+{
+	if	( argc == 3
+		&&string(argv[1]) == "--record")
+	{
+		auto fixtures = simulateFixtures();
+
+		bool pass = writeFixtures(argv[2], fixtures);
+
+		return pass ? 0 : 1;
+	}
+
+	if (argc != 2)
+	{
+		std::cout << "Usage: " << argv[0] << " <fixture file> | --record <fixture file>" << std::endl;
+		return 1;
+	}
+
+	auto fixtures = readFixtures(argv[1]);
+	if (fixtures.empty())
+	{
+		std::cout << "FAILED: no fixtures read from " << argv[1] << std::endl;
+		return 1;
+	}
+
+	int		failures		= 0;
+	double	maxFactorDiff	= 0;
+	double	totalShared		= 0;
+	double	totalPrevious	= 0;
+
+	std::cout << std::setw(4) << "n" << std::setw(14) << "shared (us)" << std::setw(16) << "previous (us)" << std::setw(10) << "result" << std::endl;
+
+	for (auto& fixture : fixtures)
+	{
+		int n = fixture.aflt.size();
+
+		//factors
+		MatrixXd L;
+		VectorXd D;
+		MatrixXd Lprev = MatrixXd::Zero(n, n);
+		VectorXd Dprev = VectorXd::Zero(n);
+
+		bool factorised		= LTDL_factorization(fixture.Qa, L, D);
+		bool factorisedPrev	= previous::LD(n, fixture.Qa.data(), Lprev.data(), Dprev.data()) == 0;
+
+		bool pass = factorised && factorisedPrev;
+		if (pass)
+		{
+			double diff = std::max((L - Lprev).cwiseAbs().maxCoeff(), ((D - Dprev).array() / Dprev.array()).abs().maxCoeff());
+			maxFactorDiff = std::max(maxFactorDiff, diff);
+			if (diff > 1e-8)
+				pass = false;
+		}
+
+		//fixed candidates, against the recorded and live results of the previous implementation
+		MatrixXd F;
+		VectorXd s;
+		MatrixXd Fprev;
+		VectorXd sprev;
+
+		pass &= sharedLambda	(fixture.aflt, fixture.Qa, fixture.m, F,		s);
+		pass &= previous::lambda(fixture.aflt, fixture.Qa, fixture.m, Fprev,	sprev);
+
+		if (pass)
+		{
+			auto sameCands = [](MatrixXd& A, MatrixXd& B)	{	return (A - B).cwiseAbs().maxCoeff() < 1e-6;								};
+			auto sameDists = [](VectorXd& a, VectorXd& b)	{	return ((a - b).array().abs() <= 1e-9 * b.array().abs().max(1)).all();	};
+
+			pass &= sameCands(F, fixture.Fref)	&& sameDists(s, fixture.sref);
+			pass &= sameCands(F, Fprev)			&& sameDists(s, sprev);
+		}
+
+		if (pass == false)
+			failures++;
+
+		int repetitions = std::max(10, 20000 / (n * n));
+
+		double shared	= timePerCall(repetitions, [&]{ sharedLambda	(fixture.aflt, fixture.Qa, fixture.m, F,		s);		});
+		double prev		= timePerCall(repetitions, [&]{ previous::lambda(fixture.aflt, fixture.Qa, fixture.m, Fprev,	sprev);	});
+
+		totalShared		+= shared;
+		totalPrevious	+= prev;
+
+		std::cout << std::setw(4) << n << std::setw(14) << std::setprecision(4) << shared << std::setw(16) << prev << std::setw(10) << (pass ? "ok" : "FAIL") << std::endl;
+	}
+
+	std::cout << "Fixtures               : " << fixtures.size()	<< std::endl;
+	std::cout << "Failures               : " << failures		<< std::endl;
+	std::cout << "Max factor difference  : " << maxFactorDiff	<< std::endl;
+	std::cout << "Total shared / previous: " << totalShared		<< " / " << totalPrevious << " us" << std::endl;
+
+	if (failures)
+	{
+		std::cout << "FAILED: shared LAMBDA engine results differ from the previous implementation" << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -1,9 +1,11 @@
 
 // #pragma GCC optimize ("O0")
 
+#include <shared_mutex>
 #include <iostream>
 #include <sstream>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <tuple>
 #include <map>
@@ -29,6 +31,7 @@ using std::map;
 #include "acsConfig.hpp"
 
 ACSConfig acsConfig = {};
+std::shared_mutex configMutex;
 
 
 
@@ -611,6 +614,7 @@ void ACSConfig::info(
 	if (output_bias_sinex)			{	ss << "\tbias sinex filename:           " << bias_sinex_filename			<< "\n"; }
 	if (output_trop_sinex)			{	ss << "\ttrop sinex filename:           " << trop_sinex_filename			<< "\n"; }
 	if (output_gpx)					{	ss << "\tgpx filename:                  " << gpx_filename					<< "\n"; }
+	if (output_profile)				{	ss << "\tprofile filename:              " << profile_filename				<< "\n"; }
 	if (output_decoded_rtcm_json)	{	ss << "\tdecoded rtcm json filename:    " << decoded_rtcm_json_filename		<< "\n"; }
 	if (output_encoded_rtcm_json)	{	ss << "\tencoded rtcm json filename:    " << encoded_rtcm_json_filename		<< "\n"; }
 
@@ -948,11 +952,30 @@ void getFromYaml(
 
 const string estimation_parameters_str	= "4 estimation_parameters";
 const string processing_options_str		= "2 processing_options";
+
+/** Guards the lazily populated option maps, so that options may be requested from parallel sections.
+* Options that have already been initialised are found under a shared lock, new entries are created under an exclusive lock.
+*/
+static std::shared_mutex optsMapMutex;
+
 /** Set satellite options for a specific satellite using a hierarchy of sources
 */
 SatelliteOptions& ACSConfig::getSatOpts(
 	SatSys& Sat)	///< Satellite to search for options for
 {
+	{
+		std::shared_lock<std::shared_mutex> readLock(optsMapMutex);
+		
+		auto it = satOptsMap.find(Sat.id());
+		if	( it != satOptsMap.end()
+			&&it->second._initialised)
+		{
+			return it->second;
+		}
+	}
+	
+	std::unique_lock<std::shared_mutex> writeLock(optsMapMutex);
+	
 	auto& satOpts = satOptsMap[Sat.id()];
 
 	//return early if possible
@@ -1014,6 +1037,19 @@ SatelliteOptions& ACSConfig::getSatOpts(
 ReceiverOptions& ACSConfig::getRecOpts(
 	string id)		///< Receiver to search for options for
 {
+	{
+		std::shared_lock<std::shared_mutex> readLock(optsMapMutex);
+		
+		auto it = recOptsMap.find(id);
+		if	( it != recOptsMap.end()
+			&&it->second._initialised)
+		{
+			return it->second;
+		}
+	}
+	
+	std::unique_lock<std::shared_mutex> writeLock(optsMapMutex);
+	
 	auto& recOpts = recOptsMap[id];
 
 	//return early if possible
@@ -1373,8 +1409,12 @@ bool ACSConfig::parse(
 	<< "Loading configuration from file " << filename;
 
 	//clear old saved parameters
-	satOptsMap.clear();
-	recOptsMap.clear();
+	{
+		std::unique_lock<std::shared_mutex> writeLock(optsMapMutex);
+		
+		satOptsMap.clear();
+		recOptsMap.clear();
+	}
 	defaultOutputOptions();
 
 	for (int i = 1; i < E_Sys::SUPPORTED; i++)
@@ -1547,6 +1587,15 @@ bool ACSConfig::parse(
 			trySetFromYaml(gpx_filename,			gpx, {"filename"			});
 		}
 		
+		{
+			auto profile = stringsToYamlObject(outputs, {"profile"});
+			
+			trySetFromYaml(output_profile,			profile, {"0 output"		}, "(bool) Enable exporting the timing of each profiled scope in chrome trace format, for viewing in chrome://tracing or perfetto");
+			trySetFromYaml(output_profile_summary,	profile, {"summary"			}, "(bool) Enable outputting the p50/p99 latency of each profiled scope to the network trace file each epoch");
+			trySetFromYaml(profile_directory,		profile, {"directory"		}, "(string) Directory to export profiling data");
+			trySetFromYaml(profile_filename,		profile, {"filename"		}, "(string) Profiling data filename");
+		}
+		
 		{
 			auto network_statistics = stringsToYamlObject(outputs, {"network_statistics"});
 			
@@ -1659,6 +1708,7 @@ bool ACSConfig::parse(
 		string root_stream_url;
 		trySetFromAny(root_input_directory,	commandOpts,	inputs, {"0 root_directory"		}, "(string) Root path to be added to all other input files (unless they are absolute)");
 		trySetFromYaml(root_stream_url,						inputs,	{"0 root_stream_url"	}, "(string) Root url to be prepended to all other streams specified in this section. If the streams used have individually specified root urls, usernames, or passwords, this should not be used.");
+		trySetFromYaml(ntrip_io_threads,					inputs,	{"0 ntrip_io_threads"	}, "(int) Number of threads used to receive and dechunk data from network streams");
 		
 		trySetFromAny(atx_files,			commandOpts,	inputs, {"atx_files"				}, "[string] List of atx files to use");			
 		trySetFromAny(snx_files,			commandOpts,	inputs, {"snx_files"				}, "[string] List of snx files to use");			
@@ -1829,6 +1879,8 @@ bool ACSConfig::parse(
 			trySetFromYaml(wait_next_epoch,						epoch_control, {std::to_string(i++) + "wait_next_epoch"		}, "(float) Time to wait for next epochs data before skipping the epoch (will default to epoch_interval as an appropriate minimum value for realtime)");		
 			trySetFromYaml(wait_all_stations,					epoch_control, {std::to_string(i++) + "wait_all_stations"	}, "(float) Time to wait from the reception of the first data of an epoch before skipping stations with data still unreceived");
 			trySetFromYaml(require_obs,							epoch_control, {std::to_string(i++) + "require_obs"			}, "(bool) Exit the program if no observation sources are available");
+			trySetFromYaml(pipeline_epochs,						epoch_control, {std::to_string(i++) + "pipeline_epochs"		}, "(bool) Read and sync observations for upcoming epochs on a separate thread while the current epoch is processed");
+			trySetFromYaml(pipeline_depth,						epoch_control, {std::to_string(i++) + "pipeline_depth"		}, "(int) Maximum number of synced epochs that may be waiting for processing when pipeline_epochs is enabled");
 			trySetFromAny(simulate_real_time,	commandOpts,	epoch_control, {std::to_string(i++) + "simulate_real_time"	}, "(bool)  For RTCM playback - delay processing to match original data rate");
 		}
 		
@@ -2028,6 +2080,8 @@ bool ACSConfig::parse(
 		{
 			trySetFromYaml(joseph_stabilisation,	filter_options,	{"joseph_stabilisation"							});
 			trySetEnumOpt( pppOpts.inverter, 		filter_options,	{"inverter" 									}, E_Inverter::_from_string_nocase, "Inverter to be used within the Kalman filter update stage, which may provide different performance outcomes in terms of processing time and accuracy and stability.");
+			trySetFromYaml(pppOpts.block_covariance,filter_options,	{"block_covariance"								}, "(bool) Propagate the state covariance through the state transition as independent blocks of uncorrelated receiver/satellite states");
+			trySetFromYaml(pppOpts.sparse_measurements,filter_options,{"sparse_measurements"						}, "(bool) Assemble measurement design and noise matrices in sparse form, rather than as dense matrices");
 			trySetFromYaml(process_rts,				filter_options,	{"rts", "0 enable"								}, "(bool) Perform backward smoothing of states to improve precision of earlier states");
 			trySetFromYaml(pppOpts.rts_lag,			filter_options,	{"rts", "1 lag"									}, "(int) Number of epochs to use in RTS smoothing. Negative numbers indicate full reverse smoothing.");
 			trySetFromYaml(pppOpts.rts_directory,	filter_options,	{"rts", "directory"								}, "(string) Directory for rts intermediate files");
@@ -2109,6 +2163,8 @@ bool ACSConfig::parse(
 		trySetFromYaml(mongo_suffix,				mongo, {"suffix"					}, "(string) Suffix to append to database elements to make distinctions between runs for comparison");
 		trySetFromYaml(mongo_database,				mongo, {"database"					}, "(string) ");
 		trySetFromYaml(mongo_uri,					mongo, {"uri"						}, "(string) Location and port of the mongo database to connect to");
+		trySetFromYaml(mongo_queue_size,			mongo, {"queue_size"				}, "(int)    Maximum number of outputs waiting to be written to the database, further outputs are dropped while it is full");
+		trySetFromYaml(mongo_batch_size,			mongo, {"batch_size"				}, "(int)    Maximum number of outputs to write to the database in each batch");
 	}
 	
 	{
@@ -2163,6 +2219,7 @@ bool ACSConfig::parse(
 	tryPatchPaths(root_output_directory,	log_directory,							log_filename);
 	tryPatchPaths(root_output_directory,	test_directory,							test_filename);
 	tryPatchPaths(root_output_directory,	sinex_directory,						sinex_filename);
+	tryPatchPaths(root_output_directory,	profile_directory,						profile_filename);
 	tryPatchPaths(root_output_directory,	ionex_directory,						ionex_filename);
 	tryPatchPaths(root_output_directory,	orbits_directory,						orbits_filename);
 	tryPatchPaths(root_output_directory,	clocks_directory,						clocks_filename);
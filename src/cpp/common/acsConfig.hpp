@@ -10,6 +10,7 @@
 
 #include "eigenIncluder.hpp"
 
+#include <shared_mutex>
 #include <chrono>
 #include <memory>
 #include <limits>
@@ -67,6 +68,8 @@ struct InputOptions
 	
 	string stream_user			= "";
 	string stream_pass			= "";
+
+	int		ntrip_io_threads	= 1;
 };
 
 struct IonexOptions
@@ -108,6 +111,11 @@ struct OutputOptions
 	string	gpx_directory	         	= "./";
 	string  gpx_filename				= "<STATION>.gpx";
 
+	bool	output_profile				= false;
+	bool	output_profile_summary		= false;
+	string	profile_directory			= "./";
+	string	profile_filename			= "pea<YYYY><DDD><HH>_profile.json";
+
 	bool	output_residuals 			= false;
 	bool	output_residual_chain		= true;
 
@@ -189,6 +197,8 @@ struct OutputOptions
 	string	mongo_uri					= "mongodb://localhost:27017";
 	string	mongo_suffix				= "";
 	string	mongo_database				= "<CONFIG>";
+	int		mongo_queue_size			= 1000000;
+	int		mongo_batch_size			= 100000;
 	
 	void defaultOutputOptions()
 	{
@@ -361,6 +371,8 @@ struct GlobalOptions
 	double	wait_next_epoch		= 0;
 	double	wait_all_stations	= 0;
 	bool	require_obs			= true;
+	bool	pipeline_epochs		= false;
+	int		pipeline_depth		= 2;
 	
 	bool	delete_old_ephemerides = false;
 	
@@ -468,6 +480,8 @@ struct FilterOptions
 	int			rts_lag			= -1;
 	
 	E_Inverter	inverter			= E_Inverter::LDLT;
+	bool		block_covariance	= false;
+	bool		sparse_measurements	= false;
 };
 
 /** Options associated with the network processing mode of operation
@@ -772,6 +786,7 @@ void dumpConfig(
 	Trace& trace);
 
 extern ACSConfig acsConfig;		///< Global variable housing all options to be used throughout the software
+extern std::shared_mutex configMutex;	///< Held exclusively while the configuration is reloaded, and shared while it is read by input threads
 
 
 
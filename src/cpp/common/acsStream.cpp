@@ -100,7 +100,8 @@ ObsList ObsStream::getObs()
 		}
 	}
 
-	return obsList;
+	//move rather than copy the observations out, the emptied list remains at the front until it is eaten
+	return std::move(obsList);
 }
 
 
@@ -292,3 +293,175 @@ void NtripRtcmStream::serverResponse(
 	
 	logStream << bsoncxx::to_json(doc) << std::endl;
 }
+
+NtripRtcmStream::~NtripRtcmStream()
+{
+	stopDecoding();
+
+	delete decodingBatch_ptr;
+
+	RtcmDecodedBatch* batch_ptr;
+	while (decodedQueue.pop(batch_ptr))
+	{
+		delete batch_ptr;
+	}
+}
+
+/** Start decoding received frames on a worker thread for this stream.
+* Should be called once the stream's output files have been configured
+*/
+void NtripRtcmStream::startDecoding()
+{
+	if (decodeWorker.joinable())
+	{
+		return;
+	}
+
+	decodeStop		= false;
+	decodeWorker	= std::thread(&NtripRtcmStream::decodeLoop, this);
+}
+
+/** Stop the decode worker and wait for it to finish
+*/
+void NtripRtcmStream::stopDecoding()
+{
+	if (decodeWorker.joinable() == false)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(decodeWakeMtx);
+
+		decodeStop = true;
+	}
+	decodeWakeCv.notify_one();
+
+	decodeWorker.join();
+}
+
+/** Get all data available from the ntrip stream and decode the frames in it
+*/
+void NtripRtcmStream::decodeReceived()
+{
+	getData();
+
+	rtcmBuffer.append(receivedData.data(), receivedData.size());
+	receivedData.clear();
+
+	parseRTCM();
+}
+
+/** Decode frames as they are received, until the worker is stopped.
+* Decoded epochs and modifications to the navigation data are accumulated in a batch,
+* which is queued for collectDecoded() without locking, or kept and added to if the queue is full.
+*/
+void NtripRtcmStream::decodeLoop()
+{
+	while (decodeStop == false)
+	{
+		{
+			std::unique_lock<std::mutex> lock(decodeWakeMtx);
+
+			//wake periodically regardless, frames may have been left to wait for real time
+			decodeWakeCv.wait_for(lock, std::chrono::milliseconds(100), [this]{ return decodeWake || decodeStop; });
+
+			decodeWake = false;
+		}
+
+		if (decodingBatch_ptr == nullptr)
+		{
+			decodingBatch_ptr = new RtcmDecodedBatch;
+		}
+
+		auto& batch = *decodingBatch_ptr;
+
+		{
+			//decoders read the configuration, keep it from being reloaded while they run
+			std::shared_lock<std::shared_mutex> configLock(configMutex);
+
+			DeferNavRequests deferNavRequests(batch.navRequests);
+
+			getData();
+
+			rtcmBuffer.append(receivedData.data(), receivedData.size());
+			receivedData.clear();
+
+			//parsing pauses at the end of each epoch, keep going until nothing more can be decoded for now
+			while (true)
+			{
+				size_t remaining = rtcmBuffer.size();
+
+				bool needMore = parseRTCM();
+
+				if	( needMore
+					||rtcmBuffer.size() == remaining)
+				{
+					break;
+				}
+			}
+		}
+
+		if	(  batch.obsListList				.empty()
+			&& batch.navRequests.requestList	.empty())
+		{
+			continue;
+		}
+
+		bool pushed = decodedQueue.push(decodingBatch_ptr);
+		if (pushed)
+		{
+			decodingBatch_ptr = nullptr;
+		}
+	}
+}
+
+/** Hand epochs decoded by the decode worker to the observation list, or store them directly if there is no worker
+*/
+void NtripRtcmStream::pushObsList(
+	ObsList&&	obsList)
+{
+	if (decodingBatch_ptr)
+	{
+		decodingBatch_ptr->obsListList.push_back(std::move(obsList));
+	}
+	else
+	{
+		RtcmStream::pushObsList(std::move(obsList));
+	}
+}
+
+/** Collect the batches queued by the decode worker, on the thread that reads this stream.
+* Modifications to the navigation data are re-issued in the order they were decoded, so they are deferred along with the epoch being synced, if any
+*/
+void NtripRtcmStream::collectDecoded()
+{
+	RtcmDecodedBatch* batch_ptr;
+	while (decodedQueue.pop(batch_ptr))
+	{
+		obsListList.splice(obsListList.end(), batch_ptr->obsListList);
+
+		for (auto& request : batch_ptr->navRequests.requestList)
+		{
+			NavRequests::modify(std::move(request));
+		}
+
+		delete batch_ptr;
+	}
+}
+
+bool NtripRtcmStream::dataChunkDownloaded(
+	const char*	dataChunk,
+	size_t		length)
+{
+	NtripStream::dataChunkDownloaded(dataChunk, length);
+
+	{
+		std::lock_guard<std::mutex> guard(decodeWakeMtx);
+
+		decodeWake = true;
+	}
+	decodeWakeCv.notify_one();
+
+	return false;
+}
@@ -2,8 +2,11 @@
 #ifndef ACS_STREAM_H
 #define ACS_STREAM_H
 
+#include <condition_variable>
 #include <iostream>
 #include <sstream>
+#include <atomic>
+#include <mutex>
 #include <utility>
 #include <vector>
 #include <string>
@@ -23,6 +26,7 @@ using std::map;
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/iostreams/device/array.hpp>
 #include <boost/algorithm/string/trim.hpp>
+#include <boost/lockfree/spsc_queue.hpp>
 #include <boost/iostreams/stream.hpp>
 #include <boost/log/expressions.hpp>
 #include <boost/log/trivial.hpp>
@@ -53,14 +57,34 @@ using boost::asio::ip::tcp;
 #include "streamRtcm.hpp"
 #include "streamRinex.hpp"
 #include "streamNtrip.hpp"
+#include "navigation.hpp"
 
 
 
 
-/** Object that streams RTCM data from NTRIP castors
+/** Observations and navigation data modifications decoded from a stream, handed to the epoch synchroniser together
+*/
+struct RtcmDecodedBatch
+{
+	list<ObsList>	obsListList;	///< Complete epochs of observations, in the order they were decoded
+	NavRequests		navRequests;	///< Modifications to the navigation data, in the order they were decoded
+};
+
+/** Object that streams RTCM data from NTRIP castors.
+* Once started, a decode worker per stream decodes frames as they arrive and queues the results without locking,
+* so that the epoch synchroniser only collects decoded epochs rather than decoding every mountpoint itself.
 */
 struct NtripRtcmStream : NtripStream, RtcmStream
 {	
+	std::thread					decodeWorker;						///< Thread that decodes received frames for this stream
+	std::mutex					decodeWakeMtx;						///< Guards decodeWake
+	std::condition_variable		decodeWakeCv;						///< Signalled by the io threads when data has been received
+	bool						decodeWake			= false;		///< Set when data has been received since the worker last looked
+	std::atomic<bool>			decodeStop			= false;		///< Requests the decode worker to finish
+	RtcmDecodedBatch*			decodingBatch_ptr	= nullptr;		///< Batch being filled by the decode worker, not yet queued
+
+	boost::lockfree::spsc_queue<RtcmDecodedBatch*, boost::lockfree::capacity<256>>	decodedQueue;	///< Decoded batches, from the decode worker (single producer) to the epoch synchroniser (single consumer)
+
 	NtripRtcmStream(const string& url_str) : NtripStream(url_str)
 	{
 		rtcmTraceFilename	= "";
@@ -69,6 +93,8 @@ struct NtripRtcmStream : NtripStream, RtcmStream
 		open();
 	}
 
+	~NtripRtcmStream();
+
 	void setUrl(const string& url_str)
 	{		
 		sourceString = url_str;
@@ -80,24 +106,36 @@ struct NtripRtcmStream : NtripStream, RtcmStream
 // 		connect();
 	}
 
-	ObsList getObs() override
-	{
-		//get all data available from the ntrip stream and convert it to an iostream for processing
-		getData();
+	void startDecoding();
+
+	void stopDecoding();
 
-		B_io::basic_array_source<char>					input_source(receivedData.data(), receivedData.size());
-		B_io::stream<B_io::basic_array_source<char>>	inputStream(input_source);
+	void decodeLoop();
 
-		parseRTCM(inputStream);
+	void collectDecoded();
 
-		int pos = inputStream.tellg();
-		if (pos < 0)
+	void decodeReceived();
+
+	void pushObsList(
+		ObsList&&	obsList)
+	override;
+
+	bool dataChunkDownloaded(
+		const char*	dataChunk,
+		size_t		length)
+	override;
+
+	ObsList getObs() override
+	{
+		if (decodeWorker.joinable())
 		{
-			receivedData.clear();
+			//frames have been decoded by the worker, just collect them
+			collectDecoded();
 		}
 		else
 		{
-			receivedData.erase(receivedData.begin(), receivedData.begin() + pos);
+			//get all data available from the ntrip stream and decode the frames in it
+			decodeReceived();
 		}
 
 		//call the base function once it has been prepared
@@ -115,22 +153,13 @@ struct NtripRtcmStream : NtripStream, RtcmStream
  
 	void getNav() override
 	{
-		//get all data available from the ntrip stream and convert it to an iostream for processing
-		getData();
-
-		B_io::basic_array_source<char>					input_source(receivedData.data(), receivedData.size());
-		B_io::stream<B_io::basic_array_source<char>>	inputStream(input_source);
-
-		parseRTCM(inputStream);
-
-		int pos = inputStream.tellg();
-		if (pos < 0)
+		if (decodeWorker.joinable())
 		{
-			receivedData.clear();
+			collectDecoded();
 		}
 		else
 		{
-			receivedData.erase(receivedData.begin(), receivedData.begin() + pos);
+			decodeReceived();
 		}
 	}
 };
@@ -183,7 +212,8 @@ struct FileRtcmStream : ACSFileStream, RtcmStream
 	{
 		if (filePos < 0)
 		{
-			return true;
+			//data may have been read ahead into the frame buffer before the end of the file was found
+			return lastObsListSize == 0;
 		}
 		
 		FileState fileState = openFile();
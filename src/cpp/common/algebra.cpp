@@ -1,9 +1,13 @@
 
 
 #include <functional>
+#include <sstream>
+#include <algorithm>
+#include <unordered_map>
 #include <utility>
 #include <list>
 
+using std::unordered_map;
 using std::list;
 using std::pair;
 
@@ -53,7 +57,7 @@ struct KFStatistics
 
 bool KFKey::operator ==(const KFKey& b) const
 {
-	if (str.compare(b.str)	!= 0)		return false;
+	if (str					!= b.str)	return false;
 	if (Sat					!= b.Sat)	return false;
 	if (type				!= b.type)	return false;
 	if (num					!= b.num)	return false;
@@ -97,12 +101,75 @@ void KFState::initFilterEpoch()
 		}
 		
 		//remove initialisation elements for subsequent epochs
-		mapp.erase(oneKey);
+		int erased = mapp.erase(oneKey);
+		
+		if (erased)
+		{
+			markTransitionDirty(key1);
+		}
 	}
 	
 	stateTransitionMap	[oneKey][oneKey]	= {1, 0};
 }
 
+/** Copies the estimates of another filter into this one, to derive an alternative solution (eg ambiguity fixed) for the same epoch.
+* Only the state, covariance, indices and filtering options are copied, the transition configuration and its compiled cache are left empty,
+* so a snapshot may be updated with measurements and output, but not transitioned.
+* Existing storage is reused while the number of states is unchanged, so persistent snapshots do not reallocate each epoch.
+*/
+void KFState::snapshot(
+	const KFState&	source)		///< Filter to copy estimates from
+{
+	time					= source.time;
+	x						= source.x;
+	Z						= source.Z;
+	P						= source.P;
+	dx						= source.dx;
+	kfIndexMap				= source.kfIndexMap;
+	noiseElementMap			= source.noiseElementMap;
+	stateRejectCallbacks	= source.stateRejectCallbacks;
+	measRejectCallbacks		= source.measRejectCallbacks;
+	metaDataMap				= source.metaDataMap;
+
+	lsqRequired				= source.lsqRequired;
+	chiQCPass				= source.chiQCPass;
+	sigma_check				= source.sigma_check;
+	w_test					= source.w_test;
+	chi_square_test			= source.chi_square_test;
+	chi_square_mode			= source.chi_square_mode;
+	sigma_threshold			= source.sigma_threshold;
+	id						= source.id;
+	rts_basename			= source.rts_basename;
+	rts_lag					= source.rts_lag;
+	max_filter_iter			= source.max_filter_iter;
+	max_prefit_remv			= source.max_prefit_remv;
+	output_residuals		= source.output_residuals;
+	inverter				= source.inverter;
+	block_covariance		= source.block_covariance;
+	sparse_measurements		= source.sparse_measurements;
+
+	ZTransitionMap			.clear();
+	ZAdditionMap			.clear();
+	stateTransitionMap		.clear();
+	gaussMarkovTauMap		.clear();
+	gaussMarkovMuMap		.clear();
+	procNoiseMap			.clear();
+	initNoiseMap			.clear();
+	transitionDirtyKeys		.clear();
+
+	compiledTransition			= CompiledTransition();
+	covarianceBlocks			= CovarianceBlocks();
+	transitionStructureChanged	= true;
+}
+
+/** Flags that the transition parameters of a state have changed, so that its row of the compiled transition is recalculated
+*/
+void KFState::markTransitionDirty(
+	const KFKey&	kfKey)		///< Key of the state that has changed
+{
+	transitionDirtyKeys[kfKey] = true;
+}
+
 /** Finds the position in the KF state vector of particular states.
 */
 int KFState::getKFIndex(
@@ -200,12 +267,47 @@ bool KFState::setKFNoise(
 	KFKey		kfKey,		///< Key to search for in state
 	double		value)		///< Input value
 {
-	procNoiseMap[kfKey] = value;
+	auto [it, inserted] = procNoiseMap.insert({kfKey, value});
+	
+	if	( inserted
+		||it->second != value)
+	{
+		it->second = value;
+		
+		markTransitionDirty(kfKey);
+	}
 
 	return true;
 }
 
 
+thread_local KFStateRequests* KFStateRequests::active_ptr = nullptr;
+
+/** Apply all deferred requests to their filters, in the order they were requested
+*/
+void KFStateRequests::apply()
+{
+	for (auto& request : requestList)
+	{
+		request();
+	}
+
+	requestList.clear();
+}
+
+/** Apply the requests recorded by several threads, one buffer after another, as if they had been processed serially.
+* A state added by an earlier buffer already exists when a later buffer requests it, so it is only initialised once,
+* while process noise and gauss-markov parameters from later buffers are updated in order, as they would be when processed serially
+*/
+void KFStateRequests::applyInOrder(
+	vector<KFStateRequests>&	requestsList)	///< Buffers to apply, in order
+{
+	for (auto& requests : requestsList)
+	{
+		requests.apply();
+	}
+}
+
 /** Adds dynamics to a filter state by inserting off-diagonal, time dependent elements to transition matrix
 */
 void KFState::setKFTransRate(
@@ -214,9 +316,22 @@ void KFState::setKFTransRate(
 	double			value,			///< Input value
 	InitialState	initialState)	///< Initial state for rate state.
 {
+	if (KFStateRequests::active_ptr)
+	{
+		KFStateRequests::active_ptr->requestList.push_back([=, this]{ setKFTransRate(dest, source, value, initialState); });
+		return;
+	}
+	
 	addKFState(source, initialState);
 
-	stateTransitionMap[dest][source] = {value, 1};
+	auto& entry = stateTransitionMap[dest][source];
+	
+	if (entry != tuple<double, int>{value, 1})
+	{
+		entry = {value, 1};
+		
+		markTransitionDirty(dest);
+	}
 }
 
 /** Adds dynamics to a filter state by inserting off-diagonal, non-time dependent elements to transition matrix
@@ -227,6 +342,12 @@ void KFState::setKFTrans(
 	double			value,			///< Input value
 	InitialState	initialState)	///< Initial state for rate state.
 {
+	if (KFStateRequests::active_ptr)
+	{
+		KFStateRequests::active_ptr->requestList.push_back([=, this]{ setKFTrans(dest, source, value, initialState); });
+		return;
+	}
+	
 	addKFState(dest, initialState);
 
 	auto& [oldValue, rate] = stateTransitionMap[dest][source];
@@ -240,6 +361,8 @@ void KFState::setKFTrans(
 	value += oldValue;
 	
 	stateTransitionMap[dest][source] = {value, 0};
+	
+	markTransitionDirty(dest);
 }
 
 //todo aaron think about what happens when multiple states are removed at the same time - need to use the transition map contents as well as the z map contents?
@@ -253,6 +376,8 @@ void KFState::setKFTrans(
 void KFState::removeState(
 	KFKey			kfKey)				///< Key to search for in state
 {
+	transitionStructureChanged = true;
+	
 	ZTransitionMap.			erase(kfKey);
 	stateTransitionMap.		erase(kfKey);
 	procNoiseMap.			erase(kfKey);
@@ -268,18 +393,44 @@ bool KFState::addKFState(
 	KFKey			kfKey,			///< The key to add to the state
 	InitialState	initialState)	///< The initial conditions to add to the state
 {
+	if (KFStateRequests::active_ptr)
+	{
+		//defer the addition, but report whether the state is new as at the start of this batch of requests
+		KFStateRequests::active_ptr->requestList.push_back([=, this]{ addKFState(kfKey, initialState); });
+		
+		return stateTransitionMap.find(kfKey) == stateTransitionMap.end();
+	}
+	
 	auto iter = stateTransitionMap.find(kfKey);
+	
 	if (iter != stateTransitionMap.end())
 	{
 		//is an existing state, just update values
-		if (initialState.Q		!= 0)		{	procNoiseMap		[kfKey]	= initialState.Q;		}	
-		if (initialState.mu		!= 0)		{	gaussMarkovMuMap	[kfKey]	= initialState.mu;		}	
-		if (initialState.tau	!= 0)		{	gaussMarkovTauMap	[kfKey] = initialState.tau;		}
+		auto update = [&](map<KFKey, double>& paramMap, double value)
+		{
+			if (value == 0)
+			{
+				return;
+			}
+			
+			double& param = paramMap[kfKey];
+			if (param != value)
+			{
+				param = value;
+				
+				markTransitionDirty(kfKey);
+			}
+		};
+		
+		update(procNoiseMap,		initialState.Q);
+		update(gaussMarkovMuMap,	initialState.mu);
+		update(gaussMarkovTauMap,	initialState.tau);
 
 		return false;
 	}
 
 	//this is a new state, add to the state transition matrix to create a new state.
+	transitionStructureChanged = true;
 
 	KFKey ONE = {KF::ONE};
 	ZAdditionMap		[kfKey]			=  1;
@@ -309,274 +460,710 @@ void KFState::addNoiseElement(
 	ObsKey			obsKey,
 	double			variance)
 {
+	if (KFStateRequests::active_ptr)
+	{
+		KFStateRequests::active_ptr->requestList.push_back([=, this]{ addNoiseElement(obsKey, variance); });
+		return;
+	}
+	
 	noiseElementMap[obsKey]	= variance;
 }
 
-/** Add process noise and dynamics to filter object according to time gap.
- * This will also sort states according to their kfKey as a result of the way the state transition matrix is generated.
- */
-void KFState::stateTransition(
-	Trace&		trace,		///< Trace file for output
-	GTime		newTime)	///< Time of update for process noise and dynamics (s)
+/** Returns an identifier for the covariance group that a state belongs to.
+* States referencing a receiver are grouped per receiver, states referencing only a satellite are grouped per satellite, and the remainder are global.
+*/
+pair<int, int> covarianceGroupId(
+	const KFKey&	kfKey)	///< Key of the state to classify
 {
-	KFState& kfState = *this;
+	if (kfKey.str.empty() == false)		return {1, kfKey.str.id};
+	if (kfKey.Sat)						return {2, (int) kfKey.Sat};
+	else								return {0, 0};
+}
+
+/** Returns the dense id of the covariance group of a state, adding it to the forest if it has not been seen before
+*/
+int CovarianceBlocks::groupId(
+	const KFKey&	kfKey)	///< Key of the state to classify
+{
+	if (kfKey.type == KF::ONE)
+	{
+		//the ONE element carries no covariance, keep it out of the blocks so it doesnt couple everything together
+		return -1;
+	}
 	
-	double tgap = 0;
-	if	( newTime	!= GTime::noTime()
-		&&time		!= GTime::noTime())
+	auto [it, inserted] = groupIdMap.insert({covarianceGroupId(kfKey), groupIdMap.size()});
+	
+	if (inserted)
 	{
-		tgap = newTime - time;
+		parent.push_back(it->second);
 	}
 	
-	if	( newTime	!= GTime::noTime())
+	return it->second;
+}
+
+/** Returns the root group of the block that a group belongs to
+*/
+int CovarianceBlocks::findRoot(
+	int	group)		///< Dense id of group to find the block of
+{
+	while (parent[group] != group)
 	{
-		time = newTime;
+		parent[group]	= parent[parent[group]];
+		group			= parent[group];
 	}
 	
-//	TestStack ts(__FUNCTION__);
+	return group;
+}
 
-	int newStateCount = stateTransitionMap.size();
-	if (newStateCount == 0)
+/** Merge the blocks of two groups, as they may now be correlated
+*/
+void CovarianceBlocks::merge(
+	int	a,			///< Dense id of first group
+	int	b)			///< Dense id of second group
+{
+	if	( a < 0
+		||b < 0)
 	{
-		std::cout << "THIS IS WEIRD" << std::endl;
 		return;
 	}
+	
+	a = findRoot(a);
+	b = findRoot(b);
+	
+	if (a != b)
+		parent[b] = a;
+}
 
-	//Initialise and populate a state transition and Z transition matrix
-	SparseMatrix<double>	F_z		= SparseMatrix<double>	(newStateCount, x.rows());
-	SparseMatrix<double>	F		= SparseMatrix<double>	(newStateCount, x.rows());
-// 	MatrixXd			F		= MatrixXd::Zero(newStateCount, x.rows());
-	VectorXd			Z_plus	= VectorXd::Zero(newStateCount);
+/** Merge the blocks of all states referenced by a set of measurements.
+* A measurement update correlates every state that is correlated with a measured state, which are the states in the blocks of the measured states.
+*/
+void CovarianceBlocks::correlate(
+	const KFMeas&	kfMeas)		///< Measurements that have been used to update the filter
+{
+	if (known == false)
+	{
+		return;
+	}
 	
-	//add transitions for any states (usually close to identity)
-	int row = 0;
-	map<KFKey, short int> newKFIndexMap;
-	for (auto& [newStateKey, newStateMap] : stateTransitionMap)
+	int first = -1;
+	
+	auto touch = [&](int index)
 	{
-		newKFIndexMap[newStateKey] = row;
-
-		for (auto& [sourceStateKey, values] : newStateMap)
+		if (index >= stateGroups.size())
 		{
-			int sourceIndex	= getKFIndex(sourceStateKey);
-
-			if	( (sourceIndex < 0)
-				||(sourceIndex >= F.cols()))
-			{
-				continue;
-			}
-			auto& [value, tExp] = values;
-
-			double tau = -1;
-			
-			auto gmIter = gaussMarkovTauMap.find(sourceStateKey);
-			if (gmIter != gaussMarkovTauMap.end())
+			//the blocks dont describe these states, they will be found from the covariance matrix next time
+			known = false;
+			return;
+		}
+		
+		int group = stateGroups[index];
+		if (group < 0)
+		{
+			return;
+		}
+		
+		if (first < 0)	first = group;
+		else			merge(first, group);
+	};
+	
+	if (kfMeas.sparse)
+	{
+		for (int k = 0; k < kfMeas.H_sparse.outerSize(); ++k)
+		for (SparseMatrix<double, Eigen::RowMajor>::InnerIterator it(kfMeas.H_sparse, k); it; ++it)
+		{
+			touch(it.col());
+		}
+	}
+	else
+	{
+		for (int j = 0; j < kfMeas.H.cols(); j++)
+		{
+			if (kfMeas.H.col(j).isZero(0) == false)
 			{
-				auto& [dummy, sourceTau] = *gmIter;
-			
-				tau = sourceTau;
+				touch(j);
 			}
+		}
+	}
+}
 
-			double scalar = 1;
-			
-			if (tau < 0)
+/** Propagate the covariance matrix through the state transition one block at a time.
+* States are partitioned into blocks according to their covariance groups, the couplings present in the transition matrix, and the correlations tracked since the previous transition.
+* Each block is then transitioned independently using preallocated buffers, so the cost of the transition scales with the size of the blocks rather than the full state.
+* While the state vector is unchanged only the diagonal blocks of the covariance matrix are touched, as all other elements are known to be zero.
+* The covariance matrix is only searched for correlations when the blocks are not already known, eg after it has been modified outside of the filter.
+*/
+void blockCovarianceTransition(
+	SparseMatrix<double>&	F,				///< State transition matrix (new x old)
+	MatrixXd&				P,				///< Covariance of the old states, replaced with the covariance of the new states
+	VectorXd&				Q0,				///< Diagonal process noise for the new states
+	const KFIndexMap&		oldIndexMap,	///< Map from keys to indices of old states
+	const KFIndexMap&		newIndexMap,	///< Map from keys to indices of new states
+	CovarianceBlocks&		blocks)			///< Blocks of possibly correlated states, updated for the new states
+{
+	bool sameStates	=  F.rows() == F.cols()
+					&&(  &oldIndexMap == &newIndexMap
+					  || (const KFIndexMap::BaseMap&) oldIndexMap == (const KFIndexMap::BaseMap&) newIndexMap);
+	
+	auto& oldGroups = blocks.stateGroups;
+	auto& newGroups = blocks.newGroups;
+	
+	if	( blocks.known == false
+		||oldGroups.size() != F.cols())
+	{
+		blocks.known = false;
+		
+		oldGroups.assign(F.cols(), -1);
+		for (auto& [kfKey, index] : oldIndexMap)	if (index < oldGroups.size())	oldGroups[index] = blocks.groupId(kfKey);
+	}
+	
+	if (sameStates)
+	{
+		newGroups = oldGroups;
+	}
+	else
+	{
+		newGroups.assign(F.rows(), -1);
+		for (auto& [kfKey, index] : newIndexMap)	if (index < newGroups.size())	newGroups[index] = blocks.groupId(kfKey);
+	}
+	
+	//couplings from the transition matrix
+	for (int k = 0; k < F.outerSize(); ++k)
+	for (SparseMatrix<double>::InnerIterator it(F, k); it; ++it)
+	{
+		blocks.merge(newGroups[it.row()], oldGroups[it.col()]);
+	}
+	
+	int numGroups = blocks.parent.size();
+	
+	if (blocks.known == false)
+	{
+		//couplings from existing correlations, checked between pairs of groups that are not yet in the same block
+		vector<vector<int>> oldGroupIndices(numGroups);
+		for (int i = 0; i < oldGroups.size(); i++)	if (oldGroups[i] >= 0)	oldGroupIndices[oldGroups[i]].push_back(i);
+		
+		auto correlated = [&](vector<int>& indicesA, vector<int>& indicesB)
+		{
+			for (int j : indicesB)
+			for (int i : indicesA)
 			{
-				//Random Walk model (special case for First Order Gauss Markov model when tau == inf)
-			
-				for (int i = 0; i < tExp; i++)
+				if (P(i, j) != 0)
 				{
-					scalar *= tgap / (i+1);
+					return true;
 				}
-				
-// 				F(row, sourceIndex) = value * scalar;
-				F.insert(row, sourceIndex) = value * scalar;
-				
-				continue;
 			}
-			
-			//First Order Gauss Markov model, Ref: Carpenter and Lee (2008) - A Stable Clock Error Model Using Coupled First- and Second-Order Gauss-Markov Processes - https://ntrs.nasa.gov/api/citations/20080044877/downloads/20080044877.pdf
+			return false;
+		};
 		
-			double tempTerm = 1;
-			scalar = exp(-tgap/tau);
-			
-			for (int i = 0; i < tExp; i++)
+		for (int a = 0;		a < numGroups; a++)
+		for (int b = a + 1;	b < numGroups; b++)
+		{
+			if	( oldGroupIndices[a].empty()
+				||oldGroupIndices[b].empty())
 			{
-				scalar = tau * (tempTerm - scalar);	//recursive formula derived according to Ref: Carpenter and Lee (2008)
-				tempTerm *= tgap / (i+1);
+				continue;
 			}
 			
-			double transition = value * scalar;
-			
-// 			F(row, sourceIndex) = transition;
-			F.insert(row, sourceIndex) = transition;
-			
-			
-			//Add state transitions to ONE element, to allow for tiedown to average value mu
-			//derived from integrating and distributing terms for v = (v0 - mu) * exp(-t/tau) + mu;
-			//tempTerm calculated above appears to be same as required for these terms too, (at least for tExp = 0,1)
-			
-			auto muIter = gaussMarkovMuMap.find(sourceStateKey);
-			if (muIter != gaussMarkovMuMap.end())
+			if	( blocks.findRoot(a) != blocks.findRoot(b)
+				&&correlated(oldGroupIndices[a], oldGroupIndices[b]))
 			{
-				auto& [dummy2, mu] = *muIter;
-				
-// 				F(row, 0) = mu * (tempTerm - transition);
-				F.coeffRef(row, 0) = mu * (tempTerm - transition);
+				blocks.merge(a, b);
 			}
 		}
+	}
+
+	//collect the indices of each block
+	map<int, tuple<vector<int>, vector<int>>> blockIndicesMap;
+	
+	for (int i = 0; i < oldGroups.size(); i++)	if (oldGroups[i] >= 0)	std::get<0>(blockIndicesMap[blocks.findRoot(oldGroups[i])]).push_back(i);
+	for (int i = 0; i < newGroups.size(); i++)	if (newGroups[i] >= 0)	std::get<1>(blockIndicesMap[blocks.findRoot(newGroups[i])]).push_back(i);
+	
+	//grow the working buffers for the largest block if required, they are reused for all blocks and epochs
+	int maxOld = 0;
+	int maxNew = 0;
+	for (auto& [root, indices] : blockIndicesMap)
+	{
+		auto& [oldIndices, newIndices] = indices;
 		
-		row++;
+		maxOld = std::max(maxOld, (int) oldIndices.size());
+		maxNew = std::max(maxNew, (int) newIndices.size());
 	}
 	
-	for (auto& [kfKey1, map] : ZTransitionMap)
-	for (auto& [kfKey2, value] : map)
+	auto reserve = [](MatrixXd& buffer, int rows, int cols)
 	{
-		int index2	= getKFIndex(kfKey2);
+		if	( buffer.rows() < rows
+			||buffer.cols() < cols)
+		{
+			buffer.resize(std::max(rows, (int) buffer.rows()), std::max(cols, (int) buffer.cols()));
+		}
+	};
+	
+	reserve(blocks.Fbuf,	maxNew, maxOld);
+	reserve(blocks.Pbuf,	maxOld, maxOld);
+	reserve(blocks.FPbuf,	maxNew, maxOld);
+	reserve(blocks.FPFbuf,	maxNew, maxNew);
+	
+	auto& oldLocal = blocks.oldLocal;
+	if (oldLocal.size() < F.cols())
+	{
+		oldLocal.resize(F.cols(), -1);
+	}
 
-		if	( (index2 < 0)
-			||(index2 >= F.cols()))
+	//elements outside of the blocks are zero, when the states are unchanged they already are, otherwise a new matrix is required
+	MatrixXd	Pnew;
+	if (sameStates == false)
+	{
+		Pnew = MatrixXd::Zero(F.rows(), F.rows());
+	}
+	
+	MatrixXd&	Pp = sameStates ? P : Pnew;
+	
+	SparseMatrix<double, Eigen::RowMajor> Fr = F;
+	
+	for (auto& [root, indices] : blockIndicesMap)
+	{
+		auto& [oldIndices, newIndices] = indices;
+		
+		int numOld = oldIndices.size();
+		int numNew = newIndices.size();
+		
+		if (numNew == 0)
 		{
 			continue;
 		}
 		
-		auto it = newKFIndexMap.find(kfKey1);
-		if (it == newKFIndexMap.end())
+		for (int i = 0; i < numOld; i++)
+			oldLocal[oldIndices[i]] = i;
+		
+		auto Fb		= blocks.Fbuf	.topLeftCorner(numNew, numOld);
+		auto Pb		= blocks.Pbuf	.topLeftCorner(numOld, numOld);
+		auto FPb	= blocks.FPbuf	.topLeftCorner(numNew, numOld);
+		auto FPFb	= blocks.FPFbuf	.topLeftCorner(numNew, numNew);
+		
+		Fb.setZero();
+		
+		for (int i = 0; i < numNew; i++)
+		for (SparseMatrix<double, Eigen::RowMajor>::InnerIterator it(Fr, newIndices[i]); it; ++it)
 		{
-			std::cout << std::endl << "Bookkeeping error";
-			continue;
+			int local = oldLocal[it.col()];
+			if (local < 0)
+			{
+				//only the ONE element may be referenced from outside the block, and it has no covariance
+				continue;
+			}
+			
+			Fb(i, local) = it.value();
 		}
 		
-		auto& [dummy, row] = *it;
+		for (int j = 0; j < numOld; j++)
+		for (int i = 0; i < numOld; i++)
+		{
+			Pb(i, j) = P(oldIndices[i], oldIndices[j]);
+		}
+		
+		FPb	.noalias() = Fb		* Pb;
+		FPFb.noalias() = FPb	* Fb.transpose();
+		
+		//blocks are disjoint, so writing this block in place does not disturb any other
+		for (int j = 0; j < numNew; j++)
+		for (int i = 0; i < numNew; i++)
+		{
+			Pp(newIndices[i], newIndices[j]) = FPFb(i, j);
+		}
 		
-// 		F_z(row, index2) = value;
-		F_z.insert(row, index2) = value;
+		//restore the lookup for the next block
+		for (int i = 0; i < numOld; i++)
+			oldLocal[oldIndices[i]] = -1;
 	}
 	
+	Pp.diagonal() += Q0;
 	
-	for (auto& [kfKey, value] : ZAdditionMap)
+	if (sameStates == false)
 	{
-		int row = newKFIndexMap[kfKey];
-		
-		Z_plus(row) = value;
+		P = std::move(Pnew);
 	}
+	
+	std::swap(oldGroups, newGroups);
+	blocks.known = true;
+}
 
-	//scale and add process noise
-	MatrixXd Q0 = MatrixXd::Zero(newStateCount, newStateCount);
-	tgap = fabs(tgap);
+/** Compile the row of the state transition matrix, and the process noise, for a single state.
+* Results are stored in the compiled transition object for reuse in subsequent epochs.
+*/
+void KFState::compileTransitionRow(
+	const KFKey&			destKey,		///< Key of the state to compile
+	int						row,			///< Row of the state in the new state vector
+	double					tgap,			///< Time gap for process noise and dynamics (s)
+	const KFIndexMap&		newKFIndexMap)	///< Map from keys to indices in the new state vector
+{
+	auto& compiled	= compiledTransition;
+	auto& entries	= compiled.rowEntries[row];
+	
+	entries.clear();
+	compiled.Q0(row) = 0;
 
-	//add noise as 'process noise' as the method of initialising a state's variance
-	for (auto& [kfKey, value]	: initNoiseMap)
+	auto transIter = stateTransitionMap.find(destKey);
+	if (transIter == stateTransitionMap.end())
 	{
-		auto iter = newKFIndexMap.find(kfKey);
-		if (iter == newKFIndexMap.end())
+		return;
+	}
+	
+	auto& [dummy, newStateMap] = *transIter;
+	
+	//add transitions for the state (usually close to identity)
+	for (auto& [sourceStateKey, values] : newStateMap)
+	{
+		int sourceIndex	= getKFIndex(sourceStateKey);
+
+		if	( (sourceIndex < 0)
+			||(sourceIndex >= x.rows()))
 		{
-			std::cout << kfKey << " broke" << std::endl;
 			continue;
 		}
-		int index	= iter->second;
+		auto& [value, tExp] = values;
 
-		if	( (index < 0)
-			||(index >= Q0.rows()))
+		double tau = -1;
+		
+		auto gmIter = gaussMarkovTauMap.find(sourceStateKey);
+		if (gmIter != gaussMarkovTauMap.end())
 		{
-			continue;
+			auto& [dummy, sourceTau] = *gmIter;
+		
+			tau = sourceTau;
 		}
 
-		Q0(index, index) = value;
+		double scalar = 1;
+		
+		if (tau < 0)
+		{
+			//Random Walk model (special case for First Order Gauss Markov model when tau == inf)
+		
+			for (int i = 0; i < tExp; i++)
+			{
+				scalar *= tgap / (i+1);
+			}
+			
+			entries.push_back({sourceIndex, value * scalar});
+			
+			continue;
+		}
+		
+		//First Order Gauss Markov model, Ref: Carpenter and Lee (2008) - A Stable Clock Error Model Using Coupled First- and Second-Order Gauss-Markov Processes - https://ntrs.nasa.gov/api/citations/20080044877/downloads/20080044877.pdf
+	
+		double tempTerm = 1;
+		scalar = exp(-tgap/tau);
+		
+		for (int i = 0; i < tExp; i++)
+		{
+			scalar = tau * (tempTerm - scalar);	//recursive formula derived according to Ref: Carpenter and Lee (2008)
+			tempTerm *= tgap / (i+1);
+		}
+		
+		double transition = value * scalar;
+		
+		entries.push_back({sourceIndex, transition});
+		
+		
+		//Add state transitions to ONE element, to allow for tiedown to average value mu
+		//derived from integrating and distributing terms for v = (v0 - mu) * exp(-t/tau) + mu;
+		//tempTerm calculated above appears to be same as required for these terms too, (at least for tExp = 0,1)
+		
+		auto muIter = gaussMarkovMuMap.find(sourceStateKey);
+		if (muIter != gaussMarkovMuMap.end())
+		{
+			auto& [dummy2, mu] = *muIter;
+			
+			//replaces any existing ONE element, as per coeffRef in the original dense formulation
+			for (auto it = entries.begin(); it != entries.end(); )
+			{
+				if (std::get<0>(*it) == 0)	it = entries.erase(it);
+				else						it++;
+			}
+			
+			entries.push_back({0, mu * (tempTerm - transition)});
+		}
 	}
-
+	
 	//add time dependent process noise
-	if (tgap)
-	for (auto& [dest,	map]	: stateTransitionMap)
-	for (auto& [source,	vals]	: map)
+	if (tgap == 0)
 	{
-		auto& [val, tExp] = vals;
+		return;
+	}
 	
-		auto initIter = initNoiseMap.find(dest);
-		if (initIter != initNoiseMap.end())
+	auto initIter = initNoiseMap.find(destKey);
+	if (initIter != initNoiseMap.end())
+	{
+		//this was initialised this epoch
+		double init = initIter->second;
+
+		if (init == 0)
 		{
-			//this was initialised this epoch
-			double init = initIter->second;
+			//this was initialised with no noise, do lsq, dont add process noise
+			return;
+		}
+	}
+	
+	double dt = fabs(tgap);
+	
+	for (auto& [source,	vals]	: newStateMap)
+	{
+		auto& [val, tExp] = vals;
 
-			if (init == 0)
-			{
-				//this was initialised with no noise, do lsq, dont add process noise
-				continue;
-			}
+		auto sourceIter = newKFIndexMap.find(source);
+		if (sourceIter == newKFIndexMap.end())
+		{
+			std::cout << destKey << " broKe" << std::endl;
+			continue;
 		}
 
-		auto destIter = newKFIndexMap.find(dest);
-		if (destIter == newKFIndexMap.end())
+		auto iter2 = procNoiseMap.find(source);
+		if (iter2 == procNoiseMap.end())
 		{
-			std::cout << dest << " broke" << std::endl;
 			continue;
 		}
 		
-		int destIndex	= destIter->second;
-
-		if	( (destIndex < 0)
-			||(destIndex >= Q0.rows()))
+		auto [dummy, sourceProcessNoise] = *iter2;
+		
+		auto gmIter = gaussMarkovTauMap.find(source);
+		if (gmIter == gaussMarkovTauMap.end())
 		{
+			std::cout << "Tau value not found in filter: " << source << std::endl;
 			continue;
 		}
+		
+		auto& [dummy2, tau] = *gmIter;
+		
+		double& q = compiled.Q0(row);
 
-		auto sourceIter = newKFIndexMap.find(source);
-		if (sourceIter == newKFIndexMap.end())
+		if (tau < 0)
 		{
-			std::cout << dest << " broKe" << std::endl;
-			continue;
+			//Random Walk model (special case for First Order Gauss Markov model when tau == inf)
+			
+			if		(tExp == 0)	{	q += sourceProcessNoise / 1		* dt;						}
+			else if	(tExp == 1)	{	q += sourceProcessNoise / 3		* dt * dt * dt;				}
+			else if (tExp == 2)	{	q += sourceProcessNoise / 20	* dt * dt * dt * dt * dt;	}
 		}
+		else
+		{
+			//First Order Gauss Markov model, Ref: Carpenter and Lee (2008) - A Stable Clock Error Model Using Coupled First- and Second-Order Gauss-Markov Processes - https://ntrs.nasa.gov/api/citations/20080044877/downloads/20080044877.pdf
 		
-		int sourceIndex	= sourceIter->second;
+			if		(tExp == 0)	{	q += sourceProcessNoise / 2	* tau * (1 - exp(-2*dt/tau));		}
+			else if	(tExp == 1)	{	q += sourceProcessNoise / 2	* tau * tau * (	+ 2 * dt 								//one tau from front tau3 distributed to prevent divide by zero
+																				- 4 * tau * (1 - exp(-1*dt/tau)) 
+																				+ 1 * tau * (1 - exp(-2*dt/tau)));		//correct formula re-derived according to Ref: Carpenter and Lee (2008)
+								}
+			else if (tExp == 2)	{	std::cout << "FOGM model is not applied to acceleration term at the moment" << std::endl;	}
+		}
+	}
+}
 
-		if	( (sourceIndex < 0)
-			||(sourceIndex >= Q0.rows()))
+/** Compile all components of the state transition from the transition maps.
+* This is only required when states have been added or removed, or when the time gap changes, otherwise rows are patched individually.
+*/
+void KFState::compileTransition(
+	double					tgap,			///< Time gap for process noise and dynamics (s)
+	KFIndexMap&				newKFIndexMap)	///< Output map from keys to indices in the new state vector
+{
+	auto& compiled = compiledTransition;
+	
+	int newStateCount = stateTransitionMap.size();
+	
+	newKFIndexMap.clear();
+	
+	int row = 0;
+	for (auto& [newStateKey, newStateMap] : stateTransitionMap)
+	{
+		newKFIndexMap[newStateKey] = row;
+		row++;
+	}
+	
+	compiled.tgap	= tgap;
+	compiled.Q0		= VectorXd::Zero(newStateCount);
+	compiled.rowEntries		.assign(newStateCount,	{});
+	compiled.dependentRows	.assign(newStateCount,	{});
+	
+	for (auto& [newStateKey, row] : newKFIndexMap)
+	{
+		compileTransitionRow(newStateKey, row, tgap, newKFIndexMap);
+	}
+	
+	//add noise as 'process noise' as the method of initialising a state's variance
+	for (auto& [kfKey, value]	: initNoiseMap)
+	{
+		auto iter = newKFIndexMap.find(kfKey);
+		if (iter == newKFIndexMap.end())
 		{
+			std::cout << kfKey << " broke" << std::endl;
 			continue;
 		}
+		int index	= iter->second;
 
-		auto iter2 = procNoiseMap.find(source);
-		if (iter2 == procNoiseMap.end())
+		compiled.Q0(index) += value;
+	}
+	
+	//record which rows reference each (surviving) state so that changes to its parameters can be patched later
+	for (auto& [destKey, newStateMap]	: stateTransitionMap)
+	for (auto& [sourceKey, vals]		: newStateMap)
+	{
+		auto it = newKFIndexMap.find(sourceKey);
+		if (it == newKFIndexMap.end())
 		{
-// 			std::cout << dest << " brOke" << std::endl;
 			continue;
 		}
 		
-		auto [dummy, sourceProcessNoise] = *iter2;
+		compiled.dependentRows[it->second].push_back(newKFIndexMap[destKey]);
+	}
+	
+	//Z transition matrix only changes when states are added or removed
+	compiled.F_z = SparseMatrix<double>(newStateCount, x.rows());
+	
+	for (auto& [kfKey1, map] : ZTransitionMap)
+	for (auto& [kfKey2, value] : map)
+	{
+		int index2	= getKFIndex(kfKey2);
+
+		if	( (index2 < 0)
+			||(index2 >= x.rows()))
+		{
+			continue;
+		}
 		
-		auto gmIter = gaussMarkovTauMap.find(source);
-		if (gmIter != gaussMarkovTauMap.end())
+		auto it = newKFIndexMap.find(kfKey1);
+		if (it == newKFIndexMap.end())
 		{
-			auto& [dummy, tau] = *gmIter;
+			std::cout << std::endl << "Bookkeeping error";
+			continue;
+		}
+		
+		auto& [dummy, row] = *it;
+		
+		compiled.F_z.insert(row, index2) = value;
+	}
+}
 
-			if (tau < 0)
+/** Add process noise and dynamics to filter object according to time gap.
+ * This will also sort states according to their kfKey as a result of the way the state transition matrix is generated.
+ *
+ * The transition matrix and process noise are cached between epochs.
+ * If no states have been added or removed and the time gap is unchanged, only the rows of states whose parameters have changed are recalculated.
+ */
+void KFState::stateTransition(
+	Trace&		trace,		///< Trace file for output
+	GTime		newTime)	///< Time of update for process noise and dynamics (s)
+{
+	KFState& kfState = *this;
+	
+	double tgap = 0;
+	if	( newTime	!= GTime::noTime()
+		&&time		!= GTime::noTime())
+	{
+		tgap = newTime - time;
+	}
+	
+	if	( newTime	!= GTime::noTime())
+	{
+		time = newTime;
+	}
+	
+//	TestStack ts(__FUNCTION__);
+
+	int newStateCount = stateTransitionMap.size();
+	if (newStateCount == 0)
+	{
+		std::cout << "THIS IS WEIRD" << std::endl;
+		return;
+	}
+	
+	auto& compiled = compiledTransition;
+
+	bool fullCompile	=  compiled.valid == false
+						|| transitionStructureChanged
+						|| compiled.tgap		!= tgap
+						|| compiled.F.rows()	!= newStateCount
+						|| compiled.F.cols()	!= x.rows()
+						|| newStateCount		!= x.rows()
+						|| initNoiseMap.empty()	== false
+						|| ZAdditionMap.empty()	== false;
+	
+	KFIndexMap newKFIndexMap;
+	
+	if (fullCompile)
+	{
+		compileTransition(tgap, newKFIndexMap);
+	}
+	else if (transitionDirtyKeys.empty() == false)
+	{
+		//patch only the rows that are affected by changed parameters
+		map<int, bool> dirtyRows;
+		for (auto& [kfKey, dirty] : transitionDirtyKeys)
+		{
+			int index = getKFIndex(kfKey);
+			if (index < 0)
 			{
-				//Random Walk model (special case for First Order Gauss Markov model when tau == inf)
-				
-				if		(tExp == 0)	{	Q0(destIndex,	destIndex) += sourceProcessNoise / 1	* tgap;}
-				else if	(tExp == 1)	{	Q0(destIndex,	destIndex) += sourceProcessNoise / 3	* tgap * tgap * tgap;	
-		// 								Q0(sourceIndex, destIndex) += sourceProcessNoise / 2	* tgap * tgap;	
-		// 								Q0(destIndex, sourceIndex) += sourceProcessNoise / 2	* tgap * tgap; 
-									}
-				else if (tExp == 2)	{	Q0(destIndex,	destIndex) += sourceProcessNoise / 20	* tgap * tgap * tgap * tgap * tgap;}
+				continue;
 			}
-			else
+			
+			dirtyRows[index] = true;
+			
+			for (int row : compiled.dependentRows[index])
 			{
-				//First Order Gauss Markov model, Ref: Carpenter and Lee (2008) - A Stable Clock Error Model Using Coupled First- and Second-Order Gauss-Markov Processes - https://ntrs.nasa.gov/api/citations/20080044877/downloads/20080044877.pdf
+				dirtyRows[row] = true;
+			}
+		}
+		
+		auto it = kfIndexMap.begin();
+		int  currentRow = 0;
+		for (auto& [row, dirty] : dirtyRows)
+		{
+			std::advance(it, row - currentRow);
+			currentRow = row;
+			
+			auto& [kfKey, index] = *it;
 			
-				if		(tExp == 0)	{	Q0(destIndex,	destIndex) += sourceProcessNoise / 2	* tau * (1 - exp(-2*tgap/tau));		}
-				else if	(tExp == 1)	{	Q0(destIndex,	destIndex) += sourceProcessNoise / 2	* tau * tau * (	+ 2 * tgap 								//one tau from front tau3 distributed to prevent divide by zero
-																												- 4 * tau * (1 - exp(-1*tgap/tau)) 
-																												+ 1 * tau * (1 - exp(-2*tgap/tau)));	//correct formula re-derived according to Ref: Carpenter and Lee (2008)
-		// 								Q0(sourceIndex, destIndex) += sourceProcessNoise / 2	* tau * tau * (1-exp(-tgap/tau)) * (1-exp(-tgap/tau));
-		// 								Q0(destIndex, sourceIndex) += sourceProcessNoise / 2	* tau * tau * (1-exp(-tgap/tau)) * (1-exp(-tgap/tau));
-									}
-				else if (tExp == 2)	{	std::cout << "FOGM model is not applied to acceleration term at the moment" << std::endl;	}
+			compileTransitionRow(kfKey, row, tgap, kfIndexMap);
+			
+			//new sources may have been added to this row
+			for (auto& [col, value] : compiled.rowEntries[row])
+			{
+				auto& dependents = compiled.dependentRows[col];
+				
+				if (std::find(dependents.begin(), dependents.end(), row) == dependents.end())
+				{
+					dependents.push_back(row);
+				}
 			}
 		}
-		else
+	}
+	
+	if	( fullCompile
+		||transitionDirtyKeys.empty() == false)
+	{
+		vector<Triplet<double>> triplets;
+		for (int row = 0; row < compiled.rowEntries.size(); row++)
+		for (auto& [col, value] : compiled.rowEntries[row])
 		{
-			std::cout << "Tau value not found in filter: " << source << std::endl;
-			continue;
+			triplets.push_back({row, col, value});
 		}
+		
+		compiled.F = SparseMatrix<double>(newStateCount, x.rows());
+		compiled.F.setFromTriplets(triplets.begin(), triplets.end());
+	}
+	
+	compiled.valid				= true;
+	transitionStructureChanged	= false;
+	transitionDirtyKeys.clear();
+
+	auto& F		= compiled.F;
+	auto& F_z	= compiled.F_z;
+	auto& Q0	= compiled.Q0;
+	
+	VectorXd Z_plus = VectorXd::Zero(newStateCount);
+	
+	if (fullCompile)
+	for (auto& [kfKey, value] : ZAdditionMap)
+	{
+		int row = newKFIndexMap[kfKey];
+		
+		Z_plus(row) = value;
 	}
 
 	//output the state transition matrix to a trace file (used by RTS smoother)
@@ -615,19 +1202,27 @@ void KFState::stateTransition(
 	}
 	
 	{
-// 		Instrument	instrument("PPPalgebra1");
+		Instrument	instrument("PPPalgebra1");
 		Z = (F_z	* Z	* F_z.transpose()			).eval();
 	}
 	{
-// 		Instrument	instrument("PPPalgebra2");
+		Instrument	instrument("PPPalgebra2");
 		x = (Fx										).eval();
 	}
 	{
-// 		Instrument	instrument("PPPalgebra3");
-		P = (F		* P * F.transpose()		+ Q0	).eval();
+		Instrument	instrument("PPPalgebra3");
+		if (block_covariance)
+		{
+			blockCovarianceTransition(F, P, Q0, kfIndexMap, fullCompile ? newKFIndexMap : kfIndexMap, covarianceBlocks);
+		}
+		else
+		{
+			P = (F		* P * F.transpose()				).eval();
+			P.diagonal() += Q0;
+		}
 	}
 	{
-// 		Instrument	instrument("PPPalgebra4");
+		Instrument	instrument("PPPalgebra4");
 		Z += Z_plus.asDiagonal();
 	}
 // 	std::cout << "F_z" << std::endl << F_z << std::endl;
@@ -635,11 +1230,35 @@ void KFState::stateTransition(
 // 	std::cout << "Z" << std::endl << Z << std::endl;
 
 	//replace the index map with the updated version that corresponds to the updated state
-	kfIndexMap = std::move(newKFIndexMap);
+	if (fullCompile)
+	{
+		kfIndexMap = std::move(newKFIndexMap);
+	}
 	
 	initFilterEpoch();
 }
 
+/** Extract the design and noise matrices for a chunk of a sparse measurement object
+*/
+tuple<SparseMatrix<double, Eigen::RowMajor>, SparseMatrix<double>> sparseChunk(
+	KFMeas&			kfMeas,			///< Measurements, noise, and design matrix
+	int				begX,			///< Index of first state element to process
+	int				numX,			///< Number of states elements to process
+	int				begH,			///< Index of first measurement to process
+	int				numH)			///< Number of measurements to process
+{
+	if	( begX == 0 && numX == kfMeas.H_sparse.cols()
+		&&begH == 0 && numH == kfMeas.H_sparse.rows())
+	{
+		return {kfMeas.H_sparse, kfMeas.R_sparse};
+	}
+	
+	SparseMatrix<double, Eigen::RowMajor>	H = kfMeas.H_sparse.block(begH, begX, numH, numX);
+	SparseMatrix<double>					R = kfMeas.R_sparse.block(begH, begH, numH, numH);
+	
+	return {H, R};
+}
+
 /** Compare variances of measurements and pre-filtered states to detect unreasonable values
 * Ref: Wang et al. (1997) - On Quality Control in Hydrographic GPS Surveying
 * &  Wieser et al. (2004) - Failure Scenarios to be Considered with Kinematic High Precision Relative GNSS Positioning - http://citeseerx.ist.psu.edu/viewdoc/download?doi=10.1.1.573.9628&rep=rep1&type=pdf
@@ -656,42 +1275,58 @@ void KFState::preFitSigmaCheck(
 	int				numH)			///< Number of measurements to process
 {
 	auto		v = kfMeas.V.segment(begH, numH);
-	auto		R = kfMeas.R.block(begH, begH, numH, numH);
-	auto		H = kfMeas.H.block(begH, begX, numH, numX);
 	auto		P = this-> P.block(begX, begX, numX, numX);
 
 	ArrayXd		measRatios	= ArrayXd::Zero(numH);
 	ArrayXd		stateRatios	= ArrayXd::Zero(numX);
 
-	if (sigma_check)
+	auto calculateRatios = [&](auto& H, auto& R)
 	{
-		//use 'array' for component-wise calculations
-		auto		measVariations	= v.array().square();	//delta squared
-		auto		measVariances	= (R.diagonal() + (H * P * H.transpose()).diagonal()).array();
-	
-		measRatios	= measVariations	/ measVariances;
-		measRatios	= measRatios.isFinite()	.select(measRatios,		0);
+		if (sigma_check)
+		{
+			//use 'array' for component-wise calculations
+			auto		measVariations	= v.array().square();	//delta squared
+			VectorXd	HPHt_diag		= (H * P * H.transpose()).diagonal();
+			auto		measVariances	= (R.diagonal() + HPHt_diag).array();
+		
+			measRatios	= measVariations	/ measVariances;
+			measRatios	= measRatios.isFinite()	.select(measRatios,		0);
 
-		trace << std::endl << "DOING PRE SIGMA CHECK: ";
-	}
-	else if (w_test)
-	{
-		MatrixXd	Qinv	= (R + H * P * H.transpose()).inverse();
-		MatrixXd	H_Qinv	= H.transpose() * Qinv;
+			trace << std::endl << "DOING PRE SIGMA CHECK: ";
+		}
+		else if (w_test)
+		{
+			MatrixXd	Q		= H * P * H.transpose();
+						Q		+= R;
+			MatrixXd	Qinv	= Q.inverse();
+			MatrixXd	H_Qinv	= H.transpose() * Qinv;
+
+			//use 'array' for component-wise calculations
+			auto		measVariations	= (Qinv * v)	.array().square();
+			auto		stateVariations	= (H_Qinv * v)	.array().square();
 
-		//use 'array' for component-wise calculations
-		auto		measVariations	= (Qinv * v)	.array().square();
-		auto		stateVariations	= (H_Qinv * v)	.array().square();
+			auto		measVariances	=  Qinv			.diagonal().array();
+			auto		stateVariances	= (H_Qinv * H)	.diagonal().array();
+		
+			measRatios	= measVariations	/ measVariances;
+			measRatios	= measRatios.isFinite()	.select(measRatios,		0);	//set ratio to 0 if corresponding variance is 0, e.g. ONE state, clk rate states
+			stateRatios	= stateVariations	/ stateVariances;
+			stateRatios	= stateRatios.isFinite().select(stateRatios,	0);
 
-		auto		measVariances	=  Qinv			.diagonal().array();
-		auto		stateVariances	= (H_Qinv * H)	.diagonal().array();
+			trace << std::endl << "DOING W-TEST: ";
+		}
+	};
 	
-		measRatios	= measVariations	/ measVariances;
-		measRatios	= measRatios.isFinite()	.select(measRatios,		0);	//set ratio to 0 if corresponding variance is 0, e.g. ONE state, clk rate states
-		stateRatios	= stateVariations	/ stateVariances;
-		stateRatios	= stateRatios.isFinite().select(stateRatios,	0);
-
-		trace << std::endl << "DOING W-TEST: ";
+	if (kfMeas.sparse)
+	{
+		auto [H, R] = sparseChunk(kfMeas, begX, numX, begH, numH);
+		calculateRatios(H, R);
+	}
+	else
+	{
+		auto H = kfMeas.H.block(begH, begX, numH, numX);
+		auto R = kfMeas.R.block(begH, begH, numH, numH);
+		calculateRatios(H, R);
 	}
 
 	statistics.sumOfSquares	= measRatios.sum();
@@ -742,12 +1377,13 @@ void outputResiduals(
 	tracepdeex(2, trace, "#\t%2s\t%19s\t%8s\t%3s\t%7s\t%13s\t%13s\t%16s\n", "It", "Time", "Str", "Sat", "Type", "Prefit Res", "Postfit Res", "Meas Variance");
 	for (int i = begH; i < begH + numH; i++)
 	{
-		if (kfMeas.R(i,i) == 0)
+		double variance = kfMeas.measVariance(i);
+		if (variance == 0)
 		{
 			continue;
 		}
 		
-		tracepdeex(2, trace, "%%\t%2d\t%19s\t%20s\t%13.4f\t%13.4f\t%16.9f\n", iteration, kfMeas.time.to_string(0).c_str(), ((string)kfMeas.obsKeys[i]).c_str(), kfMeas.V(i), kfMeas.VV(i - begH), kfMeas.R(i,i));
+		tracepdeex(2, trace, "%%\t%2d\t%19s\t%20s\t%13.4f\t%13.4f\t%16.9f\n", iteration, kfMeas.time.to_string(0).c_str(), ((string)kfMeas.obsKeys[i]).c_str(), kfMeas.V(i), kfMeas.VV(i - begH), variance);
 	}
 	trace << "-RESIDUALS" << std::endl;
 }
@@ -768,17 +1404,27 @@ void KFState::postFitSigmaChecks(
 	int				begH,			///< Index of first measurement to process
 	int				numH)			///< Number of measurements to process
 {
-	auto						H	= kfMeas.H.block(begH, begX, numH, numX);
-	kfMeas.VV.segment(begH, numH)	= kfMeas.V.segment(begH, numH) - H * dx.segment(begX, numX);
+	VectorXd	measVariances;
+	if (kfMeas.sparse)
+	{
+		auto [H, R] = sparseChunk(kfMeas, begX, numX, begH, numH);
+		kfMeas.VV.segment(begH, numH)	= kfMeas.V.segment(begH, numH) - H * dx.segment(begX, numX);
+		measVariances					= R.diagonal();
+	}
+	else
+	{
+		auto						H	= kfMeas.H.block(begH, begX, numH, numX);
+		kfMeas.VV.segment(begH, numH)	= kfMeas.V.segment(begH, numH) - H * dx.segment(begX, numX);
+		measVariances					= kfMeas.R.block(begH, begH, numH, numH).diagonal();
+	}
 
 	//use 'array' for component-wise calculations
 	auto		measVariations		= kfMeas.VV	.segment(begH, numH).array().square();	//delta squared
 	auto		stateVariations		= dx		.segment(begX, numX).array().square();
 	
-	auto		measVariances		= kfMeas.	R.block(begH, begH, numH, numH).diagonal().array();
 	auto		stateVariances		= 			P.block(begX, begX, numX, numX).diagonal().array();
 	
-	ArrayXd		measRatios			= measVariations	/ measVariances;
+	ArrayXd		measRatios			= measVariations	/ measVariances.array();
 				measRatios			= measRatios.isFinite()	.select(measRatios,		0);	
 	ArrayXd		stateRatios			= stateVariations	/ stateVariances;
 				stateRatios			= stateRatios.isFinite().select(stateRatios,	0);	
@@ -788,11 +1434,6 @@ void KFState::postFitSigmaChecks(
 		outputResiduals(trace, kfMeas, iteration, begH, numH);
 	}
 	
-	if (acsConfig.output_mongo_measurements)
-	{
-		mongoMeasResiduals(kfMeas.time, kfMeas.obsKeys, kfMeas.V, kfMeas.VV, kfMeas.R, "", begH, numH);
-	}
-
 	trace << std::endl << "DOING SIGMACHECK: ";
 
 	statistics.sumOfSquares	= measRatios.sum();
@@ -875,11 +1516,24 @@ double KFState::measChiSquare(
 	int			numH)		///< Number of measurements to process
 {
 	auto		w = dx.segment(begX, numX);
-	auto		H = kfMeas.H.block(begH, begX, numH, numX);
-	VectorXd	v = kfMeas.V.segment(begH, numH) - H * w;
-	auto		R = kfMeas.R.block(begH, begH, numH, numH);
+	VectorXd	v;
+	VectorXd	variances;
+	
+	if (kfMeas.sparse)
+	{
+		auto [H, R] = sparseChunk(kfMeas, begX, numX, begH, numH);
+		v			= kfMeas.V.segment(begH, numH) - H * w;
+		variances	= R.diagonal();
+	}
+	else
+	{
+		auto H = kfMeas.H.block(begH, begX, numH, numX);
+		auto R = kfMeas.R.block(begH, begH, numH, numH);
+		v			= kfMeas.V.segment(begH, numH) - H * w;
+		variances	= R.diagonal();
+	}
 
-	double		chiSq = (v.array().square() / R.diagonal().array()).sum();
+	double		chiSq = (v.array().square() / variances.array()).sum();
 
 	trace << std::endl << "DOING MEASUREMENT CHI-SQUARE TEST:";
 	// for (int i = 0; i < numH; i++)	trace << "v(+): "	<< v(i) << "\tR: "		<< R(i, i) << std::endl;
@@ -897,11 +1551,22 @@ double KFState::innovChiSquare(
 	int			begH,		///< Index of first measurement to process
 	int			numH)		///< Number of measurements to process
 {
-	auto		H = kfMeas.H.block(begH, begX, numH, numX);
 	auto		v = kfMeas.V.segment(begH, numH);
-	auto		R = kfMeas.R.block(begH, begH, numH, numH);
 	auto		P = this->P.block(begX, begX, numX, numX);
-	MatrixXd	Q = R + H * P * H.transpose();
+	MatrixXd	Q;
+	
+	if (kfMeas.sparse)
+	{
+		auto [H, R] = sparseChunk(kfMeas, begX, numX, begH, numH);
+		Q	= H * P * H.transpose();
+		Q	+= R;
+	}
+	else
+	{
+		auto H = kfMeas.H.block(begH, begX, numH, numX);
+		auto R = kfMeas.R.block(begH, begH, numH, numH);
+		Q	= R + H * P * H.transpose();
+	}
 	
 	double		chiSq = v.transpose() * Q.inverse() * v;
 	
@@ -911,6 +1576,126 @@ double KFState::innovChiSquare(
 	return chiSq;
 }
 
+/** Kalman filter update processing one measurement at a time.
+* Only valid for uncorrelated measurements, but avoids forming and factorising the full innovation covariance matrix,
+* so the cost grows linearly rather than cubically with the number of measurements.
+*/
+int KFState::kFilterSequential(
+	Trace&			trace,		///< Trace to output to
+	KFMeas&			kfMeas,		///< Measurements, noise, and design matrices
+	VectorXd&		xp,   		///< Post-update state vector
+	MatrixXd&		Pp,   		///< Post-update covariance of states
+	VectorXd&		dx,			///< Post-update state innovation
+	int				begX,		///< Index of first state element to process
+	int				numX,		///< Number of state elements to process
+	int				begH,		///< Index of first measurement to process
+	int				numH)		///< Number of measurements to process
+{
+	auto& v = kfMeas.V;
+
+	VectorXd	dxc	= VectorXd::Zero(numX);
+	MatrixXd	Pc	= P.block(begX, begX, numX, numX);
+	VectorXd	Ph	= VectorXd::Zero(numX);
+	
+	vector<tuple<int, double>> designEntries;
+	
+	for (int i = begH; i < begH + numH; i++)
+	{
+		//collect the design entries for this measurement that are within this chunk
+		designEntries.clear();
+		
+		if (kfMeas.sparse)
+		{
+			for (SparseMatrix<double, Eigen::RowMajor>::InnerIterator it(kfMeas.H_sparse, i); it; ++it)
+			{
+				int col = it.col();
+				if	( col		>= begX
+					&&col		<  begX + numX
+					&&it.value()!= 0)
+				{
+					designEntries.push_back({col - begX, it.value()});
+				}
+			}
+		}
+		else
+		{
+			for (int j = 0; j < numX; j++)
+			{
+				double value = kfMeas.H(i, begX + j);
+				if (value)
+				{
+					designEntries.push_back({j, value});
+				}
+			}
+		}
+		
+		if (designEntries.empty())
+		{
+			continue;
+		}
+		
+		//innovation is relative to the updates from previous measurements
+		double innov = v(i);
+		
+		Ph.setZero();
+		for (auto& [j, value] : designEntries)
+		{
+			Ph		+= Pc.col(j) * value;
+			innov	-= dxc(j) * value;
+		}
+		
+		double S = kfMeas.measVariance(i);
+		for (auto& [j, value] : designEntries)
+		{
+			S		+= Ph(j) * value;
+		}
+		
+		if (S <= 0)
+		{
+			trace << std::endl << "Warning: non-positive innovation variance for " << kfMeas.obsKeys[i] << ", skipping";
+			continue;
+		}
+		
+		VectorXd K = Ph / S;
+		
+		dxc += K * innov;
+		
+		if (acsConfig.joseph_stabilisation)
+		{
+			//(I-KH)P(I-KH)' + KRK' expanded for a single measurement
+			Pc.noalias() -= K * Ph.transpose();
+			Pc.noalias() -= Ph * K.transpose();
+			Pc.noalias() += S * K * K.transpose();
+		}
+		else
+		{
+			Pc.noalias() -= K * Ph.transpose();
+		}
+	}
+	
+	dx.segment(begX, numX)	= dxc;
+	xp.segment(begX, numX)	= x. segment(begX, numX)
+							+ dx.segment(begX, numX);
+	
+	Pp.block(begX, begX, numX, numX) = (Pc + Pc.transpose()) / 2;
+
+	bool error = xp.segment(begX, numX).array().isNaN().any();
+	if (error)
+	{
+		std::cout << std::endl << "xp:" << std::endl << xp << std::endl;
+		std::cout << std::endl << "v :" << std::endl << v << std::endl;
+		std::cout << std::endl << "P :" << std::endl << P << std::endl;
+		std::cout << std::endl;
+		std::cout << "NAN found. Exiting...";
+		std::cout << std::endl;
+
+		exit(0);
+	}
+
+	bool pass = true;
+	return pass;
+}
+
 /** Kalman filter.
 */
 int KFState::kFilter(
@@ -924,23 +1709,53 @@ int KFState::kFilter(
 	int				begH,		///< Index of first measurement to process
 	int				numH)		///< Number of measurements to process
 {
-	auto& H = kfMeas.H;
-	auto& R = kfMeas.R;
+	if (inverter == E_Inverter::SEQUENTIAL)
+	{
+		bool diagonal;
+		if (kfMeas.sparse)	diagonal = kfMeas.diagonalNoise;
+		else				diagonal = kfMeas.R.block(begH, begH, numH, numH).isDiagonal(0);
+		
+		if (diagonal)
+		{
+			return kFilterSequential(trace, kfMeas, xp, Pp, dx, begX, numX, begH, numH);
+		}
+		
+		//correlated measurements cannot be processed independently, fall through to the full update
+	}
+	
 	auto& v = kfMeas.V;
 
-	auto subH = H.block(begH, begX, numH, numX);
+	MatrixXd HP;
+	MatrixXd Q;
 	
-	MatrixXd HP	= subH	* P.block(begX, begX, numX, numX);
-	MatrixXd Q	= HP	* subH.transpose();
+	if (kfMeas.sparse)
+	{
+		auto [subH, subR] = sparseChunk(kfMeas, begX, numX, begH, numH);
+		
+		HP	= subH	* P.block(begX, begX, numX, numX);
+		Q	= HP	* subH.transpose();
+
+		Q += subR;
+	}
+	else
+	{
+		auto subH = kfMeas.H.block(begH, begX, numH, numX);
+		
+		HP	= subH	* P.block(begX, begX, numX, numX);
+		Q	= HP	* subH.transpose();
 
-	Q += R.block(begH, begH, numH, numH);
+		Q += kfMeas.R.block(begH, begH, numH, numH);
+	}
 	
 	MatrixXd K;
 
+	//chunks may be filtered concurrently, so any fallback to another inverter only applies to this update
+	int chunkInverter = inverter;
+
 	bool repeat = true;
 	while (repeat)
 	{
-		switch (inverter)
+		switch (chunkInverter)
 		{
 			default:
 			case E_Inverter::LDLT:
@@ -979,14 +1794,14 @@ int KFState::kFilter(
 				solver.compute(QQ);
 				if (solver.info() != Eigen::ComputationInfo::Success)
 				{
-					inverter = E_Inverter::LDLT;
+					chunkInverter = E_Inverter::LDLT;
 					continue;
 				}
 
 				auto Kt = solver.solve(HP);
 				if (solver.info() != Eigen::ComputationInfo::Success)
 				{
-					inverter = E_Inverter::LDLT;
+					chunkInverter = E_Inverter::LDLT;
 					continue;
 				}
 
@@ -997,7 +1812,8 @@ int KFState::kFilter(
 			case E_Inverter::INV:
 			{
 				MatrixXd Qinv = Q.inverse();
-				K = P * H.transpose() * Qinv;
+				if (kfMeas.sparse)	K = P * kfMeas.H_sparse	.transpose() * Qinv;
+				else				K = P * kfMeas.H		.transpose() * Qinv;
 
 				break;
 			}
@@ -1020,8 +1836,18 @@ int KFState::kFilter(
 	
 	if (acsConfig.joseph_stabilisation)
 	{
-		MatrixXd IKH = MatrixXd::Identity(P.rows(), P.cols()) - K * H;
-		Pp = IKH * P * IKH.transpose() + K * R * K.transpose();
+		if (kfMeas.sparse)
+		{
+			MatrixXd IKH = MatrixXd::Identity(P.rows(), P.cols()) - K * kfMeas.H_sparse;
+			
+			if (kfMeas.diagonalNoise)	Pp = IKH * P * IKH.transpose() + K * kfMeas.R_sparse.diagonal().asDiagonal()	* K.transpose();
+			else						Pp = IKH * P * IKH.transpose() + K * kfMeas.R_sparse							* K.transpose();
+		}
+		else
+		{
+			MatrixXd IKH = MatrixXd::Identity(P.rows(), P.cols()) - K * kfMeas.H;
+			Pp = IKH * P * IKH.transpose() + K * kfMeas.R * K.transpose();
+		}
 	}
 	else
 	{
@@ -1036,7 +1862,8 @@ int KFState::kFilter(
 	if (error)
 	{
 		std::cout << std::endl << "xp:" << std::endl << xp << std::endl;
-		std::cout << std::endl << "R :" << std::endl << R << std::endl;
+		if (kfMeas.sparse)	std::cout << std::endl << "R :" << std::endl << kfMeas.R_sparse	<< std::endl;
+		else				std::cout << std::endl << "R :" << std::endl << kfMeas.R			<< std::endl;
 		std::cout << std::endl << "v :" << std::endl << v << std::endl;
 		std::cout << std::endl << "K :" << std::endl << K << std::endl;
 		std::cout << std::endl << "P :" << std::endl << P << std::endl;
@@ -1058,11 +1885,12 @@ bool KFState::chiQC(
 	KFMeas&		kfMeas,		///< Measurements, noise, and design matrix
 	VectorXd&	xp)         ///< Post filtered state vector
 {
-	auto& H = kfMeas.H;
 	auto W = kfMeas.W(all, 0);
 
 	VectorXd&	y		= kfMeas.Y;
-	VectorXd	v		= y - H * xp;
+	VectorXd	v;
+	if (kfMeas.sparse)	v = y - kfMeas.H_sparse	* xp;
+	else				v = y - kfMeas.H		* xp;
 	double		v_Wv	= v.transpose() * W.asDiagonal() * v;
 
 	//trace << std::endl << "chiqcV" << v.rows() << std::endl;	tracematpde(5, trace, v, 15, 5);
@@ -1089,10 +1917,28 @@ bool KFState::chiQC(
 	return true;
 }
 
+/** Returns true if a sparse matrix has no non-zero elements outside of its diagonal
+*/
+bool isSparseDiagonal(
+	SparseMatrix<double>&	matrix)		///< Matrix to check
+{
+	for (int k = 0; k < matrix.outerSize(); k++)
+	for (SparseMatrix<double>::InnerIterator it(matrix, k); it; ++it)
+	{
+		if	(  it.row()		!= it.col()
+			&& it.value()	!= 0)
+		{
+			return false;
+		}
+	}
+	
+	return true;
+}
+
 /** Combine a list of KFMeasEntrys into a single KFMeas object for used in the filter
 */
 KFMeas KFState::combineKFMeasList(
-	KFMeasEntryList&	kfEntryList,		///< List of input measurements as lists of entries
+	KFMeasEntryList		kfEntryList,		///< List of input measurements as lists of entries, copied so that its contents may be moved into the combined measurements
 	GTime				measTime,			///< Time to use for measurements and hence state transitions
 	MatrixXd*			noiseMatrix_ptr)	///< Optional pointer to use custom noise matrix	
 {
@@ -1111,8 +1957,20 @@ KFMeas KFState::combineKFMeasList(
 	kfMeas.VV	.resize(numMeas);
 	kfMeas.Y	.resize(numMeas);
 
-	kfMeas.R = MatrixXd::Zero(numMeas, numMeas);
-	kfMeas.H = MatrixXd::Zero(numMeas, x.rows());
+	kfMeas.sparse = sparse_measurements;
+	
+	vector<Triplet<double>> H_triplets;
+	
+	if (kfMeas.sparse == false)
+	{
+		kfMeas.R = MatrixXd::Zero(numMeas, numMeas);
+		kfMeas.H = MatrixXd::Zero(numMeas, x.rows());
+	}
+	else
+	{
+		kfMeas.R_sparse = SparseMatrix<double>(numMeas, numMeas);
+		kfMeas.R_sparse.reserve(Eigen::VectorXi::Ones(numMeas));
+	}
 
 	kfMeas.obsKeys			.resize(numMeas);
 	kfMeas.metaDataMaps		.resize(numMeas);
@@ -1121,7 +1979,8 @@ KFMeas KFState::combineKFMeasList(
 	int meas = 0;
 	for (auto& entry: kfEntryList)
 	{
-		kfMeas.R(meas, meas)	= entry.noise;
+		if (kfMeas.sparse)	kfMeas.R_sparse.insert(meas, meas)	= entry.noise;
+		else				kfMeas.R(meas, meas)				= entry.noise;
 		kfMeas.Y(meas)			= entry.value;
 		kfMeas.V(meas)			= entry.innov;
 
@@ -1133,7 +1992,9 @@ KFMeas KFState::combineKFMeasList(
 				std::cout << "hhuh?" << kfKey << std::endl;
 				return KFMeas();
 			}
-			kfMeas.H(meas, index) = value;
+			
+			if (kfMeas.sparse)	H_triplets.push_back({meas, index, value});
+			else				kfMeas.H(meas, index) = value;
 		}
 
 		kfMeas.obsKeys			[meas] = std::move(entry.obsKey);
@@ -1142,16 +2003,29 @@ KFMeas KFState::combineKFMeasList(
 		meas++;
 	}
 	
+	if (kfMeas.sparse)
+	{
+		kfMeas.H_sparse = SparseMatrix<double, Eigen::RowMajor>(numMeas, x.rows());
+		kfMeas.H_sparse.setFromTriplets(H_triplets.begin(), H_triplets.end());
+	}
+	
 	if (noiseMatrix_ptr)
 	{
-		kfMeas.R = *noiseMatrix_ptr;
+		if (kfMeas.sparse)
+		{
+			kfMeas.R_sparse			= noiseMatrix_ptr->sparseView();
+		}
+		else
+		{
+			kfMeas.R = *noiseMatrix_ptr;
+		}
 	}
 	
 	if (noiseElementMap.empty() == false)
 	{
 		VectorXd uncorrelatedNoise = VectorXd::Zero(noiseElementMap.size());
 		
-		map<ObsKey, int>	noiseIndexMap;
+		unordered_map<ObsKey, int>	noiseIndexMap;
 		int noises = 0;
 		for (auto& [obsKey, variance] : noiseElementMap)
 		{
@@ -1178,11 +2052,24 @@ KFMeas KFState::combineKFMeasList(
 		
 		Instrument instrument("PPPnoisELment");
 // 		std::cout << R_A << std::endl;
-		kfMeas.R = R_A * uncorrelatedNoise.asDiagonal() * R_A.transpose();
+		if (kfMeas.sparse)
+		{
+			kfMeas.R_sparse			= R_A * uncorrelatedNoise.asDiagonal() * R_A.transpose();
+		}
+		else
+		{
+			kfMeas.R = R_A * uncorrelatedNoise.asDiagonal() * R_A.transpose();
+		}
 		
 // 		std::cout << std::setprecision(5);
 // 		std::cout << "R" << std::endl << kfMeas.R << std::endl;
 	}
+	
+	if (kfMeas.sparse)
+	{
+		//noise matrices and noise elements only correlate measurements if they actually produce off-diagonal entries
+		kfMeas.diagonalNoise = isSparseDiagonal(kfMeas.R_sparse);
+	}
 
 	return kfMeas;
 }
@@ -1225,9 +2112,9 @@ bool KFState::doMeasRejectCallbacks(
 
 bool ObsKey::operator ==(const ObsKey& b) const
 {
-	if (str.compare(b.str)	!= 0)		return false;
+	if (str					!= b.str)	return false;
 	if (Sat					!= b.Sat)	return false;
-	if (type.compare(b.type)!= 0)		return false;
+	if (type				!= b.type)	return false;
 	if (num					!= b.num)	return false;
 	else								return true;
 }
@@ -1272,7 +2159,7 @@ int KFState::filterKalman(
 		spitFilterToFile(kfState, E_SerialObject::FILTER_MINUS, kfState.rts_basename + FORWARD_SUFFIX);
 	}
 
-	if (kfMeas.H.rows() == 0)
+	if (kfMeas.numMeas() == 0)
 	{
 		//nothing to be done, clean up and return early
 
@@ -1287,7 +2174,8 @@ int KFState::filterKalman(
 	/* kalman filter measurement update */
 	if (innovReady == false)
 	{
-		kfMeas.V	= kfMeas.Y - kfMeas.H * kfState.x;
+		if (kfMeas.sparse)	kfMeas.V	= kfMeas.Y - kfMeas.H_sparse	* kfState.x;
+		else				kfMeas.V	= kfMeas.Y - kfMeas.H			* kfState.x;
 		kfMeas.VV	= kfMeas.V;
 	}
 
@@ -1307,36 +2195,143 @@ int KFState::filterKalman(
 		filterChunkList.push_back(filterChunk);
 	}
 	
-	TestStatistics testStatistics;
+	//collect the chunks into a vector so that they may be processed in parallel, with outputs kept separately and merged in order afterwards
+	struct ChunkOutput
+	{
+		std::ostringstream	traceBuffer;
+		TestStatistics		testStatistics;
+		KFStatistics		statistics;
+		bool				failed			= false;
+		bool				active			= true;		///< Chunk has not yet passed its checks
+		KFKey				badState;						///< State that failed the latest check, whose reject callbacks are run once the chunks have been joined
+		int					badMeasIndex	= -1;			///< Measurement that failed the latest check, whose reject callbacks are run once the chunks have been joined
+	};
 	
+	vector<FilterChunk*> chunks;
 	for (auto& filterChunk : filterChunkList)
 	{
 		if (filterChunk.numX < 0)	filterChunk.numX = x.rows();
-		if (filterChunk.numH < 0)	filterChunk.numH = kfMeas.H.rows();
+		if (filterChunk.numH < 0)	filterChunk.numH = kfMeas.numMeas();
 		
-		KFStatistics statistics;
-		for (int i = 0; i < max_prefit_remv; i++)
+		chunks.push_back(&filterChunk);
+	}
+	
+	int numChunks = chunks.size();
+	
+	vector<ChunkOutput> chunkOutputs(numChunks);
+	
+	//joseph stabilisation updates the full covariance matrix, so chunks may not be processed concurrently
+	bool parallel	=  numChunks > 1
+					&& acsConfig.joseph_stabilisation == false;
+	
+	auto getChunkTrace = [&](int c) -> Trace&
+	{
+		if (parallel)	return chunkOutputs[c].traceBuffer;
+		else			return *chunks[c]->trace_ptr;
+	};
+	
+	auto flushChunkTraces = [&]()
+	{
+		if (parallel == false)
 		{
-			auto& chunkTrace = *filterChunk.trace_ptr;
-
-			if	(  sigma_check	== false
-				&& w_test		== false)	
+			return;
+		}
+		
+		for (int c = 0; c < numChunks; c++)
+		{
+			*chunks[c]->trace_ptr << chunkOutputs[c].traceBuffer.str();
+			chunkOutputs[c].traceBuffer.str("");
+		}
+	};
+	
+	auto anyActive = [&]()
+	{
+		for (auto& chunkOutput : chunkOutputs)
+		{
+			if (chunkOutput.active)
+			{
+				return true;
+			}
+		}
+		return false;
+	};
+	
+	//reject callbacks may modify the filter, and the measurements of other chunks, so chunks are checked in rounds.
+	//each round checks the active chunks in parallel, then runs the callbacks for any failures serially, in chunk order, after the chunks have been joined
+	auto doChunkRejectCallbacks = [&](
+		int				c,
+		const string&	checkName)
+	{
+		auto& chunkOutput	= chunkOutputs[c];
+		auto& chunkTrace	= *chunks[c]->trace_ptr;
+		
+		if (chunkOutput.badState.type)		{	chunkTrace << std::endl << checkName << " check failed state test";			kfState.doStateRejectCallbacks	(chunkTrace, kfMeas, chunkOutput.badState);			}	//always fallthrough
+		if (chunkOutput.badMeasIndex >= 0)	{	chunkTrace << std::endl << checkName << " check failed measurement test";	kfState.doMeasRejectCallbacks	(chunkTrace, kfMeas, chunkOutput.badMeasIndex);		}	//retry next iteration
+		else								{	chunkTrace << std::endl << checkName << " check passed";					chunkOutput.active = false;								}
+	};
+	
+	auto mongoChunkResiduals = [&](
+		int				c)
+	{
+		auto& filterChunk = *chunks[c];
+		
+		if (kfMeas.sparse)
+		{
+			MatrixXd R = kfMeas.R_sparse;
+			mongoMeasResiduals(kfMeas.time, kfMeas.obsKeys, kfMeas.V, kfMeas.VV, R,			"", filterChunk.begH, filterChunk.numH);
+		}
+		else
+		{
+			mongoMeasResiduals(kfMeas.time, kfMeas.obsKeys, kfMeas.V, kfMeas.VV, kfMeas.R,	"", filterChunk.begH, filterChunk.numH);
+		}
+	};
+	
+	TestStatistics testStatistics;
+	
+	if	(  sigma_check
+		|| w_test)
+	for (int i = 0; i < max_prefit_remv && anyActive(); i++)
+	{
+#		ifdef ENABLE_PARALLELISATION
+#			pragma omp parallel for if (parallel)
+#		endif
+		for (int c = 0; c < numChunks; c++)
+		{
+			auto& filterChunk	= *chunks[c];
+			auto& chunkOutput	= chunkOutputs[c];
+			
+			if (chunkOutput.active == false)
 			{
 				continue;
 			}
 			
-			KFKey	badState;
-			int		badMeasIndex = -1;
+			chunkOutput.badState		= KFKey();
+			chunkOutput.badMeasIndex	= -1;
 
-			kfState.preFitSigmaCheck(chunkTrace, kfMeas, badState, badMeasIndex, statistics, filterChunk.begX, filterChunk.numX, filterChunk.begH, filterChunk.numH);
-			
-			if (badState.type)		{	chunkTrace << std::endl << "Prefit check failed state test";		bool keepGoing = doStateRejectCallbacks	(chunkTrace, kfMeas, badState);			/*continue;*/	}	//always fallthrough
-			if (badMeasIndex >= 0)	{	chunkTrace << std::endl << "Prefit check failed measurement test";	bool keepGoing = doMeasRejectCallbacks	(chunkTrace, kfMeas, badMeasIndex);		continue;		}	//retry next iteration	
-			else					{	chunkTrace << std::endl << "Prefit check passed";																									break;			}
+			kfState.preFitSigmaCheck(getChunkTrace(c), kfMeas, chunkOutput.badState, chunkOutput.badMeasIndex, chunkOutput.statistics, filterChunk.begX, filterChunk.numX, filterChunk.begH, filterChunk.numH);
 		}
-
-		testStatistics.sumOfSquaresPre	+= statistics.sumOfSquares;
-		testStatistics.averageRatioPre	+= statistics.averageRatio / filterChunkList.size();
+		
+		flushChunkTraces();
+		
+		for (int c = 0; c < numChunks; c++)
+		{
+			if (chunkOutputs[c].active)
+			{
+				doChunkRejectCallbacks(c, "Prefit");
+			}
+		}
+	}
+	
+	for (auto& chunkOutput : chunkOutputs)
+	{
+		chunkOutput.testStatistics.sumOfSquaresPre	= chunkOutput.statistics.sumOfSquares;
+		chunkOutput.testStatistics.averageRatioPre	= chunkOutput.statistics.averageRatio;
+		
+		testStatistics.sumOfSquaresPre	+= chunkOutput.testStatistics.sumOfSquaresPre;
+		testStatistics.averageRatioPre	+= chunkOutput.testStatistics.averageRatioPre / numChunks;
+		
+		chunkOutput.statistics	= KFStatistics();
+		chunkOutput.active		= true;
 	}
 
 	if	(  sigma_check 
@@ -1349,19 +2344,30 @@ int KFState::filterKalman(
 	VectorXd xp = x;
 			 dx = VectorXd::Zero(x.rows());
 	
-	for (auto& filterChunk : filterChunkList)
+	for (int i = 0; i < max_filter_iter && anyActive(); i++)
 	{
-		KFStatistics statistics;
-		for (int i = 0; i < max_filter_iter; i++)
+#		ifdef ENABLE_PARALLELISATION
+#			pragma omp parallel for if (parallel)
+#		endif
+		for (int c = 0; c < numChunks; c++)
 		{
-			auto& chunkTrace = *filterChunk.trace_ptr;
+			auto& filterChunk	= *chunks[c];
+			auto& chunkOutput	= chunkOutputs[c];
+			auto& chunkTrace	= getChunkTrace(c);
+			
+			if (chunkOutput.active == false)
+			{
+				continue;
+			}
 			
 			bool pass = kfState.kFilter(chunkTrace, kfMeas, xp, Pp, dx, filterChunk.begX, filterChunk.numX, filterChunk.begH, filterChunk.numH);
 
 			if (pass == false)
 			{
 				chunkTrace << "FILTER FAILED" << std::endl;
-				return 0;
+				chunkOutput.failed = true;
+				chunkOutput.active = false;
+				continue;
 			}
 			
 // 			chunkTrace << "\nFrom " << filterChunk.begH << " for " << filterChunk.numH;
@@ -1373,18 +2379,47 @@ int KFState::filterKalman(
 				continue;
 			}
 
-			KFKey	badState;
-			int		badMeasIndex = -1;
+			chunkOutput.badState		= KFKey();
+			chunkOutput.badMeasIndex	= -1;
+			
+			kfState.postFitSigmaChecks(chunkTrace, kfMeas, xp, dx, i, chunkOutput.badState, chunkOutput.badMeasIndex, chunkOutput.statistics, filterChunk.begX, filterChunk.numX, filterChunk.begH, filterChunk.numH);
+		}
+		
+		flushChunkTraces();
+		
+		if (sigma_check == false)
+		{
+			continue;
+		}
+		
+		for (int c = 0; c < numChunks; c++)
+		{
+			if (chunkOutputs[c].active == false)
+			{
+				continue;
+			}
 			
-			kfState.postFitSigmaChecks(chunkTrace, kfMeas, xp, dx, i, badState, badMeasIndex, statistics, filterChunk.begX, filterChunk.numX, filterChunk.begH, filterChunk.numH);
+			if (acsConfig.output_mongo_measurements)
+			{
+				mongoChunkResiduals(c);
+			}
 			
-			if (badState.type)		{	chunkTrace << std::endl << "Postfit check failed state test";		bool keepGoing = doStateRejectCallbacks	(chunkTrace, kfMeas, badState);			/*continue;*/	}	//always fallthrough
-			if (badMeasIndex >= 0)	{	chunkTrace << std::endl << "Postfit check failed measurement test";	bool keepGoing = doMeasRejectCallbacks	(chunkTrace, kfMeas, badMeasIndex);		continue;		}	//retry next iteration	
-			else					{	chunkTrace << std::endl << "Postfit check passed";																									break;			}	//all ok, finish
+			doChunkRejectCallbacks(c, "Postfit");
 		}
-
-		testStatistics.sumOfSquaresPost	+= statistics.sumOfSquares;
-		testStatistics.averageRatioPost	+= statistics.averageRatio / filterChunkList.size();
+	}
+	
+	for (auto& chunkOutput : chunkOutputs)
+	{
+		if (chunkOutput.failed)
+		{
+			return 0;
+		}
+		
+		chunkOutput.testStatistics.sumOfSquaresPost	= chunkOutput.statistics.sumOfSquares;
+		chunkOutput.testStatistics.averageRatioPost	= chunkOutput.statistics.averageRatio;
+		
+		testStatistics.sumOfSquaresPost	+= chunkOutput.testStatistics.sumOfSquaresPost;
+		testStatistics.averageRatioPost	+= chunkOutput.testStatistics.averageRatioPost / numChunks;
 	}
 
 	if (sigma_check)	
@@ -1392,23 +2427,36 @@ int KFState::filterKalman(
 
 	if (chi_square_test)
 	{
-		for (auto& filterChunk : filterChunkList)
+#		ifdef ENABLE_PARALLELISATION
+#			pragma omp parallel for if (parallel)
+#		endif
+		for (int c = 0; c < numChunks; c++)
 		{
-			auto& chunkTrace = *filterChunk.trace_ptr;
+			auto& filterChunk	= *chunks[c];
+			auto& chunkTrace	= getChunkTrace(c);
+			
+			auto& chiSq			= chunkOutputs[c].testStatistics.chiSq;
 
 			switch (chi_square_mode)
 			{
-				case E_ChiSqMode::INNOVATION:	{	testStatistics.chiSq += kfState.innovChiSquare(chunkTrace, kfMeas,     filterChunk.begX, filterChunk.numX, filterChunk.begH, filterChunk.numH);	break;	}
-				case E_ChiSqMode::MEASUREMENT:	{	testStatistics.chiSq += kfState.measChiSquare( chunkTrace, kfMeas, dx, filterChunk.begX, filterChunk.numX, filterChunk.begH, filterChunk.numH);	break;	}
-				case E_ChiSqMode::STATE:		{	testStatistics.chiSq += kfState.stateChiSquare(chunkTrace, Pp,     dx, filterChunk.begX, filterChunk.numX, filterChunk.begH, filterChunk.numH);	break;	}
+				case E_ChiSqMode::INNOVATION:	{	chiSq = kfState.innovChiSquare(chunkTrace, kfMeas,     filterChunk.begX, filterChunk.numX, filterChunk.begH, filterChunk.numH);	break;	}
+				case E_ChiSqMode::MEASUREMENT:	{	chiSq = kfState.measChiSquare( chunkTrace, kfMeas, dx, filterChunk.begX, filterChunk.numX, filterChunk.begH, filterChunk.numH);	break;	}
+				case E_ChiSqMode::STATE:		{	chiSq = kfState.stateChiSquare(chunkTrace, Pp,     dx, filterChunk.begX, filterChunk.numX, filterChunk.begH, filterChunk.numH);	break;	}
 				default:							break;
 			}
 		}
+		
+		flushChunkTraces();
+		
+		for (auto& chunkOutput : chunkOutputs)
+		{
+			testStatistics.chiSq += chunkOutput.testStatistics.chiSq;
+		}
 
-		trace << std::endl << "Number of measurements:" << kfMeas.H.rows() << "\tNumber of states:" << kfState.x.rows() - 1;
+		trace << std::endl << "Number of measurements:" << kfMeas.numMeas() << "\tNumber of states:" << kfState.x.rows() - 1;
 
 		if (chi_square_mode == +E_ChiSqMode::STATE)	testStatistics.dof	= kfState.x.rows() - 1;
-		else										testStatistics.dof	= kfMeas. H.rows();
+		else										testStatistics.dof	= kfMeas.numMeas();
 
 		testStatistics.chiSqPerDof	= testStatistics.chiSq / testStatistics.dof;
 
@@ -1437,6 +2485,8 @@ int KFState::filterKalman(
 	{
 		kfState.x = std::move(xp);
 		kfState.P = std::move(Pp);
+		
+		kfState.covarianceBlocks.correlate(kfMeas);
 	}
 
 	if (kfState.rts_basename.empty() == false)
@@ -1459,6 +2509,9 @@ int KFState::filterLeastSquares(
 
 	trace << std::endl << " -------STARTING LS --------" << std::endl;
 
+	//least squares operates on dense matrices
+	kfMeas.makeDense();
+
 	//invert measurement noise matrix to get a weight matrix
 	kfMeas.W = (1 / kfMeas.R.diagonal().array()).matrix();		//todo, aaron straight inversion?
 
@@ -1530,6 +2583,11 @@ void KFState::leastSquareInitStates(
 	bool			innovReady)			///< Perform conversion between V & Y		
 {
 	chiQCPass = false;
+	
+	covarianceBlocks.correlate(kfMeas);
+
+	//least squares operates on dense matrices
+	kfMeas.makeDense();
 
 	if (innovReady)
 	{
@@ -1732,6 +2790,11 @@ void KFState::leastSquareInitStatesA(
 	bool			innovReady)			///< Perform conversion between V & Y		
 {
 	chiQCPass = false;
+	
+	covarianceBlocks.correlate(kfMeas);
+
+	//least squares operates on dense matrices
+	kfMeas.makeDense();
 
 	if (innovReady)
 	{
@@ -2065,15 +3128,19 @@ void KFState::outputMeasurements(
 		skip++;  
 	}
 	
+	int numStates;
+	if (meas.sparse)	numStates = meas.H_sparse	.cols();
+	else				numStates = meas.H			.cols();
+	
 	for (int i = 0; i < meas.obsKeys.size(); i++)
 	{
 		auto& key = meas.obsKeys[i];
 		
 		trace << std::endl << key << "  ";
 		
-		for (int j = 1; j < meas.H.cols(); j++)
+		for (int j = 1; j < numStates; j++)
 		{
-			double a = meas.H(i,j);
+			double a = meas.designEntry(i, j);
 			
 			if (fabs(a) > 0.001)		tracepdeex(2, trace, "%6.2f ", a);
 			else						tracepdeex(2, trace, "%6.2s ", "");		
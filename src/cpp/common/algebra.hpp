@@ -5,6 +5,7 @@
 #include "eigenIncluder.hpp"
 
 
+#include <functional>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -17,10 +18,13 @@
 using std::string;
 using std::vector;
 using std::tuple;
+using std::pair;
 using std::list;
 using std::hash;
 using std::map;
 
+#include "internedString.hpp"
+#include "flatHashIndex.hpp"
 #include "streamTrace.hpp"
 #include "satSys.hpp"
 #include "gTime.hpp"
@@ -33,12 +37,14 @@ struct Station;
 * These have parameters to separate states of different 'type', for different 'Sat's, with different receiver id 'str's and may have a different 'num' (eg xyz->0,1,2)
 *
 * Keys should be used rather than indices for accessing kalman filter state parameters.
+*
+* The receiver id is interned, so that comparisons for equality and hashing do not require string operations.
 */
 struct KFKey
 {
-	short int	type	= 0;			///< Key type (From enum)
-	SatSys		Sat		= {};			///< Satellite
-	string		str		= "";			///< String (receiver ID)
+	short int		type	= 0;		///< Key type (From enum)
+	SatSys			Sat		= {};		///< Satellite
+	InternedString	str		= {};		///< String (receiver ID)
 	short int 	num		= 0;			///< Subkey number (eg xyz => 0,1,2)
 	string		comment	= "";			///< Optional comment
 	Station*	rec_ptr	= 0;			///< Pointer to station object for dereferencing
@@ -56,10 +62,10 @@ struct KFKey
 
 struct ObsKey
 {
-	SatSys		Sat		= {};			///< Satellite
-	string		str		= "";			///< String (receiver ID)
-	string	 	type	= "";			///< Substring (eg LC12-P)
-	int 		num		= 0;
+	SatSys			Sat		= {};		///< Satellite
+	InternedString	str		= {};		///< String (receiver ID)
+	InternedString	type	= {};		///< Substring (eg LC12-P)
+	int 			num		= 0;
 
 	friend ostream& operator<<(ostream& os, const ObsKey& obsKey)
 	{
@@ -105,10 +111,10 @@ namespace std
 // 			if (key.station_ptr == nullptr)	str = "NO STREAM";
 // 			else 							str = key.station_ptr->id;
 
-			size_t hashval	= hash<string>	{}(key.str)		<< 0
-							^ hash<size_t>	{}(key.Sat) 	<< 1
-							^ hash<string>	{}(key.type) 	<< 2
-							^ hash<int>		{}(key.num) 	<< 3;
+			size_t hashval	= hash<int>		{}(key.str.id)	<< 0
+							^ hash<size_t>	{}(key.Sat) 	<< 8
+							^ hash<int>		{}(key.type.id)	<< 24
+							^ hash<int>		{}(key.num) 	<< 40;
 			return hashval;
 		}
 	};
@@ -122,15 +128,158 @@ namespace std
 		{
 			//create hashes of all parts and XOR them to get a complete hash
 
-			size_t hashval	= hash<string>	{}(key.str)		<< 0
-							^ hash<size_t>	{}(key.Sat) 	<< 1
-							^ hash<int>		{}(key.type) 	<< 2
-							^ hash<short>   {}(key.num) 	<< 3;
+			size_t hashval	= hash<int>		{}(key.str.id)	<< 0
+							^ hash<size_t>	{}(key.Sat) 	<< 16
+							^ hash<int>		{}(key.type) 	<< 32
+							^ hash<short>   {}(key.num) 	<< 48;
 			return hashval;
 		}
 	};
 }
 
+/** Map from keys to indices of parameters in the state vector.
+* Iteration is in key order, as required for building the state vector, while lookups use a flat hash index of the map's nodes.
+* The map is only accessible through the functions below, so that every modification keeps the hash index in step with its nodes.
+*/
+struct KFIndexMap
+{
+	typedef map<KFKey, short int>	BaseMap;
+	typedef BaseMap::iterator		iterator;
+	typedef BaseMap::const_iterator	const_iterator;
+	typedef BaseMap::value_type		value_type;
+
+private:
+	BaseMap										indexMap;
+	FlatHashIndex<iterator, KFKey>				hashIndex;
+
+	/** Rebuild the hash index from the contents of the map.
+	*/
+	void reindex()
+	{
+		hashIndex.clear();
+		hashIndex.reserve(indexMap.size());
+
+		for (auto it = indexMap.begin(); it != indexMap.end(); it++)
+		{
+			hashIndex.insert(it);
+		}
+	}
+
+public:
+	KFIndexMap()
+	{
+
+	}
+
+	//moving a map keeps its nodes, so the hash index remains valid and may be moved with it
+	KFIndexMap(const KFIndexMap&	other)	: indexMap(other.indexMap)												{	reindex();	}
+	KFIndexMap(KFIndexMap&&			other)	: indexMap(std::move(other.indexMap)),	hashIndex(std::move(other.hashIndex))	{	other.clear();	}
+	KFIndexMap(const BaseMap&		other)	: indexMap(other)														{	reindex();	}
+	KFIndexMap(BaseMap&&			other)	: indexMap(std::move(other))											{	reindex();	}
+
+	KFIndexMap& operator =	(const KFIndexMap&	other)	{	if (this != &other)	{	indexMap = other.indexMap;												reindex();		}	return *this;	}
+	KFIndexMap& operator =	(KFIndexMap&&		other)	{	if (this != &other)	{	indexMap = std::move(other.indexMap);	hashIndex = std::move(other.hashIndex);	other.clear();	}	return *this;	}
+	KFIndexMap& operator =	(const BaseMap&		other)	{							indexMap = other;														reindex();			return *this;	}
+	KFIndexMap& operator =	(BaseMap&&			other)	{							indexMap = std::move(other);											reindex();			return *this;	}
+
+	/** Read-only access to the underlying map
+	*/
+	operator const BaseMap&() const
+	{
+		return indexMap;
+	}
+
+	iterator		begin()				{	return indexMap.begin();	}
+	iterator		end()				{	return indexMap.end();		}
+	const_iterator	begin()		const	{	return indexMap.begin();	}
+	const_iterator	end()		const	{	return indexMap.end();		}
+	size_t			size()		const	{	return indexMap.size();		}
+	bool			empty()		const	{	return indexMap.empty();	}
+
+	iterator find(const KFKey& key)
+	{
+		auto it_ptr = hashIndex.find(key);
+		if (it_ptr == nullptr)		return indexMap.end();
+		else						return *it_ptr;
+	}
+
+	const_iterator find(const KFKey& key) const
+	{
+		auto it_ptr = hashIndex.find(key);
+		if (it_ptr == nullptr)		return indexMap.end();
+		else						return *it_ptr;
+	}
+
+	size_t count(const KFKey& key) const
+	{
+		return hashIndex.find(key) != nullptr;
+	}
+
+	short int& operator [](const KFKey& key)
+	{
+		auto it_ptr = hashIndex.find(key);
+		if (it_ptr)
+		{
+			return (*it_ptr)->second;
+		}
+
+		auto [it, inserted] = indexMap.insert({key, 0});
+		hashIndex.insert(it);
+
+		return it->second;
+	}
+
+	std::pair<iterator, bool> insert(const value_type& value)
+	{
+		auto it_ptr = hashIndex.find(value.first);
+		if (it_ptr)
+		{
+			return {*it_ptr, false};
+		}
+
+		auto result = indexMap.insert(value);
+		hashIndex.insert(result.first);
+
+		return result;
+	}
+
+	template<typename... ARGS>
+	std::pair<iterator, bool> emplace(ARGS&&... args)
+	{
+		return insert(value_type(std::forward<ARGS>(args)...));
+	}
+
+	size_t erase(const KFKey& key)
+	{
+		size_t erased = indexMap.erase(key);
+		if (erased)
+		{
+			reindex();
+		}
+		return erased;
+	}
+
+	iterator erase(const_iterator it)
+	{
+		auto next = indexMap.erase(it);
+		reindex();
+		return next;
+	}
+
+	void clear()
+	{
+		indexMap.clear();
+		hashIndex.clear();
+	}
+
+	void swap(KFIndexMap& other)
+	{
+		//swapping maps keeps their nodes, so the indices follow them
+		std::swap(indexMap,		other.indexMap);
+		std::swap(hashIndex,	other.hashIndex);
+	}
+};
+
 struct FilterChunk
 {
 	Trace*	trace_ptr = nullptr;
@@ -161,10 +310,82 @@ struct KFMeas
 	VectorXd	W;							///< Weight (inverse of noise) used in least squares
 	MatrixXd	H;							///< Design matrix between measurements and state
 
+	bool								sparse			= false;	///< Design and noise matrices are held in H_sparse and R_sparse, H and R are empty until makeDense() is called
+	bool								diagonalNoise	= false;	///< Sparse noise matrix has no off-diagonal elements
+	SparseMatrix<double, Eigen::RowMajor>	H_sparse;					///< Design matrix in compressed row format
+	SparseMatrix<double>				R_sparse;					///< Measurement noise in compressed column format
+
 	vector<ObsKey>								obsKeys;					///< Optional labels for reporting when measurements are removed etc.
 	vector<map<string, void*>>					metaDataMaps;
 	vector<list<tuple<string, double, string>>>	componentLists;	
 	
+	/** Number of measurements, regardless of the representation of the design matrix
+	*/
+	int numMeas() const
+	{
+		if (sparse)		return H_sparse	.rows();
+		else			return H		.rows();
+	}
+	
+	/** Variance of a single measurement
+	*/
+	double measVariance(
+		int index) const
+	{
+		if (sparse)		return R_sparse	.coeff(index, index);
+		else			return R		(index, index);
+	}
+	
+	/** Design matrix entry between a measurement and a state
+	*/
+	double designEntry(
+		int index,
+		int stateIndex) const
+	{
+		if (sparse)		return H_sparse	.coeff(index, stateIndex);
+		else			return H		(index, stateIndex);
+	}
+	
+	/** Scale the row and column of the noise matrix corresponding to a measurement
+	*/
+	void scaleNoise(
+		int		index,
+		double	factor)
+	{
+		if (sparse == false)
+		{
+			R.row(index) *= factor;
+			R.col(index) *= factor;
+			
+			return;
+		}
+		
+		for (int k = 0; k < R_sparse.outerSize(); k++)
+		for (SparseMatrix<double>::InnerIterator it(R_sparse, k); it; ++it)
+		{
+			if (it.row() == index)		it.valueRef() *= factor;
+			if (it.col() == index)		it.valueRef() *= factor;
+		}
+	}
+	
+	/** Convert the sparse design and noise matrices to dense form, for callers that require H and R directly
+	*/
+	void makeDense()
+	{
+		if (sparse == false)
+		{
+			return;
+		}
+		
+		H = MatrixXd(H_sparse);
+		R = MatrixXd(R_sparse);
+		
+		H_sparse	.resize(0, 0);
+		R_sparse	.resize(0, 0);
+		sparse			= false;
+		diagonalNoise	= false;
+	}
+	
 	void removeMeas(int index)
 	{
 		vector<int> keepIndices;
@@ -182,6 +403,24 @@ struct KFMeas
 		Y	= ( Y	(keepIndices)				).eval();
 		V	= ( V	(keepIndices)				).eval();
 		VV	= ( VV	(keepIndices)				).eval();
+		
+		if (sparse)
+		{
+			//select remaining rows using a sparse selection matrix to avoid densifying
+			SparseMatrix<double> S(keepIndices.size(), H_sparse.rows());
+			S.reserve(keepIndices.size());
+			
+			for (int i = 0; i < keepIndices.size(); i++)
+			{
+				S.insert(i, keepIndices[i]) = 1;
+			}
+			
+			H_sparse	= S * H_sparse;
+			R_sparse	= S * R_sparse * S.transpose();
+			
+			return;
+		}
+		
 		R	= ( R	(keepIndices, keepIndices)	).eval();
 		H	= ( H	(keepIndices, all)			).eval();
 	}
@@ -220,6 +459,86 @@ typedef bool (*MeasRejectCallback)	(Trace& trace, KFState& kfState, KFMeas& meas
 
 struct KFStatistics;
 
+/** Cached components of the state transition, reused between epochs while the structure of the filter is unchanged.
+*/
+struct CompiledTransition
+{
+	bool								valid	= false;	///< Cache has been populated and corresponds to the current state vector
+	double								tgap	= 0;		///< Time gap that the cached values were computed for
+	SparseMatrix<double>				F;					///< State transition matrix
+	SparseMatrix<double>				F_z;				///< Z transition matrix
+	VectorXd							Q0;					///< Diagonal of the process noise matrix
+	vector<vector<tuple<int, double>>>	rowEntries;			///< Column indices and values of the transition matrix for each row
+	vector<vector<int>>					dependentRows;		///< Rows of the transition matrix that reference each state as a source
+};
+
+/** Blocks of possibly correlated states, tracked as the filter is transitioned and updated with measurements.
+* States are assigned to covariance groups (per receiver, per satellite, or global), and groups are merged whenever the transition or a measurement couples them,
+* so that the covariance may be transitioned block by block without searching it for correlations.
+*/
+struct CovarianceBlocks
+{
+	bool						known		= false;	///< Blocks describe the current covariance matrix, otherwise the matrix must be searched for correlations
+	map<pair<int, int>, int>	groupIdMap;				///< Dense ids of the covariance groups that have been seen
+	vector<int>					parent;					///< Union-find forest over group ids, groups in the same tree may be correlated
+	vector<int>					stateGroups;			///< Group id of each state in the current state vector, or -1 for states without covariance
+
+	vector<int>					newGroups;				///< Working buffer for the groups of the transitioned states
+	vector<int>					oldLocal;				///< Working buffer mapping state indices to indices within a block
+	MatrixXd					Fbuf;					///< Working buffer for the transition of a block
+	MatrixXd					Pbuf;					///< Working buffer for the old covariance of a block
+	MatrixXd					FPbuf;					///< Working buffer for intermediate products of a block
+	MatrixXd					FPFbuf;					///< Working buffer for the new covariance of a block
+
+	int		groupId(
+		const KFKey&	kfKey);
+
+	int		findRoot(
+		int				group);
+
+	void	merge(
+		int				a,
+		int				b);
+
+	void	correlate(
+		const KFMeas&	kfMeas);
+};
+
+/** Modifications to the structure of a filter that have been requested while measurements are being constructed in parallel.
+* Requests are recorded in order by the thread constructing them, and are applied to the filter later by a single thread,
+* so that the filter is not modified concurrently, and the result does not depend on the scheduling of threads.
+*/
+struct KFStateRequests
+{
+	list<std::function<void()>>				requestList;	///< Deferred modifications, in the order they were requested
+
+	static thread_local KFStateRequests*	active_ptr;		///< Buffer that requests from this thread are redirected to, if any
+
+	void apply();
+
+	static void applyInOrder(
+		vector<KFStateRequests>&	requestsList);
+};
+
+/** Redirects structural modifications of all filters made by this thread into a request buffer for the lifetime of this object
+*/
+struct DeferStateRequests
+{
+	KFStateRequests*	previous_ptr;
+
+	DeferStateRequests(
+		KFStateRequests&	requests)
+	{
+		previous_ptr					= KFStateRequests::active_ptr;
+		KFStateRequests::active_ptr		= &requests;
+	}
+
+	~DeferStateRequests()
+	{
+		KFStateRequests::active_ptr		= previous_ptr;
+	}
+};
+
 /** Kalman filter object.
 *
 * Contains most persistant parameters and values of state. Includes state vector, covariance, and process noise.
@@ -236,7 +555,7 @@ struct KFState
 	MatrixXd	P;										///< State Covariance
 	VectorXd	dx;										///< Last filter update
 
-	map<KFKey, short int>						kfIndexMap;			///< Map from key to indexes of parameters in the state vector
+	KFIndexMap									kfIndexMap;			///< Map from key to indexes of parameters in the state vector
 
 	map<KFKey, map<KFKey, double>>				ZTransitionMap;
 	map<KFKey, double>							ZAdditionMap;
@@ -246,6 +565,11 @@ struct KFState
 	map<KFKey, double>							procNoiseMap;
 	map<KFKey, double>							initNoiseMap;
 	map<ObsKey, double>							noiseElementMap;
+	
+	CompiledTransition							compiledTransition;					///< Transition components from the previous epoch
+	map<KFKey, bool>							transitionDirtyKeys;				///< States whose transition parameters have changed since the transition was compiled
+	bool										transitionStructureChanged	= true;	///< States have been added or removed since the transition was compiled
+	CovarianceBlocks							covarianceBlocks;					///< Blocks of possibly correlated states, for block_covariance transitions
 
 	list<StateRejectCallback> 					stateRejectCallbacks;
 	list<MeasRejectCallback> 					measRejectCallbacks;
@@ -273,6 +597,9 @@ struct KFState
 	bool		output_residuals		= false;
 
 	int			inverter				= E_Inverter::INV;
+	
+	bool		block_covariance		= false;				///< Transition the covariance matrix as independent blocks of uncorrelated states
+	bool		sparse_measurements		= false;				///< Assemble measurement design and noise matrices in sparse form
 
 	KFState()
 	{
@@ -291,6 +618,9 @@ struct KFState
 
 	void	initFilterEpoch();
 
+	void	snapshot(
+		const KFState&	source);
+
 	int		getKFIndex(
 		KFKey		key);
 
@@ -335,6 +665,19 @@ struct KFState
 	void	removeState(
 		KFKey kfKey);
 
+	void	markTransitionDirty(
+		const KFKey&	kfKey);
+
+	void	compileTransitionRow(
+		const KFKey&			destKey,
+		int						row,
+		double					tgap,
+		const KFIndexMap&		newKFIndexMap);
+
+	void	compileTransition(
+		double					tgap,
+		KFIndexMap&				newKFIndexMap);
+
 	void	stateTransition(
 		Trace&		trace,
 		GTime		newTime);
@@ -401,6 +744,17 @@ struct KFState
 		int				begH	=  0,
 		int				numH	= -1);
 
+	int	kFilterSequential(
+		Trace&			trace,	
+		KFMeas&			kfMeas,	
+		VectorXd&		xp,   	
+		MatrixXd&		Pp,   	
+		VectorXd&		dx,		
+		int				begX,
+		int				numX,
+		int				begH,
+		int				numH);
+
 	bool		chiQC(
 		Trace&		trace,
 		KFMeas&		kfMeas,
@@ -454,7 +808,7 @@ struct KFState
 		bool			innovReady	= false);
 
 	KFMeas	combineKFMeasList(
-		KFMeasEntryList&	kfEntryList,
+		KFMeasEntryList		kfEntryList,
 		GTime				measTime = GTime::noTime(),
 		MatrixXd*			noiseMatrix_ptr = nullptr);
 
@@ -1,6 +1,8 @@
 
 #include <iostream>
 #include <fstream>
+#include <cstring>
+#include <mutex>
 #include <map>
 
 using std::map;
@@ -19,48 +21,123 @@ using std::map;
 #include <boost/serialization/binary_object.hpp>
 #include <boost/serialization/map.hpp>
 #include <boost/serialization/string.hpp>
+#include <boost/filesystem.hpp>
 
-/** Returns the type of object that is located at the specified position in a file
+/** Open output streams for archive files, which are kept open between records.
+ * Nodes of maps are never relocated, so references to the streams remain valid while other files are opened
 */
-E_SerialObject getFilterTypeFromFile(
-	long int& startPos,	///< Position of object
-	string filename)	///< Path to archive file
+static map<string, std::ofstream>	archiveStreamMap;
+static std::mutex					archiveStreamMutex;
+
+/** Returns the stream for appending to an archive file, opening it if required
+*/
+std::ofstream& getArchiveStream(
+	const string&	filename)	///< Path to archive file
 {
-	std::fstream fileStream(filename, std::ifstream::binary | std::ifstream::in);
+	std::lock_guard<std::mutex> guard(archiveStreamMutex);
 
-	if (!fileStream)
+	auto it = archiveStreamMap.find(filename);
+	if (it != archiveStreamMap.end())
 	{
-		return E_SerialObject::NONE;
+		auto& [dummy, fileStream] = *it;
+		return fileStream;
 	}
 
-	binary_iarchive serial(fileStream, 1); //no header
+	auto& fileStream = archiveStreamMap[filename];
+
+	fileStream.open(filename, std::ofstream::binary | std::ofstream::out | std::ofstream::app);
+
+	return fileStream;
+}
+
+/** Flush and close the stream for an archive file, if it is open
+*/
+void closeArchiveStream(
+	const string&	filename)	///< Path to archive file
+{
+	std::lock_guard<std::mutex> guard(archiveStreamMutex);
+
+	archiveStreamMap.erase(filename);
+}
+
+ArchiveReverseReader::ArchiveReverseReader(
+	const string&	filename)	///< Path to archive file
+{
+	boost::system::error_code ec;
+	auto fileSize = boost::filesystem::file_size(filename, ec);
+
+	if	( ec
+		||fileSize == 0)
+	{
+		return;
+	}
+
+	mappedFile.open(filename);
+}
+
+/** Find the extent of the record preceding the current position, using its trailing length
+*/
+bool ArchiveReverseReader::getRecordPosition(
+	long int&	itemPosition,		///< Position of the start of the record
+	long int&	itemEnd)			///< Position of the end of the record, (before its length)
+{
+	if (mappedFile.is_open() == false)
+	{
+		return false;
+	}
+
+	long int fileSize = mappedFile.size();
 
 	long int itemDelta;
 
-	fileStream.seekg (0, fileStream.end);
-	long int fileSize = fileStream.tellg();
+	itemEnd = startPos;
+	if (startPos < 0)
+	{
+		itemEnd = fileSize;
+	}
 
-	if (startPos < 0)	{	fileStream.seekg(			-sizeof(itemDelta),	fileStream.end);	}
-	else				{	fileStream.seekg(startPos	-sizeof(itemDelta),	fileStream.beg);	}
+	itemEnd -= sizeof(itemDelta);
 
-	long int currentPosition = fileStream.tellg();
-	if	( (currentPosition >= fileSize)
-		||(currentPosition <  0))
+	if	( itemEnd >= fileSize
+		||itemEnd <  0)
 	{
-		return E_SerialObject::NONE;
+		return false;
 	}
 
-	serialize(serial, itemDelta);
+	memcpy(&itemDelta, mappedFile.data() + itemEnd, sizeof(itemDelta));
+
+	itemPosition = itemEnd - itemDelta;
+
+	if	( itemPosition < 0
+		||itemPosition > itemEnd - (long int) sizeof(int))
+	{
+		return false;
+	}
 
-	long int itemPosition = currentPosition - itemDelta;
+	return true;
+}
 
-	fileStream.seekg(itemPosition, fileStream.beg);
+/** Returns the type of the object preceding the current position in the file
+*/
+E_SerialObject ArchiveReverseReader::nextType()
+{
+	long int itemPosition;
+	long int itemEnd;
+	bool pass = getRecordPosition(itemPosition, itemEnd);
+	if (pass == false)
+	{
+		return E_SerialObject::NONE;
+	}
 
 	int type_int;
-	serialize(serial, type_int);
-	E_SerialObject type = E_SerialObject::_from_integral(type_int);
+	memcpy(&type_int, mappedFile.data() + itemPosition, sizeof(type_int));
+
+	if (E_SerialObject::_is_valid(type_int) == false)
+	{
+		return E_SerialObject::NONE;
+	}
 
-	return type;
+	return E_SerialObject::_from_integral(type_int);
 }
 
 void outputPersistanceNav()
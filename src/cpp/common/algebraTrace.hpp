@@ -15,10 +15,14 @@ using std::map;
 
 #include <boost/archive/binary_iarchive.hpp>
 #include <boost/archive/binary_oarchive.hpp>
+#include <boost/serialization/array_wrapper.hpp>
 #include <boost/serialization/binary_object.hpp>
 #include <boost/serialization/map.hpp>
 #include <boost/serialization/string.hpp>
 #include <boost/serialization/vector.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/stream.hpp>
 
 #include "navigation.hpp"
 #include "algebra.hpp"
@@ -63,9 +67,10 @@ namespace boost::serialization
 
 		vec.resize(rows);
 
-		for (int row = 0; row < vec.rows(); row++)
+		//written as a single contiguous block
+		if (rows > 0)
 		{
-			ar & vec(row);
+			ar & make_array(vec.data(), rows);
 		}
 	}
 
@@ -78,12 +83,20 @@ namespace boost::serialization
 		ar & rows;
 		ar & cols;
 
-		mat.resize(rows, cols);
+		//written as a single contiguous block, in row-major order as for previous versions
+		Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> rowMajor;
 
-		for (int row = 0; row < mat.rows(); row++)
-		for (int col = 0; col < mat.cols(); col++)
+		if (ARCHIVE::is_saving::value)	rowMajor = mat;
+		else							rowMajor.resize(rows, cols);
+
+		if (rows * cols > 0)
+		{
+			ar & make_array(rowMajor.data(), rows * cols);
+		}
+
+		if (ARCHIVE::is_loading::value)
 		{
-			ar & mat(row, col);
+			mat = rowMajor;
 		}
 	}
 
@@ -162,6 +175,20 @@ namespace boost::serialization
 		}
 	}
 
+	template<class ARCHIVE>
+	void serialize(ARCHIVE& ar, KFIndexMap& kfIndexMap)
+	{
+		//serialise through a plain map, the index map rebuilds its hash index on assignment
+		map<KFKey, short int> indexMap = kfIndexMap;
+
+		serialize(ar, indexMap);
+
+		if (ARCHIVE::is_loading::value)
+		{
+			kfIndexMap = std::move(indexMap);
+		}
+	}
+
 	template<class ARCHIVE, class A, class B>
 	void serialize(ARCHIVE& ar, pair<A,B>& pair_)
 	{
@@ -227,6 +254,11 @@ namespace boost::serialization
 	template<class ARCHIVE>
 	void serialize(ARCHIVE& ar, KFState& kfState)
 	{
+		if (ARCHIVE::is_loading::value)
+		{
+			kfState.compiledTransition.valid = false;
+		}
+		
 		serialize(ar, kfState.kfIndexMap);
 		serialize(ar, kfState.time);
 		serialize(ar, kfState.x);
@@ -236,49 +268,88 @@ namespace boost::serialization
 	template<class ARCHIVE>
 	void serialize(ARCHIVE& ar, KFMeas& kfMeas)
 	{
-		int rows = kfMeas.H.rows();
-		int cols = kfMeas.H.cols();
+		int rows = kfMeas.numMeas();
+		int cols;
+		if (kfMeas.sparse)	cols = kfMeas.H_sparse	.cols();
+		else				cols = kfMeas.H			.cols();
 		ar & rows;
 		ar & cols;
 		
+		//design matrix nonzeros are stored as contiguous blocks of row indices, column indices, and values
+		vector<int>		rowIndices;
+		vector<int>		colIndices;
+		vector<double>	values;
+		
 		if (ARCHIVE::is_saving::value) 
 		{
 			//just wrote this, we are writing
-			map<pair<int, int>, double>	H;
-			
 			ar & kfMeas.obsKeys;
 			serialize(ar, kfMeas.time);
 			serialize(ar, kfMeas.VV);
 			
-			for (int i = 0; i < rows; i++)
-			for (int j = 0; j < cols; j++)
+			auto addEntry = [&](int row, int col, double value)
 			{
-				double value = kfMeas.H(i,j);
 				if (value)
 				{
-					H[{i,j}] = value;
+					rowIndices	.push_back(row);
+					colIndices	.push_back(col);
+					values		.push_back(value);
+				}
+			};
+			
+			if (kfMeas.sparse)
+			{
+				for (int i = 0; i < kfMeas.H_sparse.outerSize(); i++)
+				for (SparseMatrix<double, Eigen::RowMajor>::InnerIterator it(kfMeas.H_sparse, i); it; ++it)
+				{
+					addEntry(it.row(), it.col(), it.value());
 				}
 			}
+			else
+			for (int i = 0; i < rows; i++)
+			for (int j = 0; j < cols; j++)
+			{
+				addEntry(i, j, kfMeas.H(i,j));
+			}
+			
+			int num = values.size();
+			ar & num;
 			
-			serialize(ar, H);
+			if (num > 0)
+			{
+				ar & make_array(rowIndices	.data(), num);
+				ar & make_array(colIndices	.data(), num);
+				ar & make_array(values		.data(), num);
+			}
 		}
 		else
 		{
 			//we're reading
-			map<pair<int, int>, double>	H;
-			
 			ar & kfMeas.obsKeys;
 			serialize(ar, kfMeas.time);
 			serialize(ar, kfMeas.VV);
-			serialize(ar, H);
+			
+			int num;
+			ar & num;
+			
+			rowIndices	.resize(num);
+			colIndices	.resize(num);
+			values		.resize(num);
+			
+			if (num > 0)
+			{
+				ar & make_array(rowIndices	.data(), num);
+				ar & make_array(colIndices	.data(), num);
+				ar & make_array(values		.data(), num);
+			}
 			
 			kfMeas.H = MatrixXd::Zero(rows,cols);
 			kfMeas.R = MatrixXd::Zero(rows,rows);
 			kfMeas.V = VectorXd::Zero(rows);
 			
-			for (auto & [index, value] : H)
+			for (int i = 0; i < num; i++)
 			{
-				kfMeas.H(index.first, index.second) = value;
+				kfMeas.H(rowIndices[i], colIndices[i]) = values[i];
 			}
 		}
 	}
@@ -288,9 +359,16 @@ using boost::serialization::serialize;
 using boost::archive::binary_oarchive;
 using boost::archive::binary_iarchive;
 
+std::ofstream& getArchiveStream(
+	const string&	filename);
+
+void closeArchiveStream(
+	const string&	filename);
+
 /** Output filter state to a file for later reading.
  * Uses a binary archive which requires all of the relevant class members to have serialization functions written.
  * Output format is TypeId, ObjectData, NumBytes - this allows seeking backward from the end of the file to the beginning of each object.
+ * The file is kept open between calls, use closeArchiveStream() before the file is read, moved, or removed.
 */
 template<class TYPE>
 void spitFilterToFile(
@@ -298,11 +376,12 @@ void spitFilterToFile(
 	E_SerialObject	type,		///< Type of object
 	string			filename)	///< Path to file to output to
 {
-	std::fstream fileStream(filename, std::ifstream::binary | std::ifstream::out | std::ifstream::app);
+	std::ofstream& fileStream = getArchiveStream(filename);
 
 	if (!fileStream)
 	{
 		std::cout << std::endl << "Error opening algebra file " << filename <<  "for writing";
+		closeArchiveStream(filename);
 		return;
 	}
 
@@ -321,58 +400,59 @@ void spitFilterToFile(
 	serialize(serial, delta);
 }
 
-/* Retrieve an object from an archive
+/** Reader for archive files written by spitFilterToFile(), which steps through the records from the end of the file to the beginning.
+ * The file is memory mapped once, and each record is deserialised directly from memory.
 */
-template<class TYPE>
-bool getFilterObjectFromFile(
-	E_SerialObject	expectedType,	///< The expected type of object, (determine using getFilterTypeFromFile() first)
-	TYPE&			object,			///< The pre-declared object to set the value of
-	long int&		startPos,		///< The position in the file of the object's record
-	string			filename)		///< The path to the archive file to read from
+struct ArchiveReverseReader
 {
-	std::fstream fileStream(filename, std::ifstream::binary | std::ifstream::in);
+	boost::iostreams::mapped_file_source	mappedFile;
+	long int								startPos = -1;		///< Position of the most recently read record, or -1 before any are read
 
-	if (!fileStream)
-	{
-		std::cout << std::endl << "Error opening algebra file " << filename <<  "for reading";
-		return false;
-	}
+	ArchiveReverseReader(
+		const string&	filename);
 
-	binary_iarchive serial(fileStream, 1); //no header
+	bool getRecordPosition(
+		long int&		itemPosition,
+		long int&		itemEnd);
 
-	long int itemDelta;
+	E_SerialObject nextType();
 
-	if (startPos < 0)	{	fileStream.seekg(			-sizeof(itemDelta),	fileStream.end);	}
-	else				{	fileStream.seekg(startPos	-sizeof(itemDelta),	fileStream.beg);	}
+	/** Retrieve the next (preceding) object from the archive, moving the reader to its start
+	*/
+	template<class TYPE>
+	bool getObject(
+		E_SerialObject	expectedType,	///< The expected type of object, (determine using nextType() first)
+		TYPE&			object)			///< The pre-declared object to set the value of
+	{
+		long int itemPosition;
+		long int itemEnd;
+		bool pass = getRecordPosition(itemPosition, itemEnd);
+		if (pass == false)
+		{
+			std::cout << std::endl << "Error reading algebra file record";
+			return false;
+		}
 
-	long int currentPosition = fileStream.tellg();
+		boost::iostreams::stream<boost::iostreams::array_source>	recordStream(mappedFile.data() + itemPosition, itemEnd - itemPosition);
+		binary_iarchive												serial(recordStream, 1); //no header
 
-	serialize(serial, itemDelta);
+		int type_int;
+		serialize(serial, type_int);
 
-	long int itemPosition = currentPosition - itemDelta;
+		E_SerialObject type = E_SerialObject::_from_integral(type_int);
+		if (type != expectedType)
+		{
+			std::cout << std::endl << "Error: Unexpected algebra file object type";
+			return false;
+		}
 
-	fileStream.seekg(itemPosition, fileStream.beg);
+		serialize(serial, object);
 
-	int type_int;
-	serialize(serial, type_int);
+		startPos = itemPosition;
 
-	E_SerialObject type = E_SerialObject::_from_integral(type_int);
-	if (type != expectedType)
-	{
-		std::cout << std::endl << "Error: Unexpected algebra file object type";
-		return false;
+		return true;
 	}
-
-	serialize(serial, object);
-
-	startPos = itemPosition;
-
-	return true;
-}
-
-E_SerialObject getFilterTypeFromFile(
-	long int&	startPos,
-	string		filename);
+};
 
 #include "station.hpp"
 
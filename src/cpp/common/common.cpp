@@ -3,6 +3,8 @@
 
 #include <boost/log/trivial.hpp>
 
+#include <cstdint>
+
 #include "common.hpp"
 #include "constants.hpp"
 
@@ -90,14 +92,42 @@ unsigned int crc24q(
 	return crc;
 }
 
+/** Replace a field of up to 32 bits in byte data.
+* The bytes spanned by the field are combined into a single word and updated with a mask, rather than one bit at a time
+*/
+static void insertBits(
+	unsigned char*	buff,		///< Byte data to modify
+	int 			pos,		///< Bit position from start of data
+	int				len,		///< Bit length of field (1-32)
+	unsigned int	data)		///< Data to insert, only the lowest len bits are used
+{
+	int first		= pos / 8;
+	int last		= (pos + len - 1) / 8;
+	int trailing	= (last + 1) * 8 - (pos + len);
+
+	uint64_t fieldMask	= ((1ull << len) - 1) << trailing;
+
+	uint64_t word = 0;
+	for (int i = first; i <= last; i++)
+	{
+		word = (word << 8) | buff[i];
+	}
+
+	word = (word & ~fieldMask) | (((uint64_t) data << trailing) & fieldMask);
+
+	for (int i = last; i >= first; i--)
+	{
+		buff[i] = word & 0xFF;
+		word >>= 8;
+	}
+}
+
 void setbitu(
 	unsigned char*	buff,
 	int 			pos,
 	int				len,
 	unsigned int	data)
 {
-	unsigned int mask=1u<<(len-1);
-	
 	if	( len<=0
 		||len>32)
 	{
@@ -111,11 +141,7 @@ void setbitu(
 		std::cout << "Warning: " << __FUNCTION__ << " has data outside range\n";
 	}
 	
-	for (int i = pos; i < pos + len; i++, mask >>= 1) 
-	{
-		if (data&mask)	buff[i/8] |=  (1u<<(7-i%8));
-		else			buff[i/8] &= ~(1u<<(7-i%8));
-	}
+	insertBits(buff, pos, len, data);
 }
 
 void setbits(
@@ -124,8 +150,6 @@ void setbits(
 	int				len, 
 	int				data)
 {
-	unsigned int mask=1u<<(len-1);
-	
 	if	( len<=0
 		||len>32)
 	{
@@ -141,11 +165,7 @@ void setbits(
 		data = -invalid;
 	}
 	
-	for (int i = pos; i < pos + len; i++, mask >>= 1) 
-	{
-		if (data&mask)	buff[i/8] |=  (1u<<(7-i%8));
-		else			buff[i/8] &= ~(1u<<(7-i%8));
-	}
+	insertBits(buff, pos, len, data);
 }
 
 int setbituInc(
@@ -180,11 +200,30 @@ unsigned int getbitu(
 	int						pos,
 	int						len)
 {
-	unsigned int bits = 0;
-	for (int i=pos;i<pos+len;i++)
-		bits=(bits<<1)+((buff[i/8]>>(7-i%8))&1u);
+	if (len <= 0)
+	{
+		return 0;
+	}
+	
+	if (len > 32)
+	{
+		//only the last 32 bits fit in the result
+		pos += len - 32;
+		len  = 32;
+	}
+	
+	//combine the bytes spanned by the field into a single word and extract the field with a shift and mask
+	int first		= pos / 8;
+	int last		= (pos + len - 1) / 8;
+	int trailing	= (last + 1) * 8 - (pos + len);
+	
+	uint64_t word = 0;
+	for (int i = first; i <= last; i++)
+	{
+		word = (word << 8) | buff[i];
+	}
 	
-	return bits;
+	return (word >> trailing) & ((1ull << len) - 1);
 }
 
 int getbits(
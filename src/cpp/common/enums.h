@@ -221,7 +221,8 @@ BETTER_ENUM(E_FilterMode, int,
 BETTER_ENUM(E_Inverter, int,
 			LLT,
 			LDLT,
-			INV)
+			INV,
+			SEQUENTIAL)
 
 BETTER_ENUM(E_ObsDesc, int,
 	C, // Code / Pseudorange
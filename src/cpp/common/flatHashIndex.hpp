@@ -0,0 +1,121 @@
+
+#ifndef __FLAT_HASH_INDEX_HPP__
+#define __FLAT_HASH_INDEX_HPP__
+
+#include <functional>
+#include <vector>
+
+using std::vector;
+
+/** Open-addressing hash table of iterators into a node-based container.
+* Used as a secondary index for ordered maps, so that lookups are a hash and a short linear probe over contiguous memory,
+* while iteration over the underlying map remains in sorted order.
+*
+* Iterators of node-based containers are stable under insertion, so the index only needs rebuilding when elements are erased.
+*/
+template<typename ITERATOR, typename KEY, typename HASH = std::hash<KEY>>
+struct FlatHashIndex
+{
+	struct Slot
+	{
+		ITERATOR	it;
+		bool		used	= false;
+	};
+
+	vector<Slot>	slots;
+	size_t			mask	= 0;
+	size_t			count	= 0;
+
+	void clear()
+	{
+		slots.clear();
+		mask	= 0;
+		count	= 0;
+	}
+
+	/** Position of the first slot to probe for a key
+	*/
+	size_t startSlot(
+		const KEY&	key) const
+	{
+		//fibonacci hashing to spread poorly distributed hashes over the table
+		size_t hashval = HASH{}(key) * 11400714819323198485ull;
+		return (hashval >> 32) & mask;
+	}
+
+	/** Resize the table to hold at least num elements at a load factor of 0.5 or less
+	*/
+	void reserve(
+		size_t num)
+	{
+		size_t capacity = 16;
+		while (capacity < 2 * num)
+		{
+			capacity *= 2;
+		}
+
+		if (capacity <= slots.size())
+		{
+			return;
+		}
+
+		vector<Slot> oldSlots = std::move(slots);
+
+		slots.assign(capacity, Slot());
+		mask	= capacity - 1;
+		count	= 0;
+
+		for (auto& slot : oldSlots)
+		{
+			if (slot.used)
+			{
+				insert(slot.it);
+			}
+		}
+	}
+
+	void insert(
+		ITERATOR	it)
+	{
+		if (2 * (count + 1) > slots.size())
+		{
+			reserve(count + 1);
+		}
+
+		size_t i = startSlot(it->first);
+		while (slots[i].used)
+		{
+			i = (i + 1) & mask;
+		}
+
+		slots[i].it		= it;
+		slots[i].used	= true;
+		count++;
+	}
+
+	/** Returns a pointer to the iterator for a key, or nullptr if it is not in the index
+	*/
+	const ITERATOR* find(
+		const KEY&	key) const
+	{
+		if (slots.empty())
+		{
+			return nullptr;
+		}
+
+		size_t i = startSlot(key);
+		while (slots[i].used)
+		{
+			if (slots[i].it->first == key)
+			{
+				return &slots[i].it;
+			}
+
+			i = (i + 1) & mask;
+		}
+
+		return nullptr;
+	}
+};
+
+#endif
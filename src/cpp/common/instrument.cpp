@@ -1,48 +1,421 @@
 
 // #pragma GCC optimize ("O0")
 
+#include <unordered_map>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <memory>
+#include <chrono>
+#include <vector>
+#include <atomic>
+#include <deque>
+#include <mutex>
+
+using std::unordered_map;
+using std::vector;
+using std::deque;
 
 #include "instrument.hpp"
 
-#include <iostream>
-#include <chrono>
 
-map<string, size_t>		Instrument::timeMap;
-map<string, size_t>		Instrument::callMap;
+/** Completed scope recorded by the profiler.
+* Fields are atomic so that events may be read for outputs while the owning thread continues to record
+*/
+struct ProfileEvent
+{
+	std::atomic<int>	scopeId		{-1};		///< Number of the scope name on the recording thread
+	std::atomic<int>	parentId	{-1};		///< Number of the enclosing scope name on the recording thread, or -1
+	std::atomic<size_t>	start		{0};		///< Start time of the scope (ns)
+	std::atomic<size_t>	duration	{0};		///< Duration of the scope (ns)
+};
 
+/** Accumulated timing for a scope over the whole run
+*/
+struct ProfileTotal
+{
+	std::atomic<size_t>	time	{0};		///< Total time spent in the scope (ns)
+	std::atomic<size_t>	calls	{0};		///< Number of times the scope was completed
+};
 
-Instrument::Instrument(string desc)
+/** Profiling data recorded by a single thread.
+* Only the owning thread records events and accumulates totals, without locking.
+* The names mutex is only taken by the owner when a scope name is first seen on this thread, and while names are read for outputs.
+*/
+struct ThreadProfile
 {
-#ifdef	ENABLE_UNIT_TESTS
-	start		= std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now().time_since_epoch()).count();
-	description	= desc;
-#endif
-}
+	static const size_t capacity = 1 << 15;
 
+	vector<ProfileEvent>			ring		= vector<ProfileEvent>(capacity);
+	std::atomic<size_t>				head		{0};		///< Number of events ever recorded by this thread
+	std::atomic<size_t>				claimed		{0};		///< Number of events ever started to be recorded, may exceed head while an event is being written
+	size_t							summaryPos	= 0;		///< Number of events already included in summaries
+	size_t							exportPos	= 0;		///< Number of events already exported
+	unordered_map<string, int>		scopeIdMap;				///< Numbers of scope names, only used by the owning thread
+	std::mutex						namesMutex;
+	deque<string>					scopeNames;				///< Scope names, by number
+	deque<ProfileTotal>				totals;					///< Accumulated timings, by scope number
+	vector<int>						scopeStack;				///< Currently open scopes, only used by the owning thread
+	int								threadId	= 0;
 
-/** Pop a level from the stack for runtime tests
+	/** Returns the name of a scope, names mutex must be held
 	*/
+	string scopeName(
+		int id)
+	{
+		if (id < 0)		return "";
+		else			return scopeNames[id];
+	}
+};
+
+/** Profiles of all threads that have recorded events.
+* Profiles are kept after their threads end so that their events may still be output.
+*/
+static vector<std::shared_ptr<ThreadProfile>>	threadProfiles;
+static std::mutex								threadProfilesMutex;
+
+static ThreadProfile& getThreadProfile()
+{
+	thread_local std::shared_ptr<ThreadProfile> threadProfile_ptr;
+
+	if (threadProfile_ptr == nullptr)
+	{
+		threadProfile_ptr = std::make_shared<ThreadProfile>();
+
+		std::lock_guard<std::mutex> guard(threadProfilesMutex);
+
+		threadProfile_ptr->threadId = threadProfiles.size();
+
+		threadProfiles.push_back(threadProfile_ptr);
+	}
+
+	return *threadProfile_ptr;
+}
+
+static size_t nowNs()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/** Index of the oldest event that has not been overwritten, or has not been previously used
+*/
+static size_t firstAvailable(
+	size_t			head,
+	size_t			previousPos)
+{
+	size_t oldest = 0;
+	if (head > ThreadProfile::capacity)
+	{
+		oldest = head - ThreadProfile::capacity;
+	}
+
+	return std::max(oldest, previousPos);
+}
+
+/** Copy of a recorded event, with its names resolved
+*/
+struct EventCopy
+{
+	string	description;
+	string	parent;
+	size_t	start		= 0;
+	size_t	duration	= 0;
+};
+
+/** Copy the events recorded by a thread since a previous position, and advance the position.
+* Events that are overwritten by the owning thread while being copied are discarded and counted as dropped.
+*/
+static vector<EventCopy> copyEvents(
+	ThreadProfile&	threadProfile,	///< Profile to copy events from
+	size_t&			pos,			///< Position of the first event not yet copied, updated on return
+	size_t&			dropped)		///< Count of events that were not available to copy
+{
+	vector<EventCopy> events;
+
+	size_t head		= threadProfile.head.load(std::memory_order_acquire);
+	size_t begin	= firstAvailable(head, pos);
+
+	dropped += begin - pos;
+
+	std::lock_guard<std::mutex> guard(threadProfile.namesMutex);
+
+	for (size_t i = begin; i < head; i++)
+	{
+		auto& event = threadProfile.ring[i % ThreadProfile::capacity];
+
+		int		scopeId		= event.scopeId		.load(std::memory_order_relaxed);
+		int		parentId	= event.parentId	.load(std::memory_order_relaxed);
+		size_t	start		= event.start		.load(std::memory_order_relaxed);
+		size_t	duration	= event.duration	.load(std::memory_order_relaxed);
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+		if (firstAvailable(threadProfile.claimed.load(std::memory_order_relaxed), i) != i)
+		{
+			//overwritten while copying
+			dropped++;
+			continue;
+		}
+
+		EventCopy copy;
+		copy.description	= threadProfile.scopeName(scopeId);
+		copy.parent			= threadProfile.scopeName(parentId);
+		copy.start			= start;
+		copy.duration		= duration;
+
+		events.push_back(std::move(copy));
+	}
+
+	pos = head;
+
+	return events;
+}
+
+
+/** Open a new profiling scope on this thread
+*/
+Instrument::Instrument(
+	const string&	desc)		///< Name of the scope
+{
+	threadProfile_ptr = &getThreadProfile();
+
+	auto& threadProfile = *threadProfile_ptr;
+
+	auto it = threadProfile.scopeIdMap.find(desc);
+	if (it == threadProfile.scopeIdMap.end())
+	{
+		//first use of this name on this thread
+		std::lock_guard<std::mutex> guard(threadProfile.namesMutex);
+
+		int id = threadProfile.scopeNames.size();
+
+		threadProfile.scopeNames.push_back(desc);
+		threadProfile.totals	.emplace_back();
+
+		it = threadProfile.scopeIdMap.insert({desc, id}).first;
+	}
+
+	scopeId = it->second;
+
+	if (threadProfile.scopeStack.empty())		parentId = -1;
+	else										parentId = threadProfile.scopeStack.back();
+
+	threadProfile.scopeStack.push_back(scopeId);
+
+	start = nowNs();
+}
+
+
+/** Close the scope and record its timing
+*/
 Instrument::~Instrument()
 {
-#ifdef	ENABLE_UNIT_TESTS
-	size_t stop = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now().time_since_epoch()).count();
-	
-	timeMap[description] += stop - start;
-	callMap[description] += 1;
-#endif
+	size_t stop = nowNs();
+
+	auto& threadProfile = *threadProfile_ptr;
+
+	threadProfile.scopeStack.pop_back();
+
+	size_t head = threadProfile.head.load(std::memory_order_relaxed);
+
+	auto& event = threadProfile.ring[head % ThreadProfile::capacity];
+
+	//claim the slot before overwriting it, so that readers copying the previous event in it can tell
+	threadProfile.claimed.store(head + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	event.scopeId	.store(scopeId,			std::memory_order_relaxed);
+	event.parentId	.store(parentId,		std::memory_order_relaxed);
+	event.start		.store(start,			std::memory_order_relaxed);
+	event.duration	.store(stop - start,	std::memory_order_relaxed);
+
+	threadProfile.head.store(head + 1, std::memory_order_release);
+
+	//only this thread writes its totals, so no read-modify-write is required
+	auto& total = threadProfile.totals[scopeId];
+	total.time	.store(total.time	.load(std::memory_order_relaxed) + stop - start,	std::memory_order_relaxed);
+	total.calls	.store(total.calls	.load(std::memory_order_relaxed) + 1,				std::memory_order_relaxed);
 }
 
 
-/** Print the status of completed (passed/failed) and remaining tests
-	*/
-void Instrument::printStatus() 
+/** Print the accumulated timings of all scopes over the whole run
+*/
+void Instrument::printStatus()
 {
-#ifdef	ENABLE_UNIT_TESTS
+	struct Total
+	{
+		size_t	time	= 0;
+		size_t	calls	= 0;
+	};
+
+	map<string, Total> totalMap;
+
+	{
+		std::lock_guard<std::mutex> registryGuard(threadProfilesMutex);
+
+		for (auto& threadProfile_ptr : threadProfiles)
+		{
+			auto& threadProfile = *threadProfile_ptr;
+
+			std::lock_guard<std::mutex> guard(threadProfile.namesMutex);
+
+			for (int id = 0; id < threadProfile.totals.size(); id++)
+			{
+				auto& threadTotal	= threadProfile.totals[id];
+				auto& total			= totalMap[threadProfile.scopeNames[id]];
+				total.time	+= threadTotal.time		.load(std::memory_order_relaxed);
+				total.calls	+= threadTotal.calls	.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
 	std::cout << std::endl << "Instrumentation:\n";
-	for (auto& [desc, time] : timeMap)
+	for (auto& [desc, total] : totalMap)
+	{
+		if (total.calls == 0)
+		{
+			continue;
+		}
+
+		size_t time = total.time / 1000;
+		printf("%30s took %15ldus over %5ld calls, averaging %ld\n", desc.c_str(), time, total.calls, time / total.calls);
+	}
+}
+
+
+/** Output the latency distribution of each scope completed since the previous summary.
+* Scopes are listed along with their enclosing scope, so that the same function called from different places may be distinguished
+*/
+void Instrument::outputEpochSummary(
+	std::ostream&	trace)		///< Trace file to output to
+{
+	map<string, vector<size_t>>	durationsMap;
+	size_t						dropped		= 0;
+
+	{
+		std::lock_guard<std::mutex> registryGuard(threadProfilesMutex);
+
+		for (auto& threadProfile_ptr : threadProfiles)
+		{
+			auto& threadProfile = *threadProfile_ptr;
+
+			auto events = copyEvents(threadProfile, threadProfile.summaryPos, dropped);
+
+			for (auto& event : events)
+			{
+				string path = event.description;
+				if (event.parent.empty() == false)
+				{
+					path = event.parent + " > " + path;
+				}
+
+				durationsMap[path].push_back(event.duration);
+			}
+		}
+	}
+
+	if (durationsMap.empty())
 	{
-		auto calls = callMap[desc];
-		printf("%30s took %15ldus over %5ld calls, averaging %ld\n", desc.c_str(), time, calls, time/calls);
+		return;
+	}
+
+	trace << std::endl << "+ Profile summary (us)";
+	if (dropped)
+	{
+		trace << " - " << dropped << " events overwritten before summary";
+	}
+	trace << std::endl;
+
+	trace
+	<< std::setw(50)	<< "Scope"
+	<< std::setw(8)		<< "Calls"
+	<< std::setw(14)	<< "Total"
+	<< std::setw(12)	<< "p50"
+	<< std::setw(12)	<< "p99"
+	<< std::setw(12)	<< "Max"
+	<< std::endl;
+
+	for (auto& [path, durations] : durationsMap)
+	{
+		std::sort(durations.begin(), durations.end());
+
+		size_t num		= durations.size();
+		size_t total	= 0;
+		for (auto& duration : durations)
+		{
+			total += duration;
+		}
+
+		trace << std::fixed << std::setprecision(1)
+		<< std::setw(50)	<< path
+		<< std::setw(8)		<< num
+		<< std::setw(14)	<< total								/ 1000.0
+		<< std::setw(12)	<< durations[(num - 1) * 50 / 100]		/ 1000.0
+		<< std::setw(12)	<< durations[(num - 1) * 99 / 100]		/ 1000.0
+		<< std::setw(12)	<< durations.back()						/ 1000.0
+		<< std::endl;
+	}
+
+	trace << "- Profile summary" << std::endl;
+}
+
+
+/** Append all scopes completed since the previous export to a file in chrome trace (json array) format.
+* The file is started anew on the first export of each run.
+* The array is left unterminated so that it may be appended to indefinitely, which is accepted by chrome://tracing and perfetto
+*/
+void Instrument::outputChromeTrace(
+	const string&	filename)	///< Path of file to append events to
+{
+	static map<string, bool> firstRecordMap;
+
+	std::lock_guard<std::mutex> registryGuard(threadProfilesMutex);
+
+	auto [it, newFile] = firstRecordMap.insert({filename, true});
+
+	bool& firstRecord = it->second;
+
+	std::ofstream output;
+	if (newFile)	output.open(filename);
+	else			output.open(filename, std::ofstream::app);
+
+	if (!output)
+	{
+		return;
+	}
+
+	if (newFile)
+	{
+		output << "[" << std::endl;
+	}
+
+	size_t dropped = 0;
+
+	for (auto& threadProfile_ptr : threadProfiles)
+	{
+		auto& threadProfile = *threadProfile_ptr;
+
+		auto events = copyEvents(threadProfile, threadProfile.exportPos, dropped);
+
+		for (auto& event : events)
+		{
+			string name = event.description;
+			std::replace(name.begin(), name.end(), '"',		'\'');
+			std::replace(name.begin(), name.end(), '\\',	'/');
+
+			if (firstRecord == false)
+			{
+				output << ",";
+			}
+			firstRecord = false;
+
+			output << std::fixed << std::setprecision(3)
+			<< "{\"name\":\""	<< name
+			<< "\",\"ph\":\"X\",\"pid\":1,\"tid\":"	<< threadProfile.threadId
+			<< ",\"ts\":"		<< event.start		/ 1000.0
+			<< ",\"dur\":"		<< event.duration	/ 1000.0
+			<< "}" << std::endl;
+		}
 	}
-#endif
 }
@@ -3,26 +3,42 @@
 #define __INSTRUMENT_HPP__
 
 
+#include <iostream>
 #include <string>
 #include <map>
 
 using std::string;
 using std::map;
 
+struct ThreadProfile;
 
+
+/** Scoped timer for profiling sections of code.
+* Completed scopes are recorded into a ring buffer and accumulators owned by the recording thread, along with the enclosing scope,
+* so that timing is cheap enough to leave enabled in production, and is safe within parallel sections.
+* Scope names are numbered per thread, so no locks are taken when opening or closing a scope after its first use on a thread.
+*
+* The buffers are periodically drained to produce per-scope summaries, and may be exported in chrome trace format.
+*/
 struct Instrument
 {
-	static map<string, size_t>		timeMap;
-	static map<string, size_t>		callMap;
+	size_t			start;				///< Start time of the scope (ns)
+	int				scopeId;			///< Number of the scope name on this thread
+	int				parentId;			///< Number of the enclosing scope name on this thread, or -1
+	ThreadProfile*	threadProfile_ptr;	///< Profile of the thread that opened the scope
 
-	size_t	start;
-	string	description;
-	
-	Instrument(string desc);
+	Instrument(
+		const string&	desc);
 
 	~Instrument();
 
 	static void printStatus();
+
+	static void outputEpochSummary(
+		std::ostream&	trace);
+
+	static void outputChromeTrace(
+		const string&	filename);
 };
 
 #endif
@@ -0,0 +1,50 @@
+
+#include <unordered_map>
+#include <shared_mutex>
+#include <mutex>
+
+#include "internedString.hpp"
+
+using std::unordered_map;
+
+const string InternedString::emptyString;
+
+/** Table of all strings that have been interned, keyed by the strings themselves.
+* Nodes of unordered_maps are never relocated, so pointers to their keys remain valid for the lifetime of the program.
+*/
+static unordered_map<string, int>	internTable;
+static std::shared_mutex			internTableMutex;
+
+/** Find or create the handle for a string
+*/
+InternedString::InternedString(
+	const string&	str)	///< String to intern
+{
+	if (str.empty())
+	{
+		return;
+	}
+
+	{
+		std::shared_lock<std::shared_mutex> readLock(internTableMutex);
+
+		auto it = internTable.find(str);
+		if (it != internTable.end())
+		{
+			auto& [storedStr, storedId] = *it;
+
+			id		= storedId;
+			str_ptr	= &storedStr;
+			return;
+		}
+	}
+
+	std::unique_lock<std::shared_mutex> writeLock(internTableMutex);
+
+	auto [it, inserted] = internTable.insert({str, internTable.size() + 1});
+
+	auto& [storedStr, storedId] = *it;
+
+	id		= storedId;
+	str_ptr	= &storedStr;
+}
@@ -0,0 +1,106 @@
+
+#ifndef __INTERNED_STRING_HPP__
+#define __INTERNED_STRING_HPP__
+
+#include <iostream>
+#include <string>
+
+using std::ostream;
+using std::string;
+
+/** String that is stored once in a global table and referenced by a small integer handle.
+* Used for receiver ids and observation types within filter keys, so that keys may be compared and hashed without string operations.
+*
+* Equality and hashing use only the handle.
+* Ordering is lexicographic, (as for the original strings), so that containers sorted by these keys keep their previous order.
+*/
+struct InternedString
+{
+	int				id		= 0;					///< Handle for this string, 0 is reserved for the empty string
+	const string*	str_ptr	= &emptyString;			///< Pointer to the single stored copy of this string
+
+	static const string emptyString;
+
+	InternedString()
+	{
+
+	}
+
+	InternedString(
+		const string&	str);
+
+	InternedString(
+		const char*		str)
+	:	InternedString(string(str))
+	{
+
+	}
+
+	operator const string&() const
+	{
+		return *str_ptr;
+	}
+
+	const char* c_str() const
+	{
+		return str_ptr->c_str();
+	}
+
+	bool empty() const
+	{
+		return id == 0;
+	}
+
+	size_t size() const
+	{
+		return str_ptr->size();
+	}
+
+	int compare(
+		const InternedString& b) const
+	{
+		if (id == b.id)		return 0;
+		else				return str_ptr->compare(*b.str_ptr);
+	}
+
+	bool operator ==	(const InternedString&	b) const	{	return id == b.id;						}
+	bool operator ==	(const string&			b) const	{	return *str_ptr == b;					}
+	bool operator ==	(const char*			b) const	{	return *str_ptr == b;					}
+	bool operator <		(const InternedString&	b) const	{	return compare(b) < 0;					}
+
+	friend string operator +	(const InternedString& a,	const string&			b)	{	return *a.str_ptr	+ b;			}
+	friend string operator +	(const string& a,			const InternedString&	b)	{	return a			+ *b.str_ptr;	}
+	friend string operator +	(const InternedString& a,	const char*				b)	{	return *a.str_ptr	+ b;			}
+	friend string operator +	(const char* a,				const InternedString&	b)	{	return a			+ *b.str_ptr;	}
+
+	friend ostream& operator<<(ostream& os, const InternedString& str)
+	{
+		os << *str.str_ptr;
+		return os;
+	}
+
+	template<class ARCHIVE>
+	void serialize(ARCHIVE& ar, const unsigned int& version)
+	{
+		string str = *str_ptr;
+		ar & str;
+
+		if (ARCHIVE::is_loading::value)
+		{
+			*this = InternedString(str);
+		}
+	}
+};
+
+namespace std
+{
+	template<> struct hash<InternedString>
+	{
+		size_t operator()(InternedString const& str) const
+		{
+			return hash<int>{}(str.id);
+		}
+	};
+}
+
+#endif
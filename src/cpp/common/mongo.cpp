@@ -7,6 +7,7 @@
 #include "rtcmEncoder.hpp"
 #include "acsConfig.hpp"
 #include "satStat.hpp"
+#include "mongoWrite.hpp"
 #include "common.hpp"
 #include "mongo.hpp"
 
@@ -112,6 +113,8 @@ void mongoooo()
 		}
 		
 		BOOST_LOG_TRIVIAL(info)  << "Mongo connected to database : " << acsConfig.mongo_database;
+		
+		mongoWriter.start();
 	}
 	catch (...)
 	{
@@ -128,19 +131,21 @@ void MongoLogSinkBackend::consume(
 	{
 		return;
 	}
+	
+	//dont feed the writer's own errors back to it
+	if (std::this_thread::get_id() == mongoWriter.thread.get_id())
+	{
+		return;
+	}
 
-	Mongo& mongo = *mongo_ptr;
-
-	auto 						c		= mongo.pool.acquire();
-	mongocxx::client&			client	= *c;
-	mongocxx::database			db		= client[acsConfig.mongo_database];
-	mongocxx::collection		coll	= db	["Console"];
-
-	//add a azimuth to a chunk
-	coll.insert_one(
+	vector<MongoWriteOp> ops;
+	
+	ops.push_back({"Console",
 		document{}
 			<< "Epoch"			<< bsoncxx::types::b_date {std::chrono::system_clock::from_time_t(tsync.time)}
 			<< "Log"			<< log_string.c_str()
-			<< finalize
-		);
+			<< finalize,
+		std::nullopt});
+	
+	mongoWriter.push(ops);
 }
@@ -8,66 +8,9 @@ using std::deque;
 #include "streamRtcm.hpp"
 #include "acsConfig.hpp"
 #include "mongoRead.hpp"
+#include "ssrCache.hpp"
 #include "common.hpp"
 
-template <typename RETTYPE, typename INTYPE>
-RETTYPE getStraddle(
-	GTime			targetTime,
-	deque<INTYPE>&	ssrVec)
-{
-	RETTYPE ssr;
-	
-	ssr.valid = true;
-	
-	//try to find a set of things that straddle the target time, with the same iode
-	
-	int bestI = -1;
-	int bestJ = -1;
-	
-	for (int j = 1; j < ssrVec.size(); j++)
-	{
-		int i = j - 1;
-		
-		auto& entryI = ssrVec[i];
-		auto& entryJ = ssrVec[j];
-		
-		if (entryI.iode != entryJ.iode)
-		{
-			//no good, iodes dont match
-			continue;
-		}
-	
-// 			if	( fabs(bestI.time.time - targetTime.time) > acsConfig.
-// 				||fabs(bestJ.time.time - targetTime.time) > acsConfig.
-// 			{
-// 				continue;
-// 			}
-		
-		//these are acceptable - store them for later
-		bestI = i;
-		bestJ = j;
-	
-		if (entryJ.time > targetTime)
-		{
-			//this is as close as we will come to a straddle
-			break;
-		}
-	}
-	
-	if (bestJ < 0)
-	{
-		//nothing found, dont use
-		ssr.valid = false;
-		
-		return RETTYPE();
-	}
-	
-	ssr.vals[0] = ssrVec[bestI];
-	ssr.vals[1]	= ssrVec[bestJ];	
-	
-	return ssr;
-}
-
 map<SatSys, SSROut> mongoReadSSRData(
 	GTime	targetTime,
 	SSRMeta	ssrMeta,
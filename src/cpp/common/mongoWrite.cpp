@@ -9,6 +9,7 @@
 #include "GNSSambres.hpp"
 #include "biasSINEX.hpp"
 #include "acsConfig.hpp"
+#include "ssrCache.hpp"
 #include "satStat.hpp"
 #include "common.hpp"
 #include "mongo.hpp"
@@ -17,8 +18,292 @@
 #include <bsoncxx/builder/basic/document.hpp>
 #include <bsoncxx/json.hpp>
 
+#include <bsoncxx/builder/concatenate.hpp>
+
 using bsoncxx::builder::basic::kvp;
 
+MongoWriter mongoWriter;
+
+/** Start the thread that writes queued documents to the database
+*/
+void MongoWriter::start()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	
+	if (thread.joinable())
+	{
+		return;
+	}
+	
+	stopping = false;
+	
+	thread = std::thread(&MongoWriter::run, this);
+}
+
+/** Write any documents remaining in the queue and stop the writing thread
+*/
+void MongoWriter::stop()
+{
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		
+		if (thread.joinable() == false)
+		{
+			return;
+		}
+		
+		stopping = true;
+		
+		notEmpty.notify_all();
+	}
+	
+	thread.join();
+	
+	BOOST_LOG_TRIVIAL(info)
+	<< "Mongo writer finished - queued: "	<< queued
+	<< ", written: "						<< written
+	<< ", failed: "							<< failed
+	<< ", dropped: "						<< dropped
+	<< ", max queue depth: "				<< maxDepth;
+}
+
+/** Add operations to the queue for writing by the writer thread.
+* Never waits for the database - operations that do not fit in the queue are dropped and counted
+*/
+void MongoWriter::push(
+	vector<MongoWriteOp>&	ops)	///< Operations to queue, consumed
+{
+	if (ops.empty())
+	{
+		return;
+	}
+	
+	bool startedDropping = false;
+	
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		
+		for (auto& op : ops)
+		{
+			if (queue.size() >= acsConfig.mongo_queue_size)
+			{
+				if (dropping == false)
+				{
+					startedDropping = true;
+				}
+				
+				dropping = true;
+				dropped++;
+				continue;
+			}
+			
+			dropping = false;
+			
+			queue.push_back(std::move(op));
+			queued++;
+		}
+		
+		if (queue.size() > maxDepth)
+		{
+			maxDepth = queue.size();
+		}
+		
+		notEmpty.notify_one();
+	}
+	
+	ops.clear();
+	
+	//only warn when the queue first fills, as these warnings may themselves be queued for the database
+	if (startedDropping)
+	{
+		BOOST_LOG_TRIVIAL(warning) << "Warning: Mongo write queue is full, dropping documents - check the database is keeping up, or increase the queue size";
+	}
+}
+
+/** Write a batch of operations to a collection as unordered bulk writes.
+* Operations on the same document must be applied in order, so a new bulk write is started whenever a filter is repeated
+*/
+void writeCollectionBatch(
+	mongocxx::database&		db,				///< Database to write to
+	const string&			collectionName,	///< Collection to write to
+	vector<MongoWriteOp*>&	ops,			///< Operations to write, in the order they were queued
+	size_t&					written,		///< Number of operations written
+	size_t&					failed)			///< Number of operations that could not be written
+{
+	mongocxx::collection			coll	= db[collectionName];
+	
+	mongocxx::options::bulk_write	bulk_opts;
+	bulk_opts.ordered(false);
+	
+	auto	bulk	= coll.create_bulk_write(bulk_opts);
+	size_t	num		= 0;
+	
+	std::set<string> filters;
+	
+	auto execute = [&]()
+	{
+		if (num == 0)
+		{
+			return;
+		}
+		
+		try
+		{
+			bulk.execute();
+			written	+= num;
+		}
+		catch (std::exception& e)
+		{
+			failed	+= num;
+			BOOST_LOG_TRIVIAL(error) << "Error: Mongo bulk write to " << collectionName << " failed: " << e.what();
+		}
+		
+		bulk	= coll.create_bulk_write(bulk_opts);
+		num		= 0;
+		filters.clear();
+	};
+	
+	for (auto op_ptr : ops)
+	{
+		auto& op = *op_ptr;
+		
+		if (op.update)
+		{
+			auto view = op.document.view();
+			string filter((const char*) view.data(), view.length());
+			
+			bool inserted = filters.insert(filter).second;
+			if (inserted == false)
+			{
+				execute();
+				filters.insert(filter);
+			}
+			
+			mongocxx::model::update_one mongo_req(op.document.view(), op.update->view());
+			mongo_req.upsert(true);
+			bulk.append(mongo_req);
+		}
+		else
+		{
+			mongocxx::model::insert_one mongo_req(op.document.view());
+			bulk.append(mongo_req);
+		}
+		
+		num++;
+	}
+	
+	execute();
+}
+
+/** Write queued operations to the database until stopped.
+* All operations waiting in the queue are taken at once, so that documents from several epochs are coalesced into large bulk writes whenever the database falls behind
+*/
+void MongoWriter::run()
+{
+	while (1)
+	{
+		vector<MongoWriteOp> batch;
+		
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			
+			notEmpty.wait(lock, [&]{ return stopping || queue.empty() == false; });
+			
+			if	(  queue.empty()
+				&& stopping)
+			{
+				return;
+			}
+			
+			size_t num = std::min(queue.size(), (size_t) acsConfig.mongo_batch_size);
+			num = std::max(num, (size_t) 1);
+			
+			batch.reserve(num);
+			for (size_t i = 0; i < num; i++)
+			{
+				batch.push_back(std::move(queue.front()));
+				queue.pop_front();
+			}
+		}
+		
+		if (mongo_ptr == nullptr)
+		{
+			continue;
+		}
+		
+		map<string, vector<MongoWriteOp*>> collectionOpsMap;
+		for (auto& op : batch)
+		{
+			collectionOpsMap[op.collection].push_back(&op);
+		}
+		
+		size_t batchWritten	= 0;
+		size_t batchFailed	= 0;
+		
+		try
+		{
+			Mongo& mongo = *mongo_ptr;
+			
+			auto 						c		= mongo.pool.acquire();
+			mongocxx::client&			client	= *c;
+			mongocxx::database			db		= client[acsConfig.mongo_database];
+			
+			for (auto& [collectionName, ops] : collectionOpsMap)
+			{
+				writeCollectionBatch(db, collectionName, ops, batchWritten, batchFailed);
+			}
+		}
+		catch (std::exception& e)
+		{
+			batchFailed = batch.size() - batchWritten;
+			BOOST_LOG_TRIVIAL(error) << "Error: Mongo writer could not write to database: " << e.what();
+		}
+		
+		std::unique_lock<std::mutex> lock(mutex);
+		
+		written	+= batchWritten;
+		failed	+= batchFailed;
+		batches++;
+	}
+}
+
+/** Output the state of the writer, so that back-pressure from the database may be monitored
+*/
+void MongoWriter::outputStatistics(
+	Trace&	trace)		///< Trace file to output to
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	
+	tracepdeex(0, trace, "\n+ Mongo writer\n");
+	tracepdeex(0, trace, "Queue depth     : %10ld (max %ld of %d)\n",	queue.size(), maxDepth, acsConfig.mongo_queue_size);
+	tracepdeex(0, trace, "Queued          : %10ld\n",				queued);
+	tracepdeex(0, trace, "Written         : %10ld in %ld batches\n",	written, batches);
+	tracepdeex(0, trace, "Failed          : %10ld\n",				failed);
+	tracepdeex(0, trace, "Dropped         : %10ld\n",				dropped);
+	tracepdeex(0, trace, "- Mongo writer\n");
+}
+
+/** Queue an upsert of a document, creating it if it does not exist
+*/
+void queueUpsert(
+	vector<MongoWriteOp>&			ops,			///< List of operations to add to
+	const string&					collection,		///< Collection to write to
+	bsoncxx::document::value&&		filter,			///< Filter identifying the document
+	bsoncxx::document::value&&		update)			///< Update to apply to the document
+{
+	ops.push_back({collection, std::move(filter), std::move(update)});
+}
+
+/** Queue an insertion of a new document, for time series data that is only written once
+*/
+void queueInsert(
+	vector<MongoWriteOp>&			ops,			///< List of operations to add to
+	const string&					collection,		///< Collection to write to
+	bsoncxx::document::value&&		doc)			///< Document to insert
+{
+	ops.push_back({collection, std::move(doc), std::nullopt});
+}
+
 void mongoTestStat(
 	KFState&		kfState,
 	TestStatistics&	testStatistics)
@@ -34,22 +319,7 @@ void mongoTestStat(
 	
 	Instrument instrument(__FUNCTION__);
 
-	Mongo& mongo = *mongo_ptr;
-
-	auto 						c		= mongo.pool.acquire();
-	mongocxx::client&			client	= *c;
-	mongocxx::database			db		= client[acsConfig.mongo_database];
-	mongocxx::collection		coll	= db	["States"];
-
-	mongocxx::options::update	options;
-	options.upsert(true);
-
-	mongocxx::options::bulk_write bulk_opts;
-	bulk_opts.ordered(false);
-
-	auto bulk = coll.create_bulk_write(bulk_opts);
-
-	bool update = false;
+	vector<MongoWriteOp> ops;
 
 	map<string, double> entries;
 	entries["StatsSumOfSquaresPre"		] = testStatistics.sumOfSquaresPre;
@@ -63,7 +333,7 @@ void mongoTestStat(
 	
 	for (auto& [state, value] : entries)
 	{
-		mongocxx::model::update_one  mongo_req(
+		queueUpsert(ops, "States",
 			document{}
 				<< "Epoch"		<< bsoncxx::types::b_date {std::chrono::system_clock::from_time_t(kfState.time.time)}
 				<< "Site"		<< kfState.id		+ acsConfig.mongo_suffix
@@ -78,16 +348,9 @@ void mongoTestStat(
 				<< close_document
 				<< finalize
 			);
-		
-		mongo_req.upsert(true);
-		bulk.append(mongo_req);
-		update = true;
 	}
 
-	if (update)
-	{
-		bulk.execute();
-	}
+	mongoWriter.push(ops);
 }
 
 void mongoMeasSatStat(
@@ -104,11 +367,7 @@ void mongoMeasSatStat(
 	
 	Instrument instrument(__FUNCTION__);
 
-	Mongo& mongo = *mongo_ptr;
-
-	auto 						c		= mongo.pool.acquire();
-	mongocxx::client&			client	= *c;
-	mongocxx::database			db		= client[acsConfig.mongo_database];
+	vector<MongoWriteOp> ops;
 	
 	for (auto pseudoIndex : {false, true})
 	{
@@ -116,18 +375,6 @@ void mongoMeasSatStat(
 		if (pseudoIndex)		
 			collectionName += "Index";
 		
-		mongocxx::collection		coll	= db[collectionName];
-
-		mongocxx::options::update	options;
-		options.upsert(true);
-
-		mongocxx::options::bulk_write bulk_opts;
-		bulk_opts.ordered(false);
-
-		auto bulk = coll.create_bulk_write(bulk_opts);
-
-		bool update = false;
-
 		for (auto& [id, rec] : stationMap)
 		for (auto& obs : rec.obsList)
 		{
@@ -160,22 +407,17 @@ void mongoMeasSatStat(
 			valDoc.append(kvp("slip",			pseudoIndex ? true : satStat.slip				));
 			valDoc.append(kvp("Phase Windup",	pseudoIndex ? true : satStat.phw				));
 			
-			mongocxx::model::update_one  mongo_req(
+			queueUpsert(ops, collectionName,
 				keyDoc.extract(),
 
 				document{}
 					<< "$set" << valDoc
 					<< finalize
 				);
-
-			mongo_req.upsert(true);
-			bulk.append(mongo_req);
-			update = true;
 		}
-
-		if (update)
-			bulk.execute();
 	}
+
+	mongoWriter.push(ops);
 }
 
 
@@ -200,11 +442,12 @@ void mongoMeasResiduals(
 	
 	Instrument instrument(__FUNCTION__);
 
-	Mongo& mongo = *mongo_ptr;
-
-	auto 						c		= mongo.pool.acquire();
-	mongocxx::client&			client	= *c;
-	mongocxx::database			db		= client[acsConfig.mongo_database];
+	vector<MongoWriteOp> ops;
+	
+	if (num < 0)
+	{
+		num = prefits.rows();
+	}
 	
 	for (auto pseudoIndex : {false, true})
 	{
@@ -212,24 +455,6 @@ void mongoMeasResiduals(
 		if (pseudoIndex)		
 			collectionName += "Index";
 		
-		mongocxx::collection		coll	= db[collectionName];
-
-		mongocxx::options::update	options;
-		options.upsert(true);
-
-		mongocxx::options::bulk_write bulk_opts;
-		bulk_opts.ordered(false);
-
-		auto bulk = coll.create_bulk_write(bulk_opts);
-
-		bool update = false;
-
-		if (num < 0)
-		{
-			num = prefits.rows();
-		}
-		
-		options.upsert(true);
 		for (int i = beg; i < beg + num; i++)
 		{
 			ObsKey& obsKey = obsKeys[i];
@@ -253,25 +478,17 @@ void mongoMeasResiduals(
 			valDoc.append(kvp(name + "-Postfit",	pseudoIndex ? true : postfits(i)	));
 			valDoc.append(kvp(name + "-Variance",	pseudoIndex ? true : variance(i,i)	));
 			
-			mongocxx::model::update_one  mongo_req(
+			queueUpsert(ops, collectionName,
 				keyDoc.extract(),
 
 				document{}
 					<< "$set" << valDoc
 					<< finalize
 				);
-
-			mongo_req.upsert(true);
-			
-			bulk.append(mongo_req);
-			update = true;
-		}
-
-		if (update)
-		{
-			bulk.execute();
 		}
 	}
+
+	mongoWriter.push(ops);
 }
 
 void mongoMeasComponents(
@@ -288,11 +505,7 @@ void mongoMeasComponents(
 	
 	Instrument instrument(__FUNCTION__);
 	
-	Mongo& mongo = *mongo_ptr;
-	
-	auto 						c		= mongo.pool.acquire();
-	mongocxx::client&			client	= *c;
-	mongocxx::database			db		= client[acsConfig.mongo_database];
+	vector<MongoWriteOp> ops;
 	
 	for (auto pseudoIndex : {false, true})
 	{
@@ -300,19 +513,6 @@ void mongoMeasComponents(
 		if (pseudoIndex)		
 			collectionName += "Index";
 		
-		mongocxx::collection		coll	= db[collectionName];
-	
-		mongocxx::options::update	options;
-		options.upsert(true);
-		
-		mongocxx::options::bulk_write bulk_opts;
-		bulk_opts.ordered(false);
-		
-		auto bulk = coll.create_bulk_write(bulk_opts);
-		
-		bool update = false;
-		
-		options.upsert(true);
 		for (int i = 0; i < kfMeas.obsKeys.size(); i++)
 		{
 			ObsKey&	obsKey			= kfMeas.obsKeys[i];
@@ -340,29 +540,26 @@ void mongoMeasComponents(
 				valDoc.append(kvp(name + "-" + comp,		pseudoIndex ? true : value		));
 			}
 			
-			mongocxx::model::update_one  mongo_req(
+			queueUpsert(ops, collectionName,
 				keyDoc.extract(),
 
 				document{}
 					<< "$set" << valDoc
 					<< finalize
 				);
-			
-			mongo_req.upsert(true);
-			bulk.append(mongo_req);
-			update = true;
-		}
-		
-		if (update)
-		{
-			bulk.execute();
 		}
 	}
+	
+	mongoWriter.push(ops);
 }
 
+/** Output the states of a filter to the database.
+* Each epoch's states are written as one document per state, upserted unless the caller knows that no other output for the epoch shares its keys
+*/
 void mongoStates(
-	KFState&			kfState,
-	string				suffix)
+	KFState&			kfState,		///< Filter to output the states of
+	string				suffix,			///< Suffix to append to the site and satellite names
+	bool				upsert)			///< Merge with any values already written for this epoch, for states that may be output more than once
 {
 	if (mongo_ptr == nullptr)
 	{
@@ -375,11 +572,7 @@ void mongoStates(
 
 	Instrument instrument(__FUNCTION__);
 	
-	Mongo& mongo = *mongo_ptr;
-
-	auto 						c		= mongo.pool.acquire();
-	mongocxx::client&			client	= *c;
-	mongocxx::database			db		= client[acsConfig.mongo_database];
+	vector<MongoWriteOp> ops;
 	
 	for (auto pseudoIndex : {false, true})
 	{
@@ -387,25 +580,27 @@ void mongoStates(
 		if (pseudoIndex)		
 			collectionName += "Index";
 		
-		mongocxx::collection		coll	= db[collectionName];
-
-		mongocxx::options::update	options;
-		options.upsert(true);
-
-		mongocxx::options::bulk_write bulk_opts;
-		bulk_opts.ordered(false);
-
-		auto bulk = coll.create_bulk_write(bulk_opts);
-
-		bool update = false;
-
+		//collect all elements of each state into a single document
+		map<tuple<string, string, string>, bsoncxx::builder::basic::document> valDocMap;
+		
 		for (auto& [key, index] : kfState.kfIndexMap)
 		{
 			if (key.type == KF::ONE)
 			{
 				continue;
 			}
-
+			
+			auto& valDoc = valDocMap[{key.str, key.Sat.id(), KF::_from_integral_unchecked(key.type)._to_string()}];
+			
+			valDoc.append(kvp("x"	+ std::to_string(key.num),		pseudoIndex ? true : kfState.x	(index)			));
+			valDoc.append(kvp("dx"	+ std::to_string(key.num),		pseudoIndex ? true : kfState.dx	(index)			));
+			valDoc.append(kvp("P"	+ std::to_string(key.num),		pseudoIndex ? true : kfState.P	(index,index)	));
+		}
+		
+		for (auto& [stateKey, valDoc] : valDocMap)
+		{
+			auto& [str, sat, state] = stateKey;
+			
 			bsoncxx::builder::basic::document keyDoc = {};
 			if (pseudoIndex == false)
 			{
@@ -414,15 +609,20 @@ void mongoStates(
 			}
 			
 			{
-				keyDoc.append(kvp("Site",	key.str			+ acsConfig.mongo_suffix + suffix		));
-				keyDoc.append(kvp("Sat",	key.Sat.id()	+ acsConfig.mongo_suffix + suffix		));
-				keyDoc.append(kvp("State",	KF::_from_integral_unchecked(key.type)._to_string()		));
+				keyDoc.append(kvp("Site",	str		+ acsConfig.mongo_suffix + suffix		));
+				keyDoc.append(kvp("Sat",	sat		+ acsConfig.mongo_suffix + suffix		));
+				keyDoc.append(kvp("State",	state											));
 			}
 			
-			bsoncxx::builder::basic::document valDoc = {};
-			valDoc.append(kvp("x"	+ std::to_string(key.num),		pseudoIndex ? true : kfState.x	(index)			));
-			valDoc.append(kvp("dx"	+ std::to_string(key.num),		pseudoIndex ? true : kfState.dx	(index)			));
-			valDoc.append(kvp("P"	+ std::to_string(key.num),		pseudoIndex ? true : kfState.P	(index,index)	));
+			if	(  pseudoIndex == false
+				&& upsert == false)
+			{
+				keyDoc.append(bsoncxx::builder::concatenate(valDoc.view()));
+				
+				queueInsert(ops, collectionName, keyDoc.extract());
+				
+				continue;
+			}
 			
 			string setType;
 			
@@ -432,24 +632,13 @@ void mongoStates(
 			bsoncxx::builder::basic::document valThing = {};
 			valThing.append(kvp(setType,		valDoc));
 			
-			mongocxx::model::update_one  mongo_req(
+			queueUpsert(ops, collectionName,
 				keyDoc	.extract(),
 				valThing.extract());
-			
-			update = true;
-
-			mongo_req.upsert(true);
-			bulk.append(mongo_req);
-			
-			
-		}
-
-		if (update)
-		{
-			Instrument instrument("execution");
-			bulk.execute();
 		}
 	}
+	
+	mongoWriter.push(ops);
 }
 
 void mongoCull(
@@ -491,22 +680,7 @@ void mongoOutput(
 		return;
 	}
 
-	Mongo& mongo = *mongo_ptr;
-
-	auto 						c		= mongo.pool.acquire();
-	mongocxx::client&			client	= *c;
-	mongocxx::database			db		= client[acsConfig.mongo_database];
-	mongocxx::collection		coll	= db[SSR_DB];
-
-	mongocxx::options::update	options;
-	options.upsert(true);
-
-	mongocxx::options::bulk_write bulk_opts;
-	bulk_opts.ordered(false);
-
-	auto bulk = coll.create_bulk_write(bulk_opts);
-
-	bool update = false;
+	vector<MongoWriteOp> ops;
 
     using bsoncxx::builder::basic::kvp;
 	
@@ -534,16 +708,37 @@ void mongoOutput(
 		Vals.append(kvp("$set", vals));
 			
 // 		std::cout << "\n" << bsoncxx::to_json(keys.view()) << bsoncxx::to_json(Vals.view()) << "\n";
-			
-		mongocxx::model::update_one  mongo_req{keys.view(), Vals.view()};
 		
-		update = true;
-		mongo_req.upsert(true);
-		bulk.append(mongo_req);
+		queueUpsert(ops, SSR_DB, keys.extract(), Vals.extract());
 	}
-		
-	if (update)
-		bulk.execute();
+	
+	mongoWriter.push(ops);
+}
+
+/** Add a phase bias estimated by the filter to the products published for uploading, with the same indicators as are written to the database
+*/
+void publishKalmanPhaseBias(
+	SsrSatProducts&	ssrProducts,	///< Products for the satellite
+	GTime			time,			///< Time of current epoch
+	E_ObsCode		obsCode,		///< Signal of the bias
+	double			bias,			///< Bias value
+	double			bvar)			///< Bias variance
+{
+	auto& phasBias = ssrProducts.phasBiasMap[time];
+	phasBias.t0 = time;
+	
+	auto& ssrPhase = phasBias.ssrPhase;
+	ssrPhase.dispBiasConistInd	= 0;
+	ssrPhase.MWConistInd		= 1;
+	ssrPhase.yawAngle			= 0;
+	ssrPhase.yawRate			= 0;
+	
+	auto& ssrPhaseCh = phasBias.ssrPhaseChs[obsCode];
+	ssrPhaseCh.signalIntInd		= 1;
+	ssrPhaseCh.signalWidIntInd	= 2;
+	ssrPhaseCh.signalDisconCnt	= 0;
+	
+	phasBias.obsCodeBiasMap[obsCode] = {bias, bvar};
 }
 
 void	prepareSsrStates(
@@ -551,7 +746,8 @@ void	prepareSsrStates(
 	KFState&			kfState,		///< Filter object to extract state elements from
 	GTime 				time)			///< Time of current epoch
 {
-	list<DBEntry>	dbEntryList;
+	list<DBEntry>					dbEntryList;
+	map<SatSys, SsrSatProducts>		ssrProductsMap;		///< Same values as the database entries, for uploading streams in this process
 	
 	for (int i = 0; i < E_Sys::_size(); i++)
 	{
@@ -570,7 +766,8 @@ void	prepareSsrStates(
 			Obs obs;
 			obs.Sat = Sat;
 			
-			auto& satNav = nav.satNavMap[obs.Sat];
+			auto& satNav		= nav.satNavMap[obs.Sat];
+			auto& ssrProducts	= ssrProductsMap[Sat];
 			SatStat satStatDummy;
 			
 			obs.satStat_ptr	= &satStatDummy;
@@ -671,6 +868,12 @@ void	prepareSsrStates(
 					entry.intMap	[SSR_IODE			]	= {iode,			false};
 					
 					dbEntryList.push_back(entry);
+					
+					auto& clkValues = ssrProducts.clkMap[pTime];
+					clkValues.time		= pTime;
+					clkValues.iode		= iode;
+					clkValues.brdcClk	= brdcClkVal;
+					clkValues.precClk	= precClkVal;
 				}
 				
 				{
@@ -687,6 +890,14 @@ void	prepareSsrStates(
 					entry.intMap	[SSR_IODE			]	= {iode,			false};
 				
 					dbEntryList.push_back(entry);
+					
+					auto& ephValues = ssrProducts.ephMap[pTime];
+					ephValues.time		= pTime;
+					ephValues.iode		= iode;
+					ephValues.brdcPos	= brdcPos;
+					ephValues.brdcVel	= brdcVel;
+					ephValues.precPos	= precPos;
+					ephValues.precVel	= precVel;
 				}
 			}
 			
@@ -715,6 +926,10 @@ void	prepareSsrStates(
 						entry.timeMap	[SSR_UPDATED	]	= {time,					false};
 					
 						dbEntryList.push_back(entry);
+						
+						auto& ssrCodeBias = ssrProducts.codeBiasMap[time];
+						ssrCodeBias.t0						= time;
+						ssrCodeBias.obsCodeBiasMap[obsCode]	= {-bias, bvar};
 					}
 					
 					break;
@@ -741,6 +956,10 @@ void	prepareSsrStates(
 						entry.timeMap	[SSR_UPDATED	]	= {time,					false};
 					
 						dbEntryList.push_back(entry);
+						
+						auto& cachedCodeBias = ssrProducts.codeBiasMap[ssrCodeBias.t0];
+						cachedCodeBias.t0						= ssrCodeBias.t0;
+						cachedCodeBias.obsCodeBiasMap[obsCode]	= biasVar;
 					}
 					
 					break;
@@ -781,6 +1000,12 @@ void	prepareSsrStates(
 						entry.intMap	["signalDisconCnt"  ]	= {ssrPhaseChs[obsCode].signalDisconCnt,	false};
 					
 						dbEntryList.push_back(entry);
+						
+						auto& cachedPhasBias = ssrProducts.phasBiasMap[ssrPhasBias.t0];
+						cachedPhasBias.t0						= ssrPhasBias.t0;
+						cachedPhasBias.ssrPhase					= ssrPhase;
+						cachedPhasBias.obsCodeBiasMap	[obsCode]	= biasVar;
+						cachedPhasBias.ssrPhaseChs		[obsCode]	= ssrPhaseChs[obsCode];
 					}
 					
 					break;
@@ -813,6 +1038,8 @@ void	prepareSsrStates(
 						entry.intMap	["signalDisconCnt"  ]	= {0,					false};
 						
 						dbEntryList.push_back(entry);
+						
+						publishKalmanPhaseBias(ssrProducts, time, obsCode, bias, bvar);
 					}
 				
 					if (queryBiasOutput(trace, Sat, E_AmbTyp::UCL2, bias, bvar))
@@ -837,6 +1064,8 @@ void	prepareSsrStates(
 						entry.intMap	["signalDisconCnt"  ]	= {0,					false};
 						
 						dbEntryList.push_back(entry);
+						
+						publishKalmanPhaseBias(ssrProducts, time, obsCode, bias, bvar);
 					}
 					
 					break;
@@ -845,6 +1074,8 @@ void	prepareSsrStates(
 		}
 	}
 	
+	ssrProductCache.publish(time, ssrProductsMap);
+	
 	if (acsConfig.output_mongo_rtcm_messages)
 	{
 		BOOST_LOG_TRIVIAL(debug)
@@ -3,14 +3,68 @@
 #define ___WRITEMONGO_HPP__
 
 
+#include <condition_variable>
+#include <optional>
+#include <thread>
+#include <deque>
+#include <mutex>
 #include <set>
 
+using std::deque;
 using std::set;
 
 #include "satSys.hpp"
 #include "mongo.hpp"
 
 
+/** Write operation queued for the database writer
+*/
+struct MongoWriteOp
+{
+	string										collection;
+	bsoncxx::document::value					document;		///< Document to insert, or filter selecting the document to upsert
+	std::optional<bsoncxx::document::value>		update;			///< Update to upsert with, documents without updates are inserted
+};
+
+/** Background writer for database outputs.
+* Outputs are queued by the processing threads and written by a single thread in large unordered bulk writes,
+* so that a slow database never adds latency to the filter. When the queue is full new outputs are dropped rather than waited for.
+*/
+struct MongoWriter
+{
+	std::mutex					mutex;
+	std::condition_variable		notEmpty;
+	deque<MongoWriteOp>			queue;
+	std::thread					thread;
+	bool						stopping	= false;
+	bool						dropping	= false;	///< The last operation queued was dropped
+
+	size_t						queued		= 0;		///< Number of operations accepted into the queue
+	size_t						written		= 0;		///< Number of operations written to the database
+	size_t						failed		= 0;		///< Number of operations rejected by the database
+	size_t						dropped		= 0;		///< Number of operations discarded because the queue was full
+	size_t						batches		= 0;		///< Number of batches taken from the queue
+	size_t						maxDepth	= 0;		///< Largest number of operations waiting in the queue
+
+	void start();
+	void stop();
+
+	~MongoWriter()
+	{
+		stop();
+	}
+
+	void push(
+		vector<MongoWriteOp>&	ops);
+
+	void run();
+
+	void outputStatistics(
+		Trace&	trace);
+};
+
+extern MongoWriter mongoWriter;
+
 struct TestStatistics
 {
 	int		numMeas				= 0;
@@ -39,7 +93,8 @@ void mongoMeasComponents(
 
 void mongoStates(
 	KFState&			kfState,
-	string				suffix = "");
+	string				suffix = "",
+	bool				upsert = true);
 
 void mongoMeasSatStat(
 	StationMap&			stationMap);
@@ -10,7 +10,13 @@
 
 #include <unordered_map>
 #include <unordered_set>
+#include <functional>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <cmath>
 #include <string>
+#include <vector>
 #include <list>
 #include <map>
 #include <set>
@@ -18,6 +24,7 @@
 using std::unordered_set;
 using std::unordered_map;
 using std::string;
+using std::vector;
 using std::list;
 using std::map;
 using std::set;
@@ -39,7 +46,165 @@ using std::set;
 #define MAXDTE      900.0           /* max time difference to ephem time (s) */
 
 typedef map<GTime, Peph>	PephList;
-typedef list<Pclk>			PclkList;
+
+/** Precise clock records of a single satellite or receiver, stored contiguously in time order.
+* Clocks are usually regularly sampled, so the record for a time is found by indexing directly from the first record,
+* and consecutive queries, which usually move forward in time, are checked against the position of the previous result first.
+* Irregular records fall back to a binary search.
+*/
+struct PclkList
+{
+	vector<Pclk>	records;
+	double			interval	= 0;		///< Typical spacing of records (s), 0 if unknown
+	bool			finalised	= true;		///< Records are in time order and the interval is current
+	size_t			cursor		= 0;		///< Result of the previous search, only used as a hint
+
+	void push_back(
+		const Pclk&	pclk)
+	{
+		records.push_back(pclk);
+		finalised = false;
+	}
+
+	/** Sort the records and determine their typical spacing, must be called after records are added
+	*/
+	void finalise()
+	{
+		if (finalised)
+		{
+			return;
+		}
+
+		auto earlier = [](const Pclk& a, const Pclk& b)
+		{
+			return a.time < b.time;
+		};
+
+		if (std::is_sorted(records.begin(), records.end(), earlier) == false)
+		{
+			std::stable_sort(records.begin(), records.end(), earlier);
+		}
+
+		vector<double> spacings;
+		spacings.reserve(records.size());
+		for (size_t i = 1; i < records.size(); i++)
+		{
+			double spacing = records[i].time - records[i-1].time;
+			if (spacing > 0)
+			{
+				spacings.push_back(spacing);
+			}
+		}
+
+		interval = 0;
+		if (spacings.empty() == false)
+		{
+			auto median = spacings.begin() + spacings.size() / 2;
+			std::nth_element(spacings.begin(), median, spacings.end());
+			interval = *median;
+		}
+
+		cursor		= 0;
+		finalised	= true;
+	}
+
+	size_t size() const
+	{
+		return records.size();
+	}
+
+	const Pclk& front() const	{	return records.front();	}
+	const Pclk& back() const	{	return records.back();	}
+
+	/** Returns the index of the first record at or after a time, or of the last record if there are none after it.
+	* The cursor is shared between threads, but any value is a valid hint, so it is only accessed atomically without ordering
+	*/
+	size_t find(
+		GTime	time)
+	{
+		size_t num = records.size();
+		if (num == 0)
+		{
+			return 0;
+		}
+
+		auto isResult = [&](size_t i)
+		{
+			return	( (i == 0		|| records[i-1].time	< time)
+					&&(i == num - 1	|| records[i].time		>= time));
+		};
+
+		std::atomic_ref<size_t> cursorRef(cursor);
+
+		//try the previous result, and the one after it
+		size_t hint = cursorRef.load(std::memory_order_relaxed);
+		for (size_t i = hint; i < hint + 2 && i < num; i++)
+		{
+			if (isResult(i))
+			{
+				cursorRef.store(i, std::memory_order_relaxed);
+				return i;
+			}
+		}
+
+		size_t index = num;
+
+		//try the bucket for a regularly sampled list
+		if (interval > 0)
+		{
+			double offset = (time - records.front().time) / interval;
+			if		(offset <= 0)			index = 0;
+			else if	(offset >= num - 1)		index = num - 1;
+			else							index = ceil(offset);
+
+			if (isResult(index) == false)
+			{
+				index = num;
+			}
+		}
+
+		if (index == num)
+		{
+			auto it = std::lower_bound(records.begin(), records.end(), time, [](const Pclk& pclk, const GTime& time)
+			{
+				return pclk.time < time;
+			});
+
+			index = std::min((size_t) (it - records.begin()), num - 1);
+		}
+
+		cursorRef.store(index, std::memory_order_relaxed);
+		return index;
+	}
+};
+
+/** Interpolation nodes of a window of precise ephemerides, relative to a reference time.
+* Satellites in the same sp3 file have ephemerides at the same times, so the barycentric weights and earth rotation corrections,
+* which depend only on the node times, are computed once and shared by all of them.
+*/
+struct PephGrid
+{
+	VectorXd	nodes;					///< Times of the ephemerides relative to the reference time (s)
+	VectorXd	weights;				///< Barycentric weights of the nodes
+	VectorXd	sinl;					///< Sine of the earth rotation angle at each node
+	VectorXd	cosl;					///< Cosine of the earth rotation angle at each node
+};
+
+/** Interpolating polynomial through a window of precise ephemerides, in barycentric form.
+* Computed once per satellite per epoch, and evaluated at the signal transmission time of each receiver.
+*/
+struct PephPolynomial
+{
+	bool								valid		= false;
+	GTime								t0;						///< Reference time that nodes are relative to, and that positions are rotated to
+	std::shared_ptr<PephGrid>			grid_ptr;				///< Nodes of the window, possibly shared with other satellites
+	Matrix<double, 3, Eigen::Dynamic>	positions;				///< Earth-rotation corrected positions at each node, one per column (m)
+
+	double								bracketStart;			///< Times after this, relative to t0, use the same window and ephemerides (s)
+	double								bracketEnd;				///< Times up to this, relative to t0, use the same window and ephemerides (s)
+	const Peph*							middle0_ptr	= nullptr;	///< Ephemeris before the end of the bracket, used for clocks
+	const Peph*							middle1_ptr	= nullptr;	///< Ephemeris at the end of the bracket, used for accuracy and clocks
+};
 
 struct TECPoint
 {
@@ -98,6 +263,7 @@ struct Navigation
 	map<GTime,		tec_t,											std::greater<GTime>>	 tecMap;	/* tec grid data */
 	
 	map<int,		SatNav>																  satNavMap;
+	map<int,		PephPolynomial>															pephPolynomialMap;	/* precise orbit interpolation for the current epoch */
 	
 // 	list<fcbd_t> 		fcbList;        /* satellite fcb data */
 	vmf3_t	vmf3	= {.m = 1};
@@ -134,6 +300,62 @@ namespace boost::serialization
 }
 
 
+/** Modifications to the navigation data that have been decoded while inputs are read on a separate thread.
+* Requests are recorded in order by the input thread and applied by the estimator before the epoch they were synced with,
+* so that the navigation data is never modified while it is in use, and the input thread need not wait for the estimator.
+*/
+struct NavRequests
+{
+	list<std::function<void()>>	requestList;		///< Deferred modifications, in the order they were decoded
+
+	static thread_local NavRequests*	active_ptr;	///< Buffer that modifications from this thread are redirected to, if any
+
+	/** Apply a modification to the navigation data now, or defer it if this thread is redirecting its modifications
+	*/
+	static void modify(
+		std::function<void()>	modification)	///< Function that modifies the navigation data
+	{
+		if (active_ptr)
+		{
+			active_ptr->requestList.push_back(std::move(modification));
+			return;
+		}
+
+		modification();
+	}
+
+	/** Apply all deferred modifications, in the order they were decoded
+	*/
+	void apply()
+	{
+		for (auto& request : requestList)
+		{
+			request();
+		}
+
+		requestList.clear();
+	}
+};
+
+/** Redirects modifications of the navigation data made by this thread into a request buffer for the lifetime of this object
+*/
+struct DeferNavRequests
+{
+	NavRequests*	previous_ptr;
+
+	DeferNavRequests(
+		NavRequests&	requests)
+	{
+		previous_ptr				= NavRequests::active_ptr;
+		NavRequests::active_ptr		= &requests;
+	}
+
+	~DeferNavRequests()
+	{
+		NavRequests::active_ptr		= previous_ptr;
+	}
+};
+
 extern map<E_Sys, E_NavMsgType> defNavMsgType;
 
 extern	Navigation	nav;
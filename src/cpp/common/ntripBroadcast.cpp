@@ -9,6 +9,7 @@ using bsoncxx::builder::basic::kvp;
 #include "ntripBroadcast.hpp"
 #include "acsStream.hpp"
 #include "mongoRead.hpp"
+#include "ssrCache.hpp"
 #include "fileLog.hpp"
 #include "gTime.hpp"
 
@@ -29,9 +30,22 @@ ptime round_to(
     return { t.date(), period*units };
 }
 
+/** Start the thread that encodes messages for uploading streams
+*/
 void NtripBroadcaster::startBroadcast()
 {
-	NtripSocket::startClients();
+	if (encoderStarted)
+	{
+		return;
+	}
+	
+	encoderStarted = true;
+	
+	std::thread([this]()
+		{
+			B_asio::io_service::work work(encoderService);
+			encoderService.run();
+		}).detach();
 }
 
 void NtripBroadcaster::stopBroadcast()
@@ -42,6 +56,8 @@ void NtripBroadcaster::stopBroadcast()
 	}
 	
 	ntripUploadStreams.clear();
+	
+	encoderService.stop();
 }
 
 void NtripUploader::serverResponse(
@@ -75,17 +91,51 @@ void NtripUploader::serverResponse(
 void NtripUploader::write_handler(
 	const boost::system::error_code& err)
 {
+	writeInProgress = false;
+	
 	if (err)
 	{
 		outMessages.consume(outMessages.size());
-		outMessagesMtx.unlock();
+		pendingMessages.clear();
 		
 		ERROR_OUTPUT_RECONNECT_AND_RETURN;
 	}
 	
 	onChunkSentStatistics();
 	
-	outMessagesMtx.unlock();
+	if (pendingMessages.empty() == false)
+	{
+		startWrite();
+	}
+}
+
+/** Write all pending chunks to the socket
+*/
+void NtripUploader::startWrite()
+{
+	std::ostream outStream(&outMessages);
+	outStream.write(pendingMessages.data(), pendingMessages.size());
+	
+	pendingMessages.clear();
+	
+	writeInProgress = true;
+	
+	if (url.protocol == "https")	{	boost::asio::async_write(*_sslsocket,	outMessages, strand.wrap(boost::bind(&NtripUploader::write_handler, this, bp::error)));}
+	else							{	boost::asio::async_write(*_socket,		outMessages, strand.wrap(boost::bind(&NtripUploader::write_handler, this, bp::error)));}
+}
+
+/** Queue an encoded chunk for writing, starting a write if none is in progress.
+* Runs on the socket's strand
+*/
+void NtripUploader::sendChunk(
+	const string&	chunk)		///< Chunk, including its chunked encoding header and trailer
+{
+	pendingMessages += chunk;
+	
+	if (writeInProgress == false)
+	{
+		startWrite();
+	}
 }
 
 void NtripUploader::messageTimeout_hanlder(
@@ -107,7 +157,7 @@ void NtripUploader::messageTimeout_hanlder(
 		auto then = round_to(now, boost::posix_time::seconds(period));
 		then += boost::posix_time::seconds(period);
 		sendTimer.expires_at(then);
-		sendTimer.async_wait(boost::bind(&NtripUploader::messageTimeout_hanlder, this, bp::error));
+		sendTimer.async_wait(strand.wrap(boost::bind(&NtripUploader::messageTimeout_hanlder, this, bp::error)));
 	}
 	
 	
@@ -117,7 +167,6 @@ void NtripUploader::messageTimeout_hanlder(
 	if (ssrMeta.ssrUpdateIntIndex == -1)
 		BOOST_LOG_TRIVIAL(error) << "Error: ssrMeta.ssrUpdateIntIndex is not valid :" << ssrMeta.ssrUpdateIntIndex << ").";
 	
-	GTime nowTime = timeget();
 	GTime targetTime;
 	{
 		int		week;
@@ -135,8 +184,29 @@ void NtripUploader::messageTimeout_hanlder(
 	
 	ssrMeta.provider			= streamConfig.provider_id;
 	ssrMeta.provider			= streamConfig.solution_id;
+	
+	//retrieving products and encoding is done by the encoder thread, which hands the finished chunk back to this socket's strand
+	auto uploader_ptr = shared_from_this();
+	
+	ntripBroadcaster.encoderService.post([uploader_ptr, targetTime, ssrMeta, period]()
+		{
+			uploader_ptr->encodeMessages(targetTime, ssrMeta, period);
+		});
+}
+
+/** Retrieve the products for the requested messages and encode them into a chunk for uploading.
+* Runs on the encoder thread
+*/
+void NtripUploader::encodeMessages(
+	GTime	targetTime,		///< Time the messages are for
+	SSRMeta	ssrMeta,		///< Metadata for the messages
+	int		period)			///< Update interval of the stream
+{
 	int masterIod 				= streamConfig.master_iod;
 	
+	//products calculated by this process are published to the cache, otherwise they are written to the database by another
+	bool useCache = acsConfig.ssrOpts.calculate_ssr;
+	
 	for (auto RtcmMess : streamConfig.rtcmMessagesTypes)
 	{
 		if (RtcmMess == *streamConfig.rtcmMessagesTypes.rbegin())
@@ -162,7 +232,9 @@ void NtripUploader::messageTimeout_hanlder(
 			case +RtcmMessageType::GAL_SSR_PHASE_BIAS:
 			case +RtcmMessageType::GPS_SSR_PHASE_BIAS:
 			{
-				auto ssrPBMap = mongoReadPhaseBias(targetTime, ssrMeta, masterIod, sys);
+				SsrPBMap ssrPBMap;
+				if (useCache)	ssrPBMap = cacheReadPhaseBias(targetTime, ssrMeta, masterIod, sys);
+				else			ssrPBMap = mongoReadPhaseBias(targetTime, ssrMeta, masterIod, sys);
 				
 				auto buffer = encodeSsrPhase(ssrPBMap);	
 				bool write = encodeWriteMessageToBuffer(buffer);
@@ -177,7 +249,9 @@ void NtripUploader::messageTimeout_hanlder(
 			case +RtcmMessageType::GAL_SSR_CODE_BIAS:
 			case +RtcmMessageType::GPS_SSR_CODE_BIAS:
 			{
-				auto ssrCBMap = mongoReadCodeBias(targetTime, ssrMeta, masterIod, sys);	
+				SsrCBMap ssrCBMap;
+				if (useCache)	ssrCBMap = cacheReadCodeBias(targetTime, ssrMeta, masterIod, sys);
+				else			ssrCBMap = mongoReadCodeBias(targetTime, ssrMeta, masterIod, sys);
 				
 				auto buffer = encodeSsrCode(ssrCBMap);
 				bool write = encodeWriteMessageToBuffer(buffer);
@@ -192,7 +266,9 @@ void NtripUploader::messageTimeout_hanlder(
 			case +RtcmMessageType::GAL_SSR_COMB_CORR:
 			case +RtcmMessageType::GPS_SSR_COMB_CORR:
 			{
-				auto ssrOutMap 	= mongoReadSSRData(targetTime, ssrMeta, masterIod, sys);
+				map<SatSys, SSROut> ssrOutMap;
+				if (useCache)	ssrOutMap = cacheReadSSRData(targetTime, ssrMeta, masterIod, sys);
+				else			ssrOutMap = mongoReadSSRData(targetTime, ssrMeta, masterIod, sys);
 
 				calculateSsrComb(targetTime, period, ssrMeta, masterIod, ssrOutMap);
 				
@@ -221,19 +297,17 @@ void NtripUploader::messageTimeout_hanlder(
 	BOOST_LOG_TRIVIAL(debug) << "Called " << __FUNCTION__ << " MessageLength : " << length << std::endl;
 	if (length != 0)
 	{
-		vector<char> data;
-		data.resize(length);
-		
-		outMessagesMtx.lock();
-		std::ostream chunkedStream(&outMessages);
+		std::stringstream chunkedStream;
 		chunkedStream << std::uppercase << std::hex << length << "\r\n";
-		
-		messStream		.read	(&data[0], length);
-		chunkedStream	.write	(&data[0], length);
+		chunkedStream << messStream.rdbuf();
 		chunkedStream << "\r\n";        
-	
-		if (url.protocol == "https")	{	boost::asio::async_write(*_sslsocket,	outMessages, boost::bind(&NtripUploader::write_handler, this, bp::error));}
-		else							{	boost::asio::async_write(*_socket,		outMessages, boost::bind(&NtripUploader::write_handler, this, bp::error));}
+		
+		auto uploader_ptr = shared_from_this();
+		
+		strand.post([uploader_ptr, chunk = chunkedStream.str()]()
+			{
+				uploader_ptr->sendChunk(chunk);
+			});
 	}
 }
 
@@ -242,7 +316,7 @@ void NtripUploader::startBroadcast()
 // 	BOOST_LOG_TRIVIAL(debug) << __FUNCTION__ << " Starting Send Loop.\n";
 
 	sendTimer.expires_from_now(boost::posix_time::seconds(1));
-	sendTimer.async_wait(boost::bind(&NtripUploader::messageTimeout_hanlder, this, bp::error));
+	sendTimer.async_wait(strand.wrap(boost::bind(&NtripUploader::messageTimeout_hanlder, this, bp::error)));
 }
 
 void NtripUploader::connected()
@@ -14,14 +14,14 @@
 #include "enums.h"
 
 
-struct NtripUploader : NtripSocket, RtcmEncoder
+struct NtripUploader : NtripSocket, RtcmEncoder, std::enable_shared_from_this<NtripUploader>
 {
 	boost::posix_time::ptime		timeNextMessage;
 	
-	// This mutex ensures that the main thread and the io_service thread do
-	// not alter the outMessages buffer at the same time.
-	std::mutex						outMessagesMtx;
-	boost::asio::streambuf			outMessages;
+	// The message buffers are only used by handlers running on this socket's strand.
+	boost::asio::streambuf			outMessages;						///< Chunks being written to the socket
+	string							pendingMessages;					///< Chunks encoded while a write was in progress
+	bool							writeInProgress			= false;
 	boost::asio::deadline_timer		sendTimer;
 	int 	numberChunksSent 		= 0;
 	
@@ -70,6 +70,16 @@ struct NtripUploader : NtripSocket, RtcmEncoder
 	void messageTimeout_hanlder(
 		const boost::system::error_code& err);
 	
+	void encodeMessages(
+		GTime	targetTime,
+		SSRMeta	ssrMeta,
+		int		period);
+	
+	void sendChunk(
+		const string&	chunk);
+	
+	void startWrite();
+	
 	void write_handler(
 		const boost::system::error_code& err);
 
@@ -86,6 +96,9 @@ struct NtripUploader : NtripSocket, RtcmEncoder
 
 struct NtripBroadcaster
 {
+	B_asio::io_service	encoderService;					///< Encodes messages for all uploaders, so that the sockets' threads never wait for products or encoding
+	bool				encoderStarted	= false;
+
 	void startBroadcast();
 	void stopBroadcast();
 
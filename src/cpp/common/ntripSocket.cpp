@@ -4,6 +4,8 @@
 #include "ntripSocket.hpp"
 
 #include <boost/system/error_code.hpp>
+#include <algorithm>
+#include <charconv>
 #include <list>
 
 namespace bp = boost::asio::placeholders;
@@ -59,11 +61,11 @@ void NtripSocket::start_read(
 	// Start reading remaining data until EOF.
 	if (url.protocol == "https")
 	{
-		boost::asio::async_read(*_sslsocket,	downloadBuf, boost::asio::transfer_at_least(1), boost::bind(function_ptr, this, bp::error));          
+		boost::asio::async_read(*_sslsocket,	downloadBuf, boost::asio::transfer_at_least(1), strand.wrap(boost::bind(function_ptr, this, bp::error)));          
 	}
 	else
 	{
-		boost::asio::async_read(*_socket,		downloadBuf, boost::asio::transfer_at_least(1), boost::bind(function_ptr, this, bp::error));
+		boost::asio::async_read(*_socket,		downloadBuf, boost::asio::transfer_at_least(1), strand.wrap(boost::bind(function_ptr, this, bp::error)));
 	}     
 }
 
@@ -101,140 +103,77 @@ void NtripSocket::read_handler_chunked(
 		ERROR_OUTPUT_RECONNECT_AND_RETURN;
 	}    
 	
-	// Note downloadBuf can be filled with data past the "\r\n" termination.
-	// We read whole lines only into receivedBuffer.
-	// Messages are chuncked NTRIP Version 2 see RCTM NTRIP document.
+	// Messages are chunked NTRIP Version 2 see RCTM NTRIP document.
 	
-	// The message should begin with the message header containing the length in hexadecimal
-	// ascii charaters followed by carriage return and line feed.
-	// "AE<CR><LF>", this routine recurses ancyronously searching the stream for a valid header.
-	// If there is error it starts searching again. Once a valided header is found it places
-	// the RTCM message in the buffer provided this can be done without error.
+	// Each message begins with a header containing the length of the body in hexadecimal
+	// ascii charaters, (optionally followed by an extension after a ';'), and a carriage return and line feed.
+	// "AE<CR><LF>", the body then follows, also terminated by "<CR><LF>".
 	
-	// The async_read invokes this function every time it reads "<CR><LF>", although
-	// it can read more data as so downloadBuf may not end with "<CR><LF>".
+	// Chunks are decoded in place from the download buffer, which may contain several chunks, or only part of one.
+	// Anything incomplete is left in the buffer until more data has been read.
 	
-	// If there is a problem with the chunking attempt is made to pass the message to the
-	// RTCM parser. The RTCM parser has further error checking and may recover some messages.
-	
-	vector<char> chunk;
-	std::istream messStream(&downloadBuf);
-	unsigned int sz = downloadBuf.size();
-	
-	char c_i;
-	char c_j;
-	unsigned int i = 0;
+	// If there is a problem with the chunking the data is skipped and the search for a valid header continues.
+	// The RTCM parser has further error checking and may recover some messages.
 	
 	onChunkReceivedStatistics();
 	
+	const char crlf[] = "\r\n";
+	
 	while (true)
 	{
+		auto		bufferData	= downloadBuf.data();
+		const char*	data		= static_cast<const char*>(bufferData.data());
+		size_t		size		= bufferData.size();
+		
 		if (chunked_message_length == 0)
 		{
-			chunk.clear();
-			messStream.read(&c_i,1);
-			chunk.push_back(c_i);
-			for (i++; i < sz; i++)
-			{
-				messStream.read(&c_j,1);
-				chunk.push_back(c_j);
-				if	(  c_i == '\r' 
-					&& c_j == '\n')
-				{
-					break;
-				}
-				c_i = c_j;
-			}
-		
-			if (i >= sz)
+			// Read the header with the message length.
+			const char* end_ptr = std::search(data, data + size, crlf, crlf + 2);
+			if (end_ptr == data + size)
 			{
-				//BOOST_LOG_TRIVIAL(debug) << "\nEnd of Buffer Reached Searching for Message Header Chunk.\n";
-				//BOOST_LOG_TRIVIAL(debug) << "downloadBuf.size() : " << downloadBuf.size() << std::endl;
-				//BOOST_LOG_TRIVIAL(debug) << "chunk.size()      : " << chunk.size() << std::endl;
-				//printChunkHex(chunk);
-				std::ostream outStream(&downloadBuf);
-				outStream.write(&chunk[0],chunk.size());
-				//BOOST_LOG_TRIVIAL(debug) << "messBuffer.size() : " << downloadBuf.size() << std::endl;
 				break;
-			}            
-
-			// Read the first chunk with the message length.
+			}
 			
-			// Put termination charater on string.
-			chunk.push_back(0);
-			string messStr(&chunk[0]);
-			messStr = messStr.substr(0, messStr.length()-2);
 			// NTRIP 2 allows for an extended header.
-			std::size_t ext = messStr.find(";");
-			if (ext != string::npos)
+			const char* ext_ptr = std::find(data, end_ptr, ';');
+			
+			unsigned int length = 0;
+			auto [ptr, ec] = std::from_chars(data, ext_ptr, length, 16);
+			
+			downloadBuf.consume(end_ptr + 2 - data);
+			
+			if	( ec != std::errc()
+				||ptr == data)
 			{
-				//BOOST_LOG_TRIVIAL(debug) << "Found Extension in Message Length : " << messStr << std::endl;
-				messStr = messStr.substr(0,ext);
+				logChunkError();
+				continue;
 			}
 			
-			try
+			// Check if message is too long and ignore it.
+			if (length > 1000000)
 			{
-				// Two is added for the termination charaters.
-				chunked_message_length = (unsigned int)std::stoi(messStr, 0, 16); 
-				//BOOST_LOG_TRIVIAL(debug) << "\nValid Message Length Chunk Found.\n";
-				//BOOST_LOG_TRIVIAL(debug) << "message chunk  : " << messStr << std::endl;
-				//BOOST_LOG_TRIVIAL(debug) << "message_length : " << chunked_message_length << std::endl;
-				//BOOST_LOG_TRIVIAL(debug) << "chunk.size()      : " << chunk.size() << std::endl;
-				//printChunkHex(chunk);                    
-				
-				
-				// Check if message is too long and set to zero.
-				if (chunked_message_length > 1000000)
-				{
-					//BOOST_LOG_TRIVIAL(warning) << "\nError Message Header, Body too Long.\n";
-					//printChunkHex(chunk);
-					logChunkError();
-					chunked_message_length = 0;
-				}
-				
-			}
-			catch (std::exception& e)
-			{  
-				//BOOST_LOG_TRIVIAL(warning) << "\nError Message Header, string not an integer.\n";
-				//BOOST_LOG_TRIVIAL(warning) << "chunk.size() : " << chunk.size() << std::endl;
-				//printChunkHex(chunk);
 				logChunkError();
-				chunked_message_length = 0;
-			}            
+				continue;
+			}
+			
+			chunked_message_length = length;
 		}
 		else
 		{
-			// Read the second chunk with the message.		//todo aaron, roll into the first one and clean up
-			
-			// Buffer position for the end of the message body chunk.
-			int bodyPos = i+chunked_message_length+2;
+			// Read the body of the message, along with its termination characters.
+			size_t bodyLength = chunked_message_length + 2;
 			
 			// There is not enough data to read the message body.
-			if (sz < bodyPos)
+			if (size < bodyLength)
 			{
-				//BOOST_LOG_TRIVIAL(warning) << "\nBuffer sz : " << sz << std::endl;
-				//BOOST_LOG_TRIVIAL(warning) << "Message end pos : " << bodyPos << std::endl;
-				//BOOST_LOG_TRIVIAL(warning) << "Message buffer not large enough exiting.\n";
 				break;
 			}
-				
-			// Copy message out of receive buffer.
-			chunk.clear();
-			for (; i < bodyPos; i++)
-			{
-				messStream.read(&c_i,1);
-				chunk.push_back(c_i);
-			}                
 			
 			// Check the last two characters are '\r' and '\n' to complete chunk.
-			if	(  chunk[chunked_message_length]	== '\r' 
-				&& chunk[chunked_message_length+1]	== '\n')
+			if	(  data[chunked_message_length]		== '\r' 
+				&& data[chunked_message_length+1]	== '\n')
 			{
-				// Remove the '\r\n' from the data vector.
-				chunk.pop_back();
-				chunk.pop_back();
-				
-				finishedReadingStream = dataChunkDownloaded(chunk);
+				finishedReadingStream = dataChunkDownloaded(data, chunked_message_length);
 				if (finishedReadingStream)
 				{
 					disconnect();
@@ -245,22 +184,11 @@ void NtripSocket::read_handler_chunked(
 			else
 			{
 				logChunkError();
-				
-				/*
-				BOOST_LOG_TRIVIAL(warning) << "\nMissing Termination of Chunk Message.\n";
-				BOOST_LOG_TRIVIAL(warning) << "message_length : " << message_length << std::endl;
-				BOOST_LOG_TRIVIAL(warning) << "chunk.size() : " << chunk.size() << std::endl;
-				printChunkHex(chunk);
-				BOOST_LOG_TRIVIAL(warning) << "chunk[message_length]   : ";
-				printf("%02x\n",(unsigned char)chunk[message_length]);
-				BOOST_LOG_TRIVIAL(warning) << "chunk[message_length+1] : ";
-				printf("%02x\n",(unsigned char)chunk[message_length+1]);
-				*/
 			}
 			
-			//BOOST_LOG_TRIVIAL(debug) << "\nProcessed Chunk Body.\n";
-			//BOOST_LOG_TRIVIAL(debug) << "chunk.size() : " << chunk.size() << std::endl;
-			chunked_message_length = 0;           
+			downloadBuf.consume(bodyLength);
+			
+			chunked_message_length = 0;
 		}
 	}
 	
@@ -330,7 +258,7 @@ void NtripSocket::delayed_reconnect()
 	//wait a little longer next time;
 	reconnectDelay *= 2;
 	
-	timer.async_wait(boost::bind(&NtripSocket::reconnect_timer_handler, this, bp::error));       
+	timer.async_wait(strand.wrap(boost::bind(&NtripSocket::reconnect_timer_handler, this, bp::error)));       
 }
 
 void NtripSocket::request_response_handler(
@@ -437,16 +365,16 @@ void NtripSocket::write_request_handler(
 	
 	//prepare a timeout because the read_until call doesnt seem to return on bad requests.
 	timer.expires_from_now(boost::posix_time::seconds(10));
-	timer.async_wait(boost::bind(&NtripSocket::timeout_handler, this, bp::error));    
+	timer.async_wait(strand.wrap(boost::bind(&NtripSocket::timeout_handler, this, bp::error)));    
 	
 	// Read the response status line.
 	if (url.protocol == "https")
 	{
-		boost::asio::async_read_until(*_sslsocket,	downloadBuf, "\r\n\r\n", boost::bind(&NtripSocket::request_response_handler, this, bp::error));            
+		boost::asio::async_read_until(*_sslsocket,	downloadBuf, "\r\n\r\n", strand.wrap(boost::bind(&NtripSocket::request_response_handler, this, bp::error)));            
 	}
 	else
 	{
-		boost::asio::async_read_until(*_socket,		downloadBuf, "\r\n\r\n", boost::bind(&NtripSocket::request_response_handler, this, bp::error));
+		boost::asio::async_read_until(*_socket,		downloadBuf, "\r\n\r\n", strand.wrap(boost::bind(&NtripSocket::request_response_handler, this, bp::error)));
 	}
 }  
 
@@ -461,7 +389,7 @@ void NtripSocket::sslhandshake_handler(
 	//BOOST_LOG_TRIVIAL(debug) << "SSL Handshake Completed.\n";
 
 	// The connection was successful. Send the request.
-	boost::asio::async_write(*_sslsocket, request, boost::bind(&NtripSocket::write_request_handler, this, bp::error));   
+	boost::asio::async_write(*_sslsocket, request, strand.wrap(boost::bind(&NtripSocket::write_request_handler, this, bp::error)));   
 }
 
 void NtripSocket::connect_handler(
@@ -474,7 +402,7 @@ void NtripSocket::connect_handler(
 		{
 			// The connection failed. Try the next endpoint in the list.
 			tcp::endpoint endpoint = *endpoint_iterator;
-			socket_ptr->async_connect(*endpoint_iterator, boost::bind(&NtripSocket::connect_handler, this, bp::error, ++endpoint_iterator));
+			socket_ptr->async_connect(*endpoint_iterator, strand.wrap(boost::bind(&NtripSocket::connect_handler, this, bp::error, ++endpoint_iterator)));
 			
 			return;
 		}
@@ -490,13 +418,13 @@ void NtripSocket::connect_handler(
 	
 	if (url.protocol == "https")
 	{
-		_sslsocket->async_handshake(boost::asio::ssl::stream_base::client, boost::bind(&NtripSocket::sslhandshake_handler, this, bp::error));
+		_sslsocket->async_handshake(boost::asio::ssl::stream_base::client, strand.wrap(boost::bind(&NtripSocket::sslhandshake_handler, this, bp::error)));
 		
 		return;    
 	}
 
 	// The connection was successful. Send the request.
-	boost::asio::async_write(*_socket, request, boost::bind(&NtripSocket::write_request_handler, this, bp::error));
+	boost::asio::async_write(*_socket, request, strand.wrap(boost::bind(&NtripSocket::write_request_handler, this, bp::error)));
 }
 
 
@@ -516,7 +444,7 @@ void NtripSocket::resolve_handler(
 	// will be tried until we successfully establish a connection.
 
 	tcp::endpoint endpoint = *endpoint_iterator;
-	socket_ptr->async_connect(endpoint, boost::bind(&NtripSocket::connect_handler, this, bp::error, ++endpoint_iterator));
+	socket_ptr->async_connect(endpoint, strand.wrap(boost::bind(&NtripSocket::connect_handler, this, bp::error, ++endpoint_iterator)));
 }
 
 
@@ -543,7 +471,7 @@ void NtripSocket::connect()
 	//tcp::resolver::query query(url.host, url.port_str, boost::asio::ip::resolver_query_base::numeric_service);
 	tcp::resolver::query		query(boost::asio::ip::tcp::v4(), url.host, url.port_str);
 	
-	_resolver->async_resolve(query, boost::bind(&NtripSocket::resolve_handler, this, bp::error, bp::iterator));
+	_resolver->async_resolve(query, strand.wrap(boost::bind(&NtripSocket::resolve_handler, this, bp::error, bp::iterator)));
 }
 
 void NtripSocket::disconnect()
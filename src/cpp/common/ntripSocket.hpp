@@ -195,6 +195,7 @@ protected:
 	string response_string;
 	
 	boost::asio::deadline_timer		timer;
+	B_asio::io_service::strand		strand;				///< Serialises the handlers of this socket when the service is run on multiple threads
 	
 	boost::asio::streambuf			request;
 	boost::asio::streambuf			downloadBuf;
@@ -216,6 +217,7 @@ public:
 	
 	NtripSocket(const string& url_str) : 
 		timer(io_service),
+		strand(io_service),
 		ssl_context(ssl::context::sslv23_client)
 	{
 		url			= URL::parse(url_str);	
@@ -258,7 +260,8 @@ public:
 	
 	//content from a stream has been received - process it in virtual functions from other classes
 	virtual bool dataChunkDownloaded(
-		vector<char> dataChunk)
+		const char*	dataChunk,
+		size_t		length)
 	{
 		return false;
 	}
@@ -310,9 +313,16 @@ public:
 		io_service.run();
 	}
 	
-	static void startClients()
+	/** Start the threads that service all sockets.
+	* Each socket runs its handlers through its own strand, so sockets are serviced in parallel but each is only used by one thread at a time
+	*/
+	static void startClients(
+		int	numThreads = 1)		///< Number of threads to run the service on
 	{
-		std::thread(NtripSocket::runService).detach();
+		for (int i = 0; i < std::max(1, numThreads); i++)
+		{
+			std::thread(NtripSocket::runService).detach();
+		}
 	}   
 };
 
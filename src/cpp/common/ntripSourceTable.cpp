@@ -89,9 +89,10 @@ vector<string> NtripSourceTable::getStreamMounts()
 
 
 bool NtripSourceTable::dataChunkDownloaded(
-	vector<char> dataChunk)
+	const char*	dataChunk,
+	size_t		length)
 {
-	sourceTableString.assign(dataChunk.begin(), dataChunk.end());
+	sourceTableString.assign(dataChunk, length);
 	
 
 	//BOOST_LOG_TRIVIAL(debug) << sourceTableString;
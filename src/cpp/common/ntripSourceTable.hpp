@@ -41,7 +41,8 @@ private:
 	void connected() override;
 	
 	bool dataChunkDownloaded(
-		vector<char> dataChunk) override; 
+		const char*	dataChunk,
+		size_t		length) override; 
 		
 	void readContentDownloaded(
 		vector<char> content) override;
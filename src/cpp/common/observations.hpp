@@ -1,12 +1,15 @@
 #ifndef __OBSERVATIONS_HPP_
 #define __OBSERVATIONS_HPP_
 
+#include <utility>
 #include <vector>
 #include <string>
+#include <array>
 #include <list>
 #include <map>
 
 using std::vector;
+using std::array;
 using std::string;
 using std::list;
 using std::map;
@@ -62,6 +65,158 @@ struct Sig : RawSig
 	double	biases[NUM_MEAS_TYPES] = {std::nan("")};
 };
 
+#define NUM_FREQ_SLOTS 16
+
+/** Position of a frequency type within a FreqMap.
+* Slots are in order of increasing frequency type, so that iteration order matches that of an ordered map.
+* Values outside the enumeration share the final slot.
+*/
+inline int freqSlot(
+	E_FType	ft)
+{
+	switch (ft)
+	{
+		case FTYPE_NONE:	return 0;
+		case F1:			return 1;
+		case F2:			return 2;
+		case F3:			return 3;
+		case F4:			return 4;
+		case F5:			return 5;
+		case F6:			return 6;
+		case F7:			return 7;
+		case F8:			return 8;
+		case B3:			return 9;
+		case FTYPE_IF12:	return 10;
+		case FTYPE_IF15:	return 11;
+		case FTYPE_IF25:	return 12;
+		case G1:			return 13;
+		case G2:			return 14;
+		default:			return 15;
+	}
+}
+
+/** Fixed capacity map of values keyed by frequency type, stored inline.
+* Replaces map<E_FType, T> within observations, which required a heap allocation for every signal of every observation, every epoch.
+*
+* Provides the subset of the std::map interface used for signals, with the same semantics:
+* operator[] inserts default values, iteration is in order of frequency type, and references remain valid until the element is erased.
+*/
+template<typename T>
+struct FreqMap
+{
+	typedef std::pair<E_FType, T>	value_type;
+
+	array<value_type, NUM_FREQ_SLOTS>	slots		= {};
+	unsigned int						usedMask	= 0;		///< Bit set for each slot that contains an element
+
+	template<typename MAP, typename VALUE>
+	struct Iterator
+	{
+		MAP*	map_ptr;
+		int		slot;
+
+		Iterator(
+			MAP*	map_ptr,
+			int		slot)
+		:	map_ptr	(map_ptr),
+			slot	(slot)
+		{
+			skipUnused();
+		}
+
+		void skipUnused()
+		{
+			while	( slot < NUM_FREQ_SLOTS
+					&&(map_ptr->usedMask & (1u << slot)) == 0)
+			{
+				slot++;
+			}
+		}
+
+		VALUE& operator*()	const	{	return map_ptr->slots[slot];	}
+		VALUE* operator->()	const	{	return &map_ptr->slots[slot];	}
+
+		Iterator& operator++()
+		{
+			slot++;
+			skipUnused();
+			return *this;
+		}
+
+		bool operator == (const Iterator& b) const	{	return slot == b.slot;	}
+		bool operator != (const Iterator& b) const	{	return slot != b.slot;	}
+	};
+
+	typedef Iterator<FreqMap,		value_type>			iterator;
+	typedef Iterator<const FreqMap,	const value_type>	const_iterator;
+
+	iterator		begin()			{	return iterator			(this, 0);				}
+	iterator		end()			{	return iterator			(this, NUM_FREQ_SLOTS);	}
+	const_iterator	begin()	const	{	return const_iterator	(this, 0);				}
+	const_iterator	end()	const	{	return const_iterator	(this, NUM_FREQ_SLOTS);	}
+
+	bool empty() const
+	{
+		return usedMask == 0;
+	}
+
+	size_t size() const
+	{
+		return __builtin_popcount(usedMask);
+	}
+
+	size_t count(
+		E_FType	ft) const
+	{
+		int slot = freqSlot(ft);
+		return (usedMask & (1u << slot)) && slots[slot].first == ft;
+	}
+
+	iterator find(
+		E_FType	ft)
+	{
+		if (count(ft))		return iterator(this, freqSlot(ft));
+		else				return end();
+	}
+
+	T& operator[](
+		E_FType	ft)
+	{
+		int		slot	= freqSlot(ft);
+		auto&	entry	= slots[slot];
+
+		if	( (usedMask & (1u << slot)) == 0
+			||entry.first != ft)
+		{
+			entry		= {ft, T()};
+			usedMask	|= 1u << slot;
+		}
+
+		return entry.second;
+	}
+
+	void erase(
+		E_FType	ft)
+	{
+		if (count(ft))
+		{
+			int slot = freqSlot(ft);
+			slots[slot].second = T();
+			usedMask &= ~(1u << slot);
+		}
+	}
+
+	void clear()
+	{
+		for (auto& [ft, value] : *this)
+		{
+			value = T();
+		}
+
+		usedMask = 0;
+	}
+};
+
 /** Raw observation data from a receiver. Not to be modified by processing functions
 */
 struct RawObs
@@ -69,8 +224,8 @@ struct RawObs
 	GTime	 	time	= {};       		///> Receiver sampling time (GPST)
 	SatSys		Sat		= {};				///> Satellite ID (system, prn)
 
-	map<E_FType, Sig>			Sigs;		///> Map of signals available in this observation (one per frequency only)
-	map<E_FType, list<RawSig>>	SigsLists;	///> Map of all signals available in this observation (may include multiple per frequency, eg L1X, L1C)
+	FreqMap<Sig>				Sigs;		///> Map of signals available in this observation (one per frequency only)
+	FreqMap<list<RawSig>>		SigsLists;	///> Map of all signals available in this observation (may include multiple per frequency, eg L1X, L1C)
 };
 
 #define MAX_LAYER_NUM 4
@@ -120,7 +275,7 @@ struct Obs : RawObs, IonoObs
 
 	}
 
-	Obs(RawObs raw) : RawObs(raw), exclude(0)
+	Obs(RawObs raw) : RawObs(std::move(raw)), exclude(0)
 	{
 
 	}
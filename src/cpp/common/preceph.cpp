@@ -2,12 +2,16 @@
 // #pragma GCC optimize ("O0")
 
 #include <iostream>
+#include <limits>
+#include <memory>
 #include <string>
+#include <vector>
 #include <array>
 #include <map>
 #include <ctype.h>
 
 using std::string;
+using std::vector;
 using std::array;
 using std::map;
 
@@ -317,6 +321,193 @@ double interpolate(
 	return value;
 }
 
+/** Find the window of precise ephemerides used to interpolate an orbit at a time.
+* The window starts at begin and contains NMAX+1 ephemerides, middle is the first ephemeris at or after the time
+*/
+static void findPephWindow(
+	PephList&			pephList,		///< Ephemerides of the satellite, with at least NMAX+1 entries
+	GTime				time,			///< Time to interpolate at
+	PephList::iterator&	begin,			///< First ephemeris of the window
+	PephList::iterator&	middle)			///< Ephemeris nearest after the time
+{
+	auto peph_it = pephList.lower_bound(time);
+	if (peph_it == pephList.end())
+	{
+		peph_it--;
+	}
+
+	middle = peph_it;
+
+	//go forward a few steps to make sure we're far from the end of the list.
+	for (int i = 0; i < NMAX/2; i++)
+	{
+		peph_it++;
+		if (peph_it == pephList.end())
+		{
+			break;
+		}
+	}
+
+	//go backward a few steps to make sure we're far from the beginning of the list
+	for (int i = 0; i <= NMAX; i++)
+	{
+		peph_it--;
+		if (peph_it == pephList.begin())
+		{
+			break;
+		}
+	}
+
+	begin = peph_it;
+}
+
+/** Compute the barycentric weights and earth rotation corrections for the nodes of an interpolation window
+*/
+static std::shared_ptr<PephGrid> makePephGrid(
+	const VectorXd&	nodes)		///< Times of the ephemerides relative to the reference time (s)
+{
+	auto grid_ptr = std::make_shared<PephGrid>();
+	auto& grid = *grid_ptr;
+
+	grid.nodes		= nodes;
+	grid.weights	= VectorXd::Ones(nodes.size());
+
+	for (int j = 0; j < nodes.size(); j++)
+	for (int k = 0; k < nodes.size(); k++)
+	{
+		if (j != k)
+		{
+			grid.weights(j) /= nodes(j) - nodes(k);
+		}
+	}
+
+	/* correciton for earh rotation ver.2.4.0 */
+	grid.sinl = (OMGE * nodes.array()).sin();
+	grid.cosl = (OMGE * nodes.array()).cos();
+
+	return grid_ptr;
+}
+
+/** Fit the interpolating polynomial through the window of precise ephemerides used for a time.
+* Positions are corrected for earth rotation relative to the reference time, rather than the time of evaluation, so that the polynomial may be reused for nearby times.
+* Grids are shared between satellites that have ephemerides at the same times, if a map of previously computed grids is provided.
+* Returns false if any ephemeris in the window has no position
+*/
+static bool fitPephPolynomial(
+	PephList&								pephList,		///< Ephemerides of the satellite, with at least NMAX+1 entries
+	GTime									t0,				///< Reference time for the polynomial
+	PephPolynomial&							poly,			///< Polynomial to populate
+	map<vector<double>, std::shared_ptr<PephGrid>>*	gridMap_ptr = nullptr)	///< Optional map of grids to share
+{
+	poly.valid = false;
+
+	PephList::iterator begin;
+	PephList::iterator middle;
+	findPephWindow(pephList, t0, begin, middle);
+
+	vector<double> nodes(NMAX + 1);
+	poly.positions.resize(3, NMAX + 1);
+
+	auto peph_it = begin;
+	for (int i = 0; i <= NMAX; i++, peph_it++)
+	{
+		Peph& peph = peph_it->second;
+		if (peph.Pos.norm() <= 0)
+		{
+			return false;
+		}
+
+		nodes[i]				= peph.time - t0;
+		poly.positions.col(i)	= peph.Pos;
+	}
+
+	std::shared_ptr<PephGrid> grid_ptr;
+	if (gridMap_ptr)
+	{
+		auto& mappedGrid_ptr = (*gridMap_ptr)[nodes];
+		if (mappedGrid_ptr == nullptr)
+		{
+			mappedGrid_ptr = makePephGrid(Eigen::Map<VectorXd>(nodes.data(), nodes.size()));
+		}
+
+		grid_ptr = mappedGrid_ptr;
+	}
+	else
+	{
+		grid_ptr = makePephGrid(Eigen::Map<VectorXd>(nodes.data(), nodes.size()));
+	}
+
+	auto& grid = *grid_ptr;
+
+	//rotate all nodes at once
+	VectorXd x = poly.positions.row(0);
+	VectorXd y = poly.positions.row(1);
+	poly.positions.row(0) = (x.cwiseProduct(grid.cosl) - y.cwiseProduct(grid.sinl)).transpose();
+	poly.positions.row(1) = (x.cwiseProduct(grid.sinl) + y.cwiseProduct(grid.cosl)).transpose();
+
+	//determine the times that would select the same window and ephemerides
+	poly.middle1_ptr = &middle->second;
+	poly.middle0_ptr = &middle->second;
+	poly.bracketStart	= -std::numeric_limits<double>::infinity();
+	poly.bracketEnd		= +std::numeric_limits<double>::infinity();
+
+	if (middle != pephList.begin())
+	{
+		auto previous = std::prev(middle);
+
+		poly.middle0_ptr	= &previous->second;
+		poly.bracketStart	= previous->first - t0;
+	}
+
+	if (std::next(middle) != pephList.end())
+	{
+		poly.bracketEnd		= middle->first - t0;
+	}
+
+	poly.grid_ptr	= grid_ptr;
+	poly.t0			= t0;
+	poly.valid		= true;
+
+	return true;
+}
+
+/** Evaluate an interpolating polynomial, giving the position in the earth-fixed frame at the time of evaluation
+*/
+static Vector3d evaluatePephPolynomial(
+	const PephPolynomial&	poly,		///< Polynomial to evaluate
+	GTime					time)		///< Time to evaluate at
+{
+	auto& grid = *poly.grid_ptr;
+
+	double s = time - poly.t0;
+
+	Vector3d pos;
+
+	VectorXd diffs = s - grid.nodes.array();
+
+	int		nearest;
+	double	nearestDiff = diffs.cwiseAbs().minCoeff(&nearest);
+	if (nearestDiff == 0)
+	{
+		pos = poly.positions.col(nearest);
+	}
+	else
+	{
+		//first (modified lagrange) barycentric form, all axes at once
+		VectorXd coeffs = grid.weights.array() / diffs.array();
+
+		pos = poly.positions * coeffs * diffs.prod();
+	}
+
+	//rotate from the reference frame at t0 to the frame at the time of evaluation
+	double sinl = sin(OMGE * s);
+	double cosl = cos(OMGE * s);
+
+	return Vector3d(	 cosl * pos[0] + sinl * pos[1],
+						-sinl * pos[0] + cosl * pos[1],
+						pos[2]);
+}
+
 /* satellite position by precise ephemeris -----------------------------------*/
 int pephpos(
 	GTime		time,
@@ -328,7 +519,6 @@ int pephpos(
 	double*		varc = nullptr)
 {
 	double t[NMAX+1];
-	double p[3][NMAX+1];
 	double c[2];
 	double s[3];
 
@@ -351,7 +541,7 @@ int pephpos(
 		return 0;
 	}
 	
-	PephList& pephList = nav.pephMap[Sat];
+	PephList& pephList = it->second;
 
 	if	( (pephList.size()	< NMAX + 1)
 		||(time	< pephList.begin()	->first - MAXDTE)
@@ -361,79 +551,50 @@ int pephpos(
 		return 0;
 	}
 
-// 	//search for the ephemeris in the list
+	//use the polynomial prepared for this epoch if the time selects the same window and ephemerides
+	PephPolynomial			localPoly;
+	const PephPolynomial*	poly_ptr	= nullptr;
 
-	auto peph_it = pephList.lower_bound(time);
-	if (peph_it == pephList.end())
+	auto poly_it = nav.pephPolynomialMap.find(Sat);
+	if (poly_it != nav.pephPolynomialMap.end())
 	{
-		peph_it--;
-	}
+		auto& cachedPoly = poly_it->second;
+		double s = time - cachedPoly.t0;
 
-	auto middle0 = peph_it;
-
-	//go forward a few steps to make sure we're far from the end of the list.
-	for (int i = 0; i < NMAX/2; i++)
-	{
-		peph_it++;
-		if (peph_it == pephList.end())
+		if	( cachedPoly.valid
+			&&s > cachedPoly.bracketStart
+			&&s <= cachedPoly.bracketEnd)
 		{
-			break;
+			poly_ptr = &cachedPoly;
 		}
 	}
 
-	//go backward a few steps to make sure we're far from the beginning of the list
-	for (int i = 0; i <= NMAX; i++)
-	{
-		peph_it--;
-		if (peph_it == pephList.begin())
-		{
-			break;
-		}
-	}
-
-	auto begin = peph_it;
-
-	//get interpolation parameters and check all ephemerides have values.
-	peph_it = begin;
-	for (int i = 0; i <= NMAX; i++, peph_it++)
+	if (poly_ptr == nullptr)
 	{
-		Peph& peph = peph_it->second;
-		if (peph.Pos.norm() <= 0)
+		if (fitPephPolynomial(pephList, time, localPoly) == false)
 		{
 //             trace(3,"prec ephem outage %s sat=%s\n",time.to_string(0).c_str(), id);
 			return 0;
 		}
 
-		t[i] = peph.time - time;
-		auto& pos = peph.Pos;
-#if 0
-		p[0][i]=pos[0];
-		p[1][i]=pos[1];
-#else
-		/* correciton for earh rotation ver.2.4.0 */		//todo aaron change to vector
-		double sinl = sin(OMGE * t[i]);
-		double cosl = cos(OMGE * t[i]);
-		p[0][i] = cosl * pos[0] - sinl * pos[1];
-		p[1][i] = sinl * pos[0] + cosl * pos[1];
-#endif
-		p[2][i] = pos[2];
-	}
-
-// 	Vector3d rSat2;
-	
-	for (int i = 0; i < 3; i++)
-	{
-// 		rSat2	[i] = interpolate	(t, p[i], NMAX + 1);
-		rSat	[i] = interppol		(t, p[i], NMAX + 1);
+		poly_ptr = &localPoly;
 	}
-	
-// 	rSat = rSat2;
-// 	std::cout << std::endl << "diff  " << (rSat2 - rSat).transpose();
-	
+
+	auto& poly		= *poly_ptr;
+	auto& middle0	= *poly.middle0_ptr;
+	auto& middle1	= *poly.middle1_ptr;
+	auto& nodes		= poly.grid_ptr->nodes;
+
+	rSat = evaluatePephPolynomial(poly, time);
+
+	double offset = poly.t0 - time;
+	t[0]	= nodes(0)		+ offset;
+	t[NMAX]	= nodes(NMAX)	+ offset;
+
 	if (vare)
 	{
 		for (int i = 0; i < 3; i++)
-			s[i] = middle0->second.PosStd[i];
+			s[i] = middle1.PosStd[i];
 		double std = norm(s, 3);
 
 		/* extrapolation error for orbit */
@@ -444,15 +605,10 @@ int pephpos(
 	}
 
 	/* linear interpolation for clock */
-	auto middle1 = middle0;
-	if (middle0 != pephList.begin())
-	{
-		middle0--;
-	}
-	t[0] = time - middle0->second.time;
-	t[1] = time - middle1->second.time;
-	c[0] = middle0->second.Clk;
-	c[1] = middle1->second.Clk;
+	t[0] = time - middle0.time;
+	t[1] = time - middle1.time;
+	c[0] = middle0.Clk;
+	c[1] = middle1.Clk;
 
 	double std = 0;
 	if 		(t[0] <= 0)
@@ -460,22 +616,22 @@ int pephpos(
 		dtSat = c[0];
 
 		if (dtSat != 0)
-			std = middle0->second.ClkStd * CLIGHT	+ EXTERR_CLK * fabs(t[0]);
+			std = middle0.ClkStd * CLIGHT	+ EXTERR_CLK * fabs(t[0]);
 	}
 	else if (t[1] >= 0)
 	{
 		dtSat = c[1];
 
 		if (dtSat != 0)
-			std = middle1->second.ClkStd * CLIGHT	+ EXTERR_CLK * fabs(t[1]);
+			std = middle1.ClkStd * CLIGHT	+ EXTERR_CLK * fabs(t[1]);
 	}
 	else if ( c[0] != 0
 			&&c[1] != 0)
 	{
 		dtSat = (c[1] * t[0] - c[0] * t[1]) / (t[0] - t[1]);
 
-		double inv0 = 1 / middle0->second.ClkStd * CLIGHT + EXTERR_CLK * fabs(t[0]);
-		double inv1 = 1 / middle1->second.ClkStd * CLIGHT + EXTERR_CLK * fabs(t[1]);
+		double inv0 = 1 / middle0.ClkStd * CLIGHT + EXTERR_CLK * fabs(t[0]);
+		double inv1 = 1 / middle1.ClkStd * CLIGHT + EXTERR_CLK * fabs(t[1]);
 		std			= 1 / (inv0 + inv1);
 	}
 	else
@@ -521,30 +677,18 @@ int pephclk(
 	}
 
 	//search for the ephemeris in the list
-	auto pclk_it = pclkList.begin();
-	while (pclk_it->time < time)
-	{
-		pclk_it++;
-		if (pclk_it == pclkList.end())
-		{
-			pclk_it--;
-			break;
-		}
-	}
-	auto middle1 = pclk_it;
-	auto middle0 = middle1;
-	if (middle0 != pclkList.begin())
-	{
-		middle0--;
-	}
+	size_t index = pclkList.find(time);
+
+	auto& middle1 = pclkList.records[index];
+	auto& middle0 = pclkList.records[index ? index - 1 : 0];
 
 	/* linear interpolation for clock */
 	double t[2];
 	double c[2];
-	t[0] = time - middle0->time;
-	t[1] = time - middle1->time;
-	c[0] = middle0->clk;
-	c[1] = middle1->clk;
+	t[0] = time - middle0.time;
+	t[1] = time - middle1.time;
+	c[0] = middle0.clk;
+	c[1] = middle1.clk;
 
 	double std = 0;
 
@@ -555,7 +699,7 @@ int pephclk(
 		if (dtSat == 0)
 			return 0;
 
-		std	= middle0->std * CLIGHT	+ EXTERR_CLK * fabs(t[0]);
+		std	= middle0.std * CLIGHT	+ EXTERR_CLK * fabs(t[0]);
 	}
 	else if (t[1] >= 0)
 	{
@@ -564,15 +708,15 @@ int pephclk(
 		if (dtSat == 0)
 			return 0;
 
-		std	= middle1->std * CLIGHT	+ EXTERR_CLK * fabs(t[1]);
+		std	= middle1.std * CLIGHT	+ EXTERR_CLK * fabs(t[1]);
 	}
 	else if	( c[0] != 0
 			&&c[1] != 0)
 	{
 		dtSat = (c[1] * t[0] - c[0] * t[1]) / (t[0] - t[1]);
 
-		double inv0 = 1 / middle0->std * CLIGHT + EXTERR_CLK * fabs(t[0]);
-		double inv1 = 1 / middle1->std * CLIGHT + EXTERR_CLK * fabs(t[1]);
+		double inv0 = 1 / middle0.std * CLIGHT + EXTERR_CLK * fabs(t[0]);
+		double inv1 = 1 / middle1.std * CLIGHT + EXTERR_CLK * fabs(t[1]);
 		std			= 1 / (inv0 + inv1);
 	}
 	else
@@ -590,6 +734,78 @@ int pephclk(
 	return 1;
 }
 
+/** Sun position at the start of the current epoch, shared by all satellites and receivers
+*/
+struct EpochSun
+{
+	bool		valid	= false;
+	GTime		time;
+	Vector3d	rSun	= Vector3d::Zero();		///< Sun position (ecef) (m)
+};
+
+static EpochSun epochSun;
+
+/** Position of the sun in ecef, for satellite attitude.
+* Times near the start of the epoch reuse the position computed for the epoch, rotated with the earth - the motion of the sun itself is negligible over the interval
+*/
+static Vector3d sunPosition(
+	GTime	time)		///< Time of interest (gpst)
+{
+	if	( epochSun.valid
+		&&fabs(time - epochSun.time) < 1)
+	{
+		double dt	= time - epochSun.time;
+		double sinl	= sin(OMGE * dt);
+		double cosl	= cos(OMGE * dt);
+
+		auto& rSun = epochSun.rSun;
+
+		return Vector3d(	 cosl * rSun[0] + sinl * rSun[1],
+							-sinl * rSun[0] + cosl * rSun[1],
+							rSun[2]);
+	}
+
+	Vector3d rSun;
+	ERPValues erpv;
+	sunmoonpos(gpst2utc(time), erpv, &rSun);
+
+	return rSun;
+}
+
+/** Prepare precise orbit interpolation and the sun position once per epoch, rather than once per satellite per receiver.
+* The signal transmission times of all receivers are within a fraction of a second of the epoch, so they share the same interpolation windows.
+*
+* Must be called before receivers are processed in parallel, as it modifies the navigation data.
+*/
+void cachePreciseOrbits(
+	GTime		time,		///< Time of the epoch (gpst)
+	Navigation&	nav)		///< Navigation data containing precise ephemerides
+{
+	ERPValues erpv;
+	sunmoonpos(gpst2utc(time), erpv, &epochSun.rSun);
+	epochSun.time	= time;
+	epochSun.valid	= true;
+
+	//satellites with ephemerides at the same times share the same nodes and weights
+	map<vector<double>, std::shared_ptr<PephGrid>> gridMap;
+
+	for (auto& [satId, pephList] : nav.pephMap)
+	{
+		auto& poly = nav.pephPolynomialMap[satId];
+
+		poly.valid = false;
+
+		if	( (pephList.size()	< NMAX + 1)
+			||(time	< pephList.begin()	->first - MAXDTE)
+			||(time	> pephList.rbegin()	->first + MAXDTE))
+		{
+			continue;
+		}
+
+		fitPephPolynomial(pephList, time, poly, &gridMap);
+	}
+}
+
 /* satellite antenna phase center offset ---------------------------------------
 * compute satellite antenna phase center offset in ecef
 * args   : gtime_t time       I   time (gpst)
@@ -607,14 +823,12 @@ void satAntOff(
 	Vector3d&			dAnt,
 	SatStat*			satStat_ptr)
 {
-	ERPValues erpv;
 	E_FType j = F1;
 	E_FType k = F2;
 	tracepdeex(4, trace, "%s: time=%s sat=%2d\n", __FUNCTION__, time.to_string(3).c_str() ,Sat);
 
 	/* sun position in ecef */
-	Vector3d rsun;
-	sunmoonpos(gpst2utc(time), erpv, &rsun);
+	Vector3d rsun = sunPosition(time);
 
 	/* unit vectors of satellite fixed coordinates */
 	Vector3d z = -rSat;			Vector3d ez = z.normalized();			//todo aaron, this is probably everywhere
@@ -684,9 +898,7 @@ Vector3d satAntOff(
 	tracepdeex(4, trace, "%s: time=%s\n", __FUNCTION__, time.to_string(3).c_str());
 
 	/* sun position in ecef */
-	Vector3d rsun;
-	ERPValues erpv;
-	sunmoonpos(gpst2utc(time), erpv, &rsun);
+	Vector3d rsun = sunPosition(time);
 
 	/* unit vectors of satellite fixed coordinates */
 	Vector3d z = -rSat;			Vector3d ez = z.normalized();			//todo aaron, this is probably everywhere
@@ -42,6 +42,10 @@ bool readsp3(
 	double*			bfact);
 
 double	interppol(const double *x, double *y, int n);
+
+void	cachePreciseOrbits(
+	GTime		time,
+	Navigation&	nav);
 void	orb2sp3(Navigation& nav);
 
 int		pephclk(
@@ -184,8 +184,6 @@ void RtcmDecoder::decodeSSR(
 
 		SatSys Sat(sys, satId);
 
-		auto& ssr = nav.satNavMap[Sat].receivedSSR;
-
 		if 	( message_number == +RtcmMessageType::GPS_SSR_ORB_CORR
 			||message_number == +RtcmMessageType::GPS_SSR_COMB_CORR
 			||message_number == +RtcmMessageType::GAL_SSR_ORB_CORR
@@ -208,12 +206,17 @@ void RtcmDecoder::decodeSSR(
 			ssrEph.ddeph[2]		= getbitsInc(data, i, 19) * 0.004e-3;
 
 			//tracepdeex(0,std::cout, "\n#RTCM_DEC SSRORB %s %s %4d %10.3f %10.3f %10.3f %d ", Sat.id().c_str(),ssrEph.t0.to_string(2).c_str(), ssrEph.iode,ssrEph.deph[0],ssrEph.deph[1],ssrEph.deph[2], iod);
-			if	( ssr.ssrEph_map.empty()
-				||ssrEph.iod	!= ssr.ssrEph_map.begin()->second.iod
-				||ssrEph.t0		!= ssr.ssrEph_map.begin()->second.t0)
+			NavRequests::modify([=]
 			{
-				ssr.ssrEph_map[ssrEph.t0] = ssrEph;
-			}
+				auto& ssr = nav.satNavMap[Sat].receivedSSR;
+
+				if	( ssr.ssrEph_map.empty()
+					||ssrEph.iod	!= ssr.ssrEph_map.begin()->second.iod
+					||ssrEph.t0		!= ssr.ssrEph_map.begin()->second.t0)
+				{
+					ssr.ssrEph_map[ssrEph.t0] = ssrEph;
+				}
+			});
 
 			if (acsConfig.output_decoded_rtcm_json)
 				outputSsrEphToJson(ssrEph, Sat);
@@ -239,12 +242,17 @@ void RtcmDecoder::decodeSSR(
 			ssrClk.dclk[2]		= getbitsInc(data, i, 27) * 0.00002e-3;
 
 			//tracepdeex(0,std::cout, "\n#RTCM_DEC SSRCLK %s %s      %10.3f %10.3f %10.3f %d", Sat.id().c_str(),ssrClk.t0.to_string(2).c_str(), ssrClk.dclk[0],ssrClk.dclk[1],ssrClk.dclk[2], iod);
-			if	( ssr.ssrClk_map.empty()
-				||ssrClk.iod		!= ssr.ssrClk_map.begin()->second.iod
-				||ssrClk.t0			!= ssr.ssrClk_map.begin()->second.t0)
+			NavRequests::modify([=]
 			{
-				ssr.ssrClk_map[ssrClk.t0] = ssrClk;
-			}
+				auto& ssr = nav.satNavMap[Sat].receivedSSR;
+
+				if	( ssr.ssrClk_map.empty()
+					||ssrClk.iod		!= ssr.ssrClk_map.begin()->second.iod
+					||ssrClk.t0			!= ssr.ssrClk_map.begin()->second.t0)
+				{
+					ssr.ssrClk_map[ssrClk.t0] = ssrClk;
+				}
+			});
 			
 			if (acsConfig.output_decoded_rtcm_json)
 				outputSsrClkToJson(ssrClk, Sat);
@@ -262,14 +270,19 @@ void RtcmDecoder::decodeSSR(
 			ssrUra.iod 			= iod;
 			ssrUra.ura			= getbituInc(data, i, 6);
 
-			if	( ssr.ssrUra_map.empty()
-				||ssrUra.iod		!= ssr.ssrUra_map.begin()->second.iod
-				||ssrUra.t0			!= ssr.ssrUra_map.begin()->second.t0)
+			NavRequests::modify([=]
 			{
-				// This is the total User Range Accuracy calculated from all the SSR.
-				// TODO: Check implementation, RTCM manual DF389.
-				ssr.ssrUra_map[ssrUra.t0] = ssrUra;
-			}
+				auto& ssr = nav.satNavMap[Sat].receivedSSR;
+
+				if	( ssr.ssrUra_map.empty()
+					||ssrUra.iod		!= ssr.ssrUra_map.begin()->second.iod
+					||ssrUra.t0			!= ssr.ssrUra_map.begin()->second.t0)
+				{
+					// This is the total User Range Accuracy calculated from all the SSR.
+					// TODO: Check implementation, RTCM manual DF389.
+					ssr.ssrUra_map[ssrUra.t0] = ssrUra;
+				}
+			});
 		}
 
 		if  ( message_number == +RtcmMessageType::GPS_SSR_CODE_BIAS
@@ -321,7 +334,7 @@ void RtcmDecoder::decodeSSR(
 					entry.slop	=  0;
 					entry.slpv	=  0;
 
-					pushBiasSinex(id, entry);
+					NavRequests::modify([=]{ pushBiasSinex(id, entry); });
 				}
 				catch (std::exception& e)
 				{
@@ -329,12 +342,17 @@ void RtcmDecoder::decodeSSR(
 				}
 			}
 
-			if	( ssr.ssrCodeBias_map.empty()
-				||ssrBiasCode.iod		!= ssr.ssrCodeBias_map.begin()->second.iod
-				||ssrBiasCode.t0		!= ssr.ssrCodeBias_map.begin()->second.t0)
+			NavRequests::modify([=]
 			{
-				ssr.ssrCodeBias_map[ssrBiasCode.t0] = ssrBiasCode;
-			}
+				auto& ssr = nav.satNavMap[Sat].receivedSSR;
+
+				if	( ssr.ssrCodeBias_map.empty()
+					||ssrBiasCode.iod		!= ssr.ssrCodeBias_map.begin()->second.iod
+					||ssrBiasCode.t0		!= ssr.ssrCodeBias_map.begin()->second.t0)
+				{
+					ssr.ssrCodeBias_map[ssrBiasCode.t0] = ssrBiasCode;
+				}
+			});
 		}
 
 		if  ( message_number == +RtcmMessageType::GPS_SSR_PHASE_BIAS
@@ -401,7 +419,7 @@ void RtcmDecoder::decodeSSR(
 					entry.slop	=  0;
 					entry.slpv	=  0;
 
-					pushBiasSinex(id, entry);
+					NavRequests::modify([=]{ pushBiasSinex(id, entry); });
 				}
 				catch (std::exception& e)
 				{
@@ -409,12 +427,17 @@ void RtcmDecoder::decodeSSR(
 				}
 			}
 
-			if	( ssr.ssrPhasBias_map.empty()
-				||ssrBiasPhas.iod		!= ssr.ssrPhasBias_map.begin()->second.iod
-				||ssrBiasPhas.t0		!= ssr.ssrPhasBias_map.begin()->second.t0)
+			NavRequests::modify([=]
 			{
-				ssr.ssrPhasBias_map[ssrBiasPhas.t0] = ssrBiasPhas;
-			}
+				auto& ssr = nav.satNavMap[Sat].receivedSSR;
+
+				if	( ssr.ssrPhasBias_map.empty()
+					||ssrBiasPhas.iod		!= ssr.ssrPhasBias_map.begin()->second.iod
+					||ssrBiasPhas.t0		!= ssr.ssrPhasBias_map.begin()->second.t0)
+				{
+					ssr.ssrPhasBias_map[ssrBiasPhas.t0] = ssrBiasPhas;
+				}
+			});
 		}
 	}
 }
@@ -614,13 +637,16 @@ void RtcmDecoder::decodeEphemeris(
 	//tracepdeex(rtcmdeblvl,std::cout, "\n#RTCM_DEC BRCEPH %s %s %4d %16.9e %13.6e %10.3e, %d ", eph.Sat.id().c_str(),eph.toe.to_string(2).c_str(), eph.iode, eph.f0,eph.f1,eph.f2, message_number);
 	//std::cout << "Adding ephemeris for " << eph.Sat.id() << std::endl;
 	
-	if (nav.ephMap[eph.Sat].find(eph.toe) == nav.ephMap[eph.Sat].end())
+	if (acsConfig.output_decoded_rtcm_json)
+		traceBroEph(eph, sys);
+	
+	NavRequests::modify([eph]
 	{
-		nav.ephMap[eph.Sat][eph.toe] = eph;
-		
-		if (acsConfig.output_decoded_rtcm_json)
-			traceBroEph(eph, sys);
-	}
+		if (nav.ephMap[eph.Sat].find(eph.toe) == nav.ephMap[eph.Sat].end())
+		{
+			nav.ephMap[eph.Sat][eph.toe] = eph;
+		}
+	});
 }
 
 
@@ -1048,7 +1074,7 @@ ObsList RtcmDecoder::decodeMSM7(
 			//std::cout << "decodeMSM7, obs.time :" << std::put_time( std::gmtime( &obs.time.time ), "%F %X" )
 			//					  << " : " << obs.time.sec << std::endl;
 
-			obsList.push_back(obs);
+			obsList.push_back(std::move(obs));
 		}
 	}
 
@@ -1304,33 +1330,61 @@ void RtcmDecoder::traceLatency(GTime tobs)
 	numMessagesLatency++;
 }
 
+/** Read data from a stream into the frame buffer as it is required, and decode the frames it contains
+*/
 void RtcmStream::parseRTCM(
 	std::istream& inputStream)
 {
-	while (inputStream)
+	const size_t chunkSize = 65536;
+
+	while (parseRTCM())
+	{
+		//the buffer has run out of complete frames, get some more
+		size_t got = rtcmBuffer.append(inputStream, chunkSize);
+		if (got == 0)
+		{
+			return;
+		}
+	}
+}
+
+/** Decode the frames that have been received into the frame buffer.
+* Frames are located and checked in place, and decoders are given pointers into the buffer.
+* Returns true if all complete frames were consumed and more data is required,
+* or false if decoding stopped early, at the end of an epoch of observations or to wait for real time.
+*/
+bool RtcmStream::parseRTCM()
+{
+	while (true)
 	{
-		int byteCnt = 0;
-		int pos;
-		while (true)
+		// Skip to the start of the frame - marked by preamble character 0xD3
+		auto start			= rtcmBuffer.begin();
+		auto preamble_ptr	= (const unsigned char*) memchr(start, RTCM_PREAMBLE, rtcmBuffer.size());
+		if (preamble_ptr == nullptr)
 		{
-			// Skip to the start of the frame - marked by preamble character 0xD3
-			pos = inputStream.tellg();
+			rtcmBuffer.consume(rtcmBuffer.size());
+			return true;
+		}
 
-			unsigned char c;
-			inputStream.read((char*)&c, 1);
+		int byteCnt = preamble_ptr - start;
 
-			if (inputStream)
-			{
-				if (c == RTCM_PREAMBLE)
-				{
-					break;
-				}
-			}
-			else
-			{
-				return;
-			}
-			byteCnt++;
+		rtcmBuffer.consume(byteCnt);
+
+		// Need the frame length - 2 bytes big endian only want 10 bits
+		if (rtcmBuffer.size() < 3)
+		{
+			return true;
+		}
+
+		auto data = rtcmBuffer.begin();
+
+		auto message_length = RtcmDecoder::message_length((char*) data + 1);
+
+		// Need the frame data (include the header) and the crc
+		int frameLength = message_length + 6;
+		if (rtcmBuffer.size() < frameLength)
+		{
+			return true;
 		}
 
 		if (numPreambleFound == 0)
@@ -1347,51 +1401,16 @@ void RtcmStream::parseRTCM(
 			messageRtcmLog(message.str());
 		}
 
-		// Read the frame length - 2 bytes big endian only want 10 bits
-		char buf[2];
-		inputStream.read((char*)buf, 2);
-		int pos2=inputStream.tellg();
-		if (inputStream.fail())
-		{
-			inputStream.clear();
-			inputStream.seekg(pos);
-			return;
-		}
-
-		auto message_length = RtcmDecoder::message_length(buf);
-
-		// Read the frame data (include the header)
-		unsigned char data[message_length + 3];
-		data[0] = RTCM_PREAMBLE;
-		data[1] = buf[0];
-		data[2] = buf[1];
-		unsigned char* message = data + 3;
-		inputStream.read((char*)message, message_length);
-		if (inputStream.fail())
-		{
-			inputStream.clear();
-			inputStream.seekg(pos);
-			return;
-		}
+		const unsigned char* message = data + 3;
 
-		// Read the frame CRC
-		unsigned int crcRead = 0;
-		inputStream.read((char*)&crcRead, 3);
-		if (inputStream.fail())
-		{
-			inputStream.clear();
-			inputStream.seekg(pos);
-			return;
-		}
+		// Check the frame CRC
+		unsigned int crcRead	= (data[message_length + 3] << 16)
+								| (data[message_length + 4] << 8)
+								| (data[message_length + 5]);
 
-		unsigned int crcCalc = crc24q(data, sizeof(data));
-		int nmeass = 0;
-		if (message_length > 8)
-		nmeass = getbitu(message, 0,	12);
+		unsigned int crcCalc	= crc24q(data, message_length + 3);
 
-		if	( (((char*)&crcCalc)[0] != ((char*)&crcRead)[2])
-			||(((char*)&crcCalc)[1] != ((char*)&crcRead)[1])
-			||(((char*)&crcCalc)[2] != ((char*)&crcRead)[0]))
+		if (crcCalc != crcRead)
 		{
 			numFramesFailedCRC++;
 			std::stringstream message;
@@ -1400,11 +1419,10 @@ void RtcmStream::parseRTCM(
 			message << ", Number Decoded : " << numFramesDecoded;
 			message << ", Number Preamble : " << numPreambleFound;
 			messageRtcmLog(message.str());
-			inputStream.seekg(pos2);
+			rtcmBuffer.consume(3);
 			continue;
 		}
 
-
 		if (record_rtcm)
 		{
 			// Set the filenames based on system time, when replaying recorded streams
@@ -1431,13 +1449,14 @@ void RtcmStream::parseRTCM(
 			encoder.encodeTimeStampRTCM();			//todo aaron, this looks screwy, needs a return value to work?
 			encoder.encodeWriteMessages(ofs);
 
-			//copy the message to the output file too
-			ofs.write((char *)data,		message_length+3);
-			ofs.write((char *)&crcRead,	3);
+			//copy the frame to the output file too
+			ofs.write((char *)data,		frameLength);
 		}
 
 		numFramesPassCRC++;
 
+		rtcmBuffer.consume(frameLength);
+
 		//tracepdeex(rtcmdeblvl+1,std::cout, "STR : RTCM Message %4d\n", nmeass);
 
 		auto message_type = RtcmDecoder::message_type((unsigned char*) message);
@@ -1487,8 +1506,9 @@ void RtcmStream::parseRTCM(
 						if (thisDeltaTime < rtcmDeltaTime)
 						{
 // 							printf("%ld\n", thisDeltaTime);
-							inputStream.seekg(pos);
-							return;
+							//leave the frame in the buffer to be decoded again later
+							rtcmBuffer.readPos -= frameLength;
+							return false;
 						}
 					}
 					break;
@@ -1549,24 +1569,24 @@ void RtcmStream::parseRTCM(
 
 			if (multimessage == 0)
 			{
-				SuperList.insert(SuperList.end(),obsList.begin(),obsList.end());
-				obsListList.push_back(SuperList);
+				SuperList.insert(SuperList.end(), std::make_move_iterator(obsList.begin()), std::make_move_iterator(obsList.end()));
+				pushObsList(std::move(SuperList));
 				SuperList.clear();
 				// Line added for parsing RTCM files, value indicates that it is the last MSM message
 				// for a given time and reference station ID.
-				return;
+				return false;
 			}
 			else if	(  SuperList.size()	> 0
 					&& obsList.size()	> 0
 					&& fabs(SuperList.front().time - obsList.front().time) > 0.5)
 			{
-				obsListList.push_back(SuperList);
+				pushObsList(std::move(SuperList));
 				SuperList.clear();
-				SuperList.insert(SuperList.end(), obsList.begin(), obsList.end());
+				SuperList.insert(SuperList.end(), std::make_move_iterator(obsList.begin()), std::make_move_iterator(obsList.end()));
 			}
 			else
 			{
-				SuperList.insert(SuperList.end(), obsList.begin(), obsList.end());
+				SuperList.insert(SuperList.end(), std::make_move_iterator(obsList.begin()), std::make_move_iterator(obsList.end()));
 			}
 
 			if (SuperList.size() > 1000)
@@ -86,7 +86,11 @@ void RTS_Output(
 {
 	string reversedStatesFilename = kfState.rts_basename + BACKWARD_SUFFIX;
 	
-	long int startPos = -1;
+	closeArchiveStream(reversedStatesFilename);
+	
+	ArchiveReverseReader reader(reversedStatesFilename);
+	
+	auto& startPos = reader.startPos;
 	
 	BOOST_LOG_TRIVIAL(info) 
 	<< "Outputting RTS products...";
@@ -95,7 +99,7 @@ void RTS_Output(
 	
 	while (1)
 	{
-		E_SerialObject type = getFilterTypeFromFile(startPos, reversedStatesFilename);
+		E_SerialObject type = reader.nextType();
 
 		BOOST_LOG_TRIVIAL(debug) 
 		<< "Outputting " << type._to_string() << " from file position " << startPos << std::endl;
@@ -110,7 +114,7 @@ void RTS_Output(
 			
 			case E_SerialObject::METADATA:
 			{
-				bool pass = getFilterObjectFromFile(type, metaDataMap, startPos, reversedStatesFilename);
+				bool pass = reader.getObject(type, metaDataMap);
 				if (pass == false)
 				{
 					std::cout << "BAD RTS OUTPUT read";
@@ -123,7 +127,7 @@ void RTS_Output(
 			case E_SerialObject::MEASUREMENT:
 			{
 				KFMeas archiveMeas;
-				bool pass = getFilterObjectFromFile(type, archiveMeas, startPos, reversedStatesFilename);
+				bool pass = reader.getObject(type, archiveMeas);
 				if (pass == false)
 				{
 					std::cout << "BAD RTS OUTPUT read";
@@ -153,7 +157,7 @@ void RTS_Output(
 			case E_SerialObject::FILTER_PLUS:
 			{
 				KFState archiveKF;
-				bool pass = getFilterObjectFromFile(type, archiveKF, startPos, reversedStatesFilename);
+				bool pass = reader.getObject(type, archiveKF);
 				
 				if (pass == false)
 				{
@@ -196,6 +200,86 @@ void RTS_Output(
 	}
 }
 
+/** Solve P * X = B for a symmetric covariance matrix P without forming its inverse.
+* P is partitioned into independent blocks of states that are connected by nonzero covariances,
+* and each block is factorised and solved separately, as the inverse of a block diagonal matrix is itself block diagonal.
+*/
+MatrixXd blockLdltSolve(
+	const MatrixXd&	P,		///< Symmetric covariance matrix to solve against
+	const MatrixXd&	B)		///< Right hand side
+{
+	int n = P.rows();
+	
+	//union-find over states that are correlated
+	vector<int> parent(n);
+	for (int i = 0; i < n; i++)
+		parent[i] = i;
+	
+	auto findRoot = [&](int i)
+	{
+		while (parent[i] != i)
+		{
+			parent[i]	= parent[parent[i]];
+			i			= parent[i];
+		}
+		return i;
+	};
+	
+	for (int j = 0;		j < n; j++)
+	for (int i = j + 1;	i < n; i++)
+	{
+		if (P(i, j) == 0)
+		{
+			continue;
+		}
+		
+		int a = findRoot(i);
+		int b = findRoot(j);
+		if (a != b)
+			parent[a] = b;
+	}
+	
+	map<int, vector<int>> blockIndicesMap;
+	for (int i = 0; i < n; i++)
+	{
+		blockIndicesMap[findRoot(i)].push_back(i);
+	}
+	
+	if (blockIndicesMap.size() == 1)
+	{
+		return P.ldlt().solve(B);
+	}
+	
+	MatrixXd X(n, B.cols());
+	
+	for (auto& [root, indices] : blockIndicesMap)
+	{
+		int numBlock = indices.size();
+		
+		MatrixXd Pb(numBlock, numBlock);
+		MatrixXd Bb(numBlock, B.cols());
+		
+		for (int i = 0; i < numBlock; i++)
+		{
+			for (int j = 0; j < numBlock; j++)
+			{
+				Pb(i, j) = P(indices[i], indices[j]);
+			}
+			
+			Bb.row(i) = B.row(indices[i]);
+		}
+		
+		MatrixXd Xb = Pb.ldlt().solve(Bb);
+		
+		for (int i = 0; i < numBlock; i++)
+		{
+			X.row(indices[i]) = Xb.row(i);
+		}
+	}
+	
+	return X;
+}
+
 KFState RTS_Process(
 	KFState&	kfState,
 	bool		write,
@@ -206,7 +290,7 @@ KFState RTS_Process(
 		return KFState();
 	}
 	
-	MatrixXd transitionMatrix;
+	SparseMatrix<double> transitionMatrix;
 
 	KFState	kalmanMinus;
 	KFState	smoothedKF;
@@ -218,16 +302,23 @@ KFState RTS_Process(
 	string inputFile	= kfState.rts_basename + FORWARD_SUFFIX;
 	string outputFile	= kfState.rts_basename + BACKWARD_SUFFIX;
 
+	//flush any records still being written, the forward file may also be moved below
+	closeArchiveStream(inputFile);
+	closeArchiveStream(outputFile);
+	
 	if (write)
 	{
 		std::ofstream ofs(outputFile,	std::ofstream::out | std::ofstream::trunc);
 	}
 
-	long int startPos = -1;
+	ArchiveReverseReader reader(inputFile);
+	
+	auto& startPos = reader.startPos;
+	
 	int lag = 0;					//todo aaron, change lag to use times rather than iterations, iterations may be multiple per epoch
 	while (lag != kfState.rts_lag)
 	{
-		E_SerialObject type = getFilterTypeFromFile(startPos, inputFile);
+		E_SerialObject type = reader.nextType();
 
 // 		std::cout << std::endl << "Found " << type._to_string();
 		
@@ -245,7 +336,7 @@ KFState RTS_Process(
 			}
 			case E_SerialObject::METADATA:
 			{
-				bool pass = getFilterObjectFromFile(type, smoothedKF.metaDataMap, startPos, inputFile);
+				bool pass = reader.getObject(type, smoothedKF.metaDataMap);
 				if (pass == false)
 				{
 					std::cout << "CREASS" << std::endl;
@@ -261,7 +352,7 @@ KFState RTS_Process(
 			}
 			case E_SerialObject::MEASUREMENT:
 			{
-				bool pass = getFilterObjectFromFile(type, measurements, startPos, inputFile);
+				bool pass = reader.getObject(type, measurements);
 				if (pass == false)
 				{
 					return KFState();
@@ -272,7 +363,7 @@ KFState RTS_Process(
 			case E_SerialObject::TRANSITION_MATRIX:
 			{
 				TransitionMatrixObject transistionMatrixObject;
-				bool pass = getFilterObjectFromFile(type, transistionMatrixObject, startPos, inputFile);
+				bool pass = reader.getObject(type, transistionMatrixObject);
 				if (pass == false)
 				{
 					return KFState();
@@ -282,19 +373,24 @@ KFState RTS_Process(
 
 // 				transitionMatrix = MatrixXd::Zero(transistionMatrixObject.rows, transistionMatrixObject.cols);
 
-				MatrixXd transition = MatrixXd::Zero(transistionMatrixObject.rows, transistionMatrixObject.cols);
+				vector<Eigen::Triplet<double>> tripletList;
+				tripletList.reserve(transistionMatrixObject.forwardTransitionMap.size());
 				for (auto& [keyPair, value] : transistionMatrixObject.forwardTransitionMap)
 				{
-					transition(keyPair.first, keyPair.second) = value;
+					tripletList.push_back({keyPair.first, keyPair.second, value});
 				}
 				
-				transitionMatrix = (transitionMatrix * transition).eval();
+				SparseMatrix<double> transition(transistionMatrixObject.rows, transistionMatrixObject.cols);
+				transition.setFromTriplets(tripletList.begin(), tripletList.end());
+				
+				//both are near identity, keep the accumulated product sparse
+				transitionMatrix = (transitionMatrix * transition).pruned();
 
 				break;
 			}
 			case E_SerialObject::FILTER_MINUS:
 			{
-				bool pass = getFilterObjectFromFile(type, kalmanMinus, startPos, inputFile);
+				bool pass = reader.getObject(type, kalmanMinus);
 				if (pass == false)
 				{
 					return KFState();
@@ -305,7 +401,8 @@ KFState RTS_Process(
 					smoothedXready = true;
 				}
 				
-				transitionMatrix = MatrixXd::Identity(kalmanMinus.x.rows(), kalmanMinus.x.rows());
+				transitionMatrix.resize(kalmanMinus.x.rows(), kalmanMinus.x.rows());
+				transitionMatrix.setIdentity();
 
 				break;
 			}
@@ -320,7 +417,7 @@ KFState RTS_Process(
 				}
 
 				KFState kalmanPlus;
-				bool pass = getFilterObjectFromFile(type, kalmanPlus, startPos, inputFile);
+				bool pass = reader.getObject(type, kalmanPlus);
 				if (pass == false)
 				{
 					return KFState();
@@ -358,11 +455,9 @@ KFState RTS_Process(
 
 				kalmanMinus.P(0,0) = 1;
 
-				MatrixXd Pinv = kalmanMinus.P.inverse();
-
-				Pinv = (Pinv + Pinv.transpose()).eval()	/ 2;
-
-				MatrixXd Ck = kalmanPlus.P * F.transpose() * Pinv;
+				//Ck = P+ * F' * inv(P-), found as the transpose of the solution of P- * Ck' = F * P+, without forming the inverse
+				MatrixXd FP		= F * kalmanPlus.P;
+				MatrixXd Ck		= blockLdltSolve(kalmanMinus.P, FP).transpose();
 
 				VectorXd deltaX = Ck * (smoothedKF.x - kalmanMinus.x);
 				MatrixXd deltaP = Ck * (smoothedKF.P - kalmanMinus.P) * Ck.transpose();
@@ -426,19 +521,14 @@ KFState RTS_Process(
 		string tempFile	= kfState.rts_basename + FORWARD_SUFFIX + "_temp";
 		{
 			std::ofstream	tempStream(tempFile,	std::ifstream::binary | std::ofstream::out | std::ofstream::trunc);
-			std::fstream	inputStream(inputFile,	std::ifstream::binary | std::ifstream::in);
-
-			inputStream.seekg(0,	inputStream.end);
-			long int lengthPos = inputStream.tellg();
 
-			vector<char>	fileContents(lengthPos - startPos);
+			long int lengthPos = reader.mappedFile.size();
 
-			inputStream.seekg(startPos,	inputStream.beg);
-
-			inputStream.read(&fileContents[0], lengthPos - startPos);
-			tempStream.write(&fileContents[0], lengthPos - startPos);
+			tempStream.write(reader.mappedFile.data() + startPos, lengthPos - startPos);
 		}
 
+		reader.mappedFile.close();
+
 		std::remove(inputFile.c_str());
 		std::rename(tempFile.c_str(), inputFile.c_str());
 	}
@@ -449,6 +539,8 @@ KFState RTS_Process(
 		BOOST_LOG_TRIVIAL(info) 
 		<< "Removing RTS file: " << inputFile;
 		
+		reader.mappedFile.close();
+		
 		std::remove(inputFile.c_str());
 		
 		BOOST_LOG_TRIVIAL(info) 
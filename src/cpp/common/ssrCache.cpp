@@ -0,0 +1,213 @@
+
+// #pragma GCC optimize ("O0")
+
+#include <mutex>
+
+#include "ssrCache.hpp"
+#include "common.hpp"
+
+SsrProductCache ssrProductCache;
+
+/** Add the products calculated for an epoch to the cache, and remove any that are too old to be used
+*/
+void SsrProductCache::publish(
+	GTime							time,				///< Time of the epoch the products were calculated for
+	map<SatSys, SsrSatProducts>&	newProductsMap)		///< Products to add, entries for existing epochs replace those already in the cache
+{
+	std::unique_lock<std::shared_mutex> writeLock(mutex);
+
+	GTime cullTime = time - 300.0;
+
+	for (auto& [Sat, newProducts] : newProductsMap)
+	{
+		auto& products = satProductsMap[Sat];
+
+		for (auto& [epoch, ephValues]	: newProducts.ephMap)		{	products.ephMap[epoch]	= ephValues;	}
+		for (auto& [epoch, clkValues]	: newProducts.clkMap)		{	products.clkMap[epoch]	= clkValues;	}
+
+		//biases are stored per signal, keep any signals that were published earlier for the same epoch
+		for (auto& [epoch, newCodeBias] : newProducts.codeBiasMap)
+		{
+			auto& codeBias = products.codeBiasMap[epoch];
+
+			codeBias.t0 = newCodeBias.t0;
+
+			for (auto& [obsCode, biasVar] : newCodeBias.obsCodeBiasMap)
+			{
+				codeBias.obsCodeBiasMap[obsCode] = biasVar;
+			}
+		}
+
+		for (auto& [epoch, newPhasBias] : newProducts.phasBiasMap)
+		{
+			auto& phasBias = products.phasBiasMap[epoch];
+
+			phasBias.t0			= newPhasBias.t0;
+			phasBias.ssrPhase	= newPhasBias.ssrPhase;
+
+			for (auto& [obsCode, biasVar] : newPhasBias.obsCodeBiasMap)
+			{
+				phasBias.obsCodeBiasMap	[obsCode] = biasVar;
+				phasBias.ssrPhaseChs	[obsCode] = newPhasBias.ssrPhaseChs[obsCode];
+			}
+		}
+	}
+
+	for (auto& [Sat, products] : satProductsMap)
+	{
+		products.ephMap		.erase(products.ephMap		.begin(), products.ephMap		.lower_bound(cullTime));
+		products.clkMap		.erase(products.clkMap		.begin(), products.clkMap		.lower_bound(cullTime));
+		products.codeBiasMap.erase(products.codeBiasMap	.begin(), products.codeBiasMap	.lower_bound(cullTime));
+		products.phasBiasMap.erase(products.phasBiasMap	.begin(), products.phasBiasMap	.lower_bound(cullTime));
+	}
+}
+
+/** Get up to two entries from either side of the target time, in time order
+*/
+template <typename VALUES>
+deque<VALUES> getNeighbours(
+	GTime					targetTime,
+	map<GTime, VALUES>&		valuesMap)
+{
+	deque<VALUES> valuesVec;
+
+	auto after = valuesMap.upper_bound(targetTime);
+
+	auto it = after;
+	for (int i = 0; i < 2 && it != valuesMap.begin(); i++)
+	{
+		it--;
+		valuesVec.push_front(it->second);
+	}
+
+	it = after;
+	for (int i = 0; i < 2 && it != valuesMap.end(); i++, it++)
+	{
+		valuesVec.push_back(it->second);
+	}
+
+	return valuesVec;
+}
+
+/** Retrieve orbit and clock precursors that straddle the target time, equivalent to mongoReadSSRData()
+*/
+map<SatSys, SSROut> cacheReadSSRData(
+	GTime	targetTime,		///< Time to retrieve values for
+	SSRMeta	ssrMeta,		///< Metadata of the messages to be encoded
+	int		masterIod,		///< IOD of the messages to be encoded
+	E_Sys	targetSys)		///< System to retrieve values for
+{
+	map<SatSys, SSROut> ssrOutMap;
+
+	std::shared_lock<std::shared_mutex> readLock(ssrProductCache.mutex);
+
+	auto sats = getSysSats(targetSys);
+	for (auto Sat : sats)
+	{
+		auto it = ssrProductCache.satProductsMap.find(Sat);
+		if (it == ssrProductCache.satProductsMap.end())
+		{
+			continue;
+		}
+
+		auto& [dummy, products] = *it;
+
+		deque<EphValues> ephVec = getNeighbours(targetTime, products.ephMap);
+		deque<ClkValues> clkVec = getNeighbours(targetTime, products.clkMap);
+
+		//try to find a set of things that straddle the target time, with the same iode
+		SSROut ssrOut;
+		ssrOut.ephInput = getStraddle<SSREphInput>(targetTime, ephVec);
+		ssrOut.clkInput = getStraddle<SSRClkInput>(targetTime, clkVec);
+
+		if	(ssrOut.ephInput.valid == false)
+		{
+			tracepdeex(3, std::cout, "Could not retrieve valid ephemeris for %s\n", Sat.id().c_str());
+			continue;
+		}
+		if	( ssrOut.clkInput.valid == false)
+		{
+			tracepdeex(3, std::cout, "Could not retrieve valid clock     for %s\n", Sat.id().c_str());
+			continue;
+		}
+
+		ssrOutMap[Sat] = ssrOut;
+	}
+
+	return ssrOutMap;
+}
+
+/** Retrieve the newest phase biases, equivalent to mongoReadPhaseBias()
+*/
+SsrPBMap cacheReadPhaseBias(
+	GTime	time,			///< Time to retrieve values for
+	SSRMeta	ssrMeta,		///< Metadata of the messages to be encoded
+	int		masterIod,		///< IOD of the messages to be encoded
+	E_Sys	targetSys)		///< System to retrieve values for
+{
+	SsrPBMap ssrPBMap;
+
+	std::shared_lock<std::shared_mutex> readLock(ssrProductCache.mutex);
+
+	auto sats = getSysSats(targetSys);
+	for (auto Sat : sats)
+	{
+		auto it = ssrProductCache.satProductsMap.find(Sat);
+		if	( it == ssrProductCache.satProductsMap.end()
+			||it->second.phasBiasMap.empty())
+		{
+			continue;
+		}
+
+		auto& [dummy, products] = *it;
+
+		SSRPhasBias ssrPhasBias = products.phasBiasMap.rbegin()->second;
+		ssrPhasBias.ssrMeta	= ssrMeta;
+		ssrPhasBias.iod		= masterIod;
+
+		ssrPBMap[Sat] = ssrPhasBias;
+	}
+
+	return ssrPBMap;
+}
+
+/** Retrieve the newest code biases before the requested time, equivalent to mongoReadCodeBias()
+*/
+SsrCBMap cacheReadCodeBias(
+	GTime	time,			///< Time to retrieve values for
+	SSRMeta	ssrMeta,		///< Metadata of the messages to be encoded
+	int		masterIod,		///< IOD of the messages to be encoded
+	E_Sys	targetSys)		///< System to retrieve values for
+{
+	SsrCBMap ssrCBMap;
+
+	std::shared_lock<std::shared_mutex> readLock(ssrProductCache.mutex);
+
+	auto sats = getSysSats(targetSys);
+	for (auto Sat : sats)
+	{
+		auto it = ssrProductCache.satProductsMap.find(Sat);
+		if (it == ssrProductCache.satProductsMap.end())
+		{
+			continue;
+		}
+
+		auto& [dummy, products] = *it;
+
+		auto biasIt = products.codeBiasMap.lower_bound(time);
+		if (biasIt == products.codeBiasMap.begin())
+		{
+			continue;
+		}
+
+		biasIt--;
+
+		SSRCodeBias ssrCodeBias = biasIt->second;
+		ssrCodeBias.ssrMeta	= ssrMeta;
+		ssrCodeBias.iod		= masterIod;
+
+		ssrCBMap[Sat] = ssrCodeBias;
+	}
+
+	return ssrCBMap;
+}
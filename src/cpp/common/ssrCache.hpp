@@ -0,0 +1,117 @@
+
+#ifndef __SSR_CACHE_HPP__
+#define __SSR_CACHE_HPP__
+
+#include <shared_mutex>
+#include <deque>
+#include <map>
+
+using std::deque;
+using std::map;
+
+#include "rtcmEncoder.hpp"
+#include "satSys.hpp"
+#include "gTime.hpp"
+#include "ssr.hpp"
+
+
+/** SSR precursors calculated for a single satellite, keyed by the epoch they apply to
+*/
+struct SsrSatProducts
+{
+	map<GTime, EphValues>		ephMap;			///< Broadcast and precise orbits
+	map<GTime, ClkValues>		clkMap;			///< Broadcast and precise clocks
+	map<GTime, SSRCodeBias>		codeBiasMap;	///< Code biases for all signals
+	map<GTime, SSRPhasBias>		phasBiasMap;	///< Phase biases for all signals
+};
+
+/** In-process store of the SSR precursors published by the estimator after each epoch.
+* Holds the same entries that are written to the database, so that uploading streams may encode messages
+* from memory when the products are calculated by this process, rather than waiting on database queries.
+*/
+struct SsrProductCache
+{
+	std::shared_mutex				mutex;				///< Exclusive while publishing, shared while encoding
+	map<SatSys, SsrSatProducts>		satProductsMap;
+
+	void publish(
+		GTime							time,
+		map<SatSys, SsrSatProducts>&	newProductsMap);
+};
+
+extern SsrProductCache ssrProductCache;
+
+
+/** Find a pair of consecutive entries with the same iode that straddle the target time, or are as close as possible to doing so
+*/
+template <typename RETTYPE, typename INTYPE>
+RETTYPE getStraddle(
+	GTime			targetTime,
+	deque<INTYPE>&	ssrVec)
+{
+	RETTYPE ssr;
+
+	ssr.valid = true;
+
+	//try to find a set of things that straddle the target time, with the same iode
+
+	int bestI = -1;
+	int bestJ = -1;
+
+	for (int j = 1; j < ssrVec.size(); j++)
+	{
+		int i = j - 1;
+
+		auto& entryI = ssrVec[i];
+		auto& entryJ = ssrVec[j];
+
+		if (entryI.iode != entryJ.iode)
+		{
+			//no good, iodes dont match
+			continue;
+		}
+
+		//these are acceptable - store them for later
+		bestI = i;
+		bestJ = j;
+
+		if (entryJ.time > targetTime)
+		{
+			//this is as close as we will come to a straddle
+			break;
+		}
+	}
+
+	if (bestJ < 0)
+	{
+		//nothing found, dont use
+		ssr.valid = false;
+
+		return RETTYPE();
+	}
+
+	ssr.vals[0] = ssrVec[bestI];
+	ssr.vals[1]	= ssrVec[bestJ];
+
+	return ssr;
+}
+
+map<SatSys, SSROut> cacheReadSSRData(
+	GTime	targetTime,
+	SSRMeta	ssrMeta,
+	int		masterIod,
+	E_Sys	targetSys);
+
+SsrPBMap cacheReadPhaseBias(
+	GTime	time,
+	SSRMeta	ssrMeta,
+	int		masterIod,
+	E_Sys	targetSys);
+
+SsrCBMap cacheReadCodeBias(
+	GTime	time,
+	SSRMeta	ssrMeta,
+	int		masterIod,
+	E_Sys	targetSys);
+
+#endif
@@ -10,18 +10,27 @@ void NtripStream::getData()
 	{
 		//if ( receivedDataBuffer.size() > 0 )
 		//    BOOST_LOG_TRIVIAL(debug) << "NtripStream::getData(), receivedDataBuffer.size() = " << receivedDataBuffer.size() << std::endl;
-		receivedData.insert(receivedData.end(), receivedDataBuffer.begin(), receivedDataBuffer.end());
+		if (receivedData.empty())
+		{
+			//hand over the whole buffer rather than copying it, the io threads will refill the (previously used) empty one
+			std::swap(receivedData, receivedDataBuffer);
+		}
+		else
+		{
+			receivedData.insert(receivedData.end(), receivedDataBuffer.begin(), receivedDataBuffer.end());
+		}
 		receivedDataBuffer.clear();
 	}
 	receivedDataBufferMtx.unlock();
 }
 
 bool NtripStream::dataChunkDownloaded(
-	vector<char> dataChunk)
+	const char*	dataChunk,
+	size_t		length)
 {
 	receivedDataBufferMtx.lock();
 	{
-		receivedDataBuffer.insert(receivedDataBuffer.end(), dataChunk.begin(), dataChunk.end());
+		receivedDataBuffer.insert(receivedDataBuffer.end(), dataChunk, dataChunk + length);
 	}
 	receivedDataBufferMtx.unlock(); 
 	
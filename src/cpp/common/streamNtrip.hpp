@@ -53,7 +53,8 @@ public:
 	override;
 	
 	bool dataChunkDownloaded(
-		vector<char> dataChunk)
+		const char*	dataChunk,
+		size_t		length)
 	override;
 	
 	
@@ -62,8 +63,8 @@ public:
 	* io_service.run() blocks the thread in NtripStream::connect() and uses it in 
 	* the background to perform ansyncronous operations until io_service.stop()
 	* is called at which time the thread exits. 
-	* As it is detached there is no need for a join, there is one worker thread
-	* for all the NtripStream objects.
+	* As they are detached there is no need for a join, the worker threads are
+	* shared by all the NtripStream objects, (see acsConfig.ntrip_io_threads).
 	*/ 
 };
 
@@ -17,6 +17,7 @@ struct ObsStream
 	E_ObsWaitCode	obsWaitCode = E_ObsWaitCode::OK;
 
 	/** Return a list of observations from the stream.
+	* The observations are moved out of the stream, callers should eatObs() after using them, or return them with uneatObs().
 	* This function may be overridden by objects that use this interface
 	*/
 	virtual ObsList getObs();
@@ -53,6 +54,7 @@ struct ObsStream
 			else if	(obsList.front().time > time + delta)
 			{
 				obsWaitCode = E_ObsWaitCode::NO_DATA_EVER;
+				uneatObs(std::move(obsList));
 				return ObsList();
 			}
 			else
@@ -80,6 +82,21 @@ struct ObsStream
 			obsListList.pop_front();
 		}
 	}
+
+	/** Return observations that were retrieved but not used to the front of the stream
+	*/
+	void uneatObs(
+		ObsList&&	obsList)	///< Observations previously returned by getObs()
+	{
+		if (obsListList.empty())
+		{
+			obsListList.push_front(std::move(obsList));
+		}
+		else
+		{
+			obsListList.front() = std::move(obsList);
+		}
+	}
 };
 
 /** Interface for streams that supply observations
@@ -4,8 +4,11 @@
 
 #include <boost/date_time/posix_time/posix_time.hpp>
 
+#include <iostream>
+#include <vector>
 #include <map>
 
+using std::vector;
 using std::map;
 using std::pair;
 
@@ -104,8 +107,83 @@ struct LockTimeInfo
 };
 
 
+/** Contiguous buffer of received RTCM bytes, from which frames are decoded in place.
+* Consumed bytes are only discarded when more data is appended and they make up most of the buffer,
+* so each byte is moved at most a few times, rather than erasing from the front after every read.
+*
+* Pointers into the buffer remain valid until the next append.
+*/
+struct RtcmFrameBuffer
+{
+	vector<unsigned char>	data;
+	size_t					readPos	= 0;		///< Position of the first unconsumed byte
+
+	const unsigned char* begin() const
+	{
+		return data.data() + readPos;
+	}
+
+	size_t size() const
+	{
+		return data.size() - readPos;
+	}
+
+	void consume(
+		size_t	len)
+	{
+		readPos += std::min(len, size());
+	}
+
+	void compact()
+	{
+		if	( readPos > 0
+			&&readPos >= size())
+		{
+			data.erase(data.begin(), data.begin() + readPos);
+			readPos = 0;
+		}
+	}
+
+	void append(
+		const char*	bytes,
+		size_t		len)
+	{
+		compact();
+
+		data.insert(data.end(), bytes, bytes + len);
+	}
+
+	/** Read up to len bytes from a stream onto the end of the buffer, returning the number of bytes read
+	*/
+	size_t append(
+		std::istream&	inputStream,
+		size_t			len)
+	{
+		compact();
+
+		size_t oldSize = data.size();
+		data.resize(oldSize + len);
+
+		inputStream.read((char*) data.data() + oldSize, len);
+
+		size_t got = inputStream.gcount();
+		data.resize(oldSize + got);
+
+		if	( got > 0
+			&&inputStream.eof())
+		{
+			//keep the stream usable so that its position may be recorded, it will fail again next time if there is nothing more to read
+			inputStream.clear();
+		}
+
+		return got;
+	}
+};
+
 struct RtcmStream : ObsStream, NavStream, RtcmDecoder
 {
+	RtcmFrameBuffer	rtcmBuffer;				///< Received bytes that have not yet been decoded
+
 	LockTimeInfo lock_time_info_current;
 	LockTimeInfo lock_time_info_previous;
 
@@ -119,6 +197,17 @@ struct RtcmStream : ObsStream, NavStream, RtcmDecoder
 	
 	void createRtcmFile();
 	
+	/** Store a complete epoch of decoded observations for retrieval by getObs().
+	* Overridden by streams that decode on a separate thread, to hand epochs over to the reader safely
+	*/
+	virtual void pushObsList(
+		ObsList&&	obsList)	///< Observations from all messages of an epoch
+	{
+		obsListList.push_back(std::move(obsList));
+	}
+	
+	bool parseRTCM();
+
 	void parseRTCM(
 		std::istream& inputStream);
 };
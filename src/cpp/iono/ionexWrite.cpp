@@ -24,20 +24,146 @@ int last_ionex = -1;
 
 static int ionex_map_index = 0;
 
-double ionVtec(
-	GTime time,
-	double* Ion_pp,
-	int layer,
-	double& vtecstd,
-	KFState& kfState)
+#define IONEX_BLOCK_SIZE	1024
+
+/** Coefficients of the ionosphere model basis functions, extracted from the filter once per map
+*/
+struct IonoModelState
+{
+	VectorXd	x;		///< Basis function coefficients, zero for any not in the filter
+	MatrixXd	P;		///< Full covariance of the basis function coefficients
+};
+
+/** Values of the ionosphere model over the ionex grid for a single layer, in map order.
+* Nodes outside the region of validity of the model are zero
+*/
+struct IonexLayerMap
 {
-	switch (acsConfig.ionModelOpts.model)
+	VectorXd	vtec;
+	VectorXd	variance;
+};
+
+/** Extract the basis function coefficients and their covariance from the filter
+*/
+IonoModelState getIonoModelState(
+	KFState&	kfState)	///< Filter containing the ionosphere model
+{
+	int numBasis = acsConfig.ionModelOpts.NBasis;
+
+	vector<int> indices(numBasis, -1);
+
+	for (int ind = 0; ind < numBasis; ind++)
+	{
+		KFKey keyC;
+		keyC.type	= KF::IONOSPHERIC;
+		keyC.num	= ind;
+
+		auto it = kfState.kfIndexMap.find(keyC);
+		if	(  it == kfState.kfIndexMap.end()
+			|| it->second >= kfState.x.size())
+		{
+			continue;
+		}
+
+		indices[ind] = it->second;
+	}
+
+	IonoModelState ionoState;
+	ionoState.x = VectorXd::Zero(numBasis);
+	ionoState.P = MatrixXd::Zero(numBasis, numBasis);
+
+	for (int i = 0; i < numBasis; i++)
 	{
-		case E_IonoModel::SPHERICAL_HARMONICS:		return ionVtecSphhar(time, Ion_pp, layer, vtecstd, kfState);
-		case E_IonoModel::SPHERICAL_CAPS:			return ionVtecSphcap(time, Ion_pp, layer, vtecstd, kfState);
-		case E_IonoModel::BSPLINE:					return ionVtecBsplin(time, Ion_pp, layer, vtecstd, kfState);
-		default:									return 0;
+		if (indices[i] < 0)
+			continue;
+
+		ionoState.x(i) = kfState.x(indices[i]);
+
+		for (int j = 0; j < numBasis; j++)
+		{
+			if (indices[j] < 0)
+				continue;
+
+			ionoState.P(i, j) = kfState.P(indices[i], indices[j]);
+		}
 	}
+
+	return ionoState;
+}
+
+/** Evaluate the vtec and its variance at every node of the ionex grid for a single layer.
+* The basis functions are evaluated for blocks of grid nodes at a time, and combined with the coefficients and their full covariance as matrix products
+*/
+IonexLayerMap renderIonexLayer(
+	GTime				time,		///< Time of the map
+	int					layer,		///< Layer to render
+	IonoModelState&		ionoState)	///< Basis function coefficients and covariance
+{
+	int numNodes = ionex_latres * ionex_lonres;
+
+	IonexLayerMap layerMap;
+	layerMap.vtec		= VectorXd::Zero(numNodes);
+	layerMap.variance	= VectorXd::Zero(numNodes);
+
+	vector<Obs>		blockObs(std::min(numNodes, IONEX_BLOCK_SIZE));
+	vector<Obs*>	obsPtrs;
+	vector<int>		nodes;
+
+	for (int begin = 0; begin < numNodes; begin += IONEX_BLOCK_SIZE)
+	{
+		obsPtrs	.clear();
+		nodes	.clear();
+
+		int end = std::min(numNodes, begin + IONEX_BLOCK_SIZE);
+
+		for (int node = begin; node < end; node++)
+		{
+			int ilat = node / ionex_lonres;
+			int ilon = node % ionex_lonres;
+
+			double ipp[3];
+			ipp[0] = (ionex_latmin + (ionex_latres - ilat - 1)	* ionex_latinc) * D2R;
+			ipp[1] = (ionex_lonmin + ilon						* ionex_loninc) * D2R;
+			ipp[2] = acsConfig.ionModelOpts.layer_heights[layer];
+
+			if (Ipp_in_range(time, ipp) == false)
+				continue;
+
+			Obs& obs = blockObs[obsPtrs.size()];
+
+			//vertical mapping on the requested layer only, so that the slant coefficients are those of the layer's vtec
+			for (int j = 0; j < acsConfig.ionModelOpts.layer_heights.size(); j++)
+			{
+				obs.latIPP[j] = ipp[0];
+				obs.lonIPP[j] = ipp[1];
+				obs.angIPP[j] = (j == layer) ? 1 : 0;
+			}
+			obs.STECtoDELAY = 1;
+
+			obsPtrs	.push_back(&obs);
+			nodes	.push_back(node);
+		}
+
+		if (obsPtrs.empty())
+			continue;
+
+		MatrixXd basis;
+		ion_coef_block(obsPtrs, basis, true);
+
+		VectorXd vtec		= basis * ionoState.x;
+		MatrixXd basisP		= basis * ionoState.P;
+		VectorXd variance	= (basisP.array() * basis.array()).rowwise().sum();
+
+		for (int i = 0; i < nodes.size(); i++)
+		{
+			int node = nodes[i];
+
+			layerMap.vtec		(node)	= vtec		(i);
+			layerMap.variance	(node)	= variance	(i);
+		}
+	}
+
+	return layerMap;
 }
 
 bool writeIonexHead(
@@ -119,6 +245,14 @@ int writeIonexEpoch(
 	tracepdeex(0, ionex, "%6d%54sSTART OF TEC MAP\n", ionex_map_index, " ");
 	tracepdeex(0, ionex, "%6.0f%6.0f%6.0f%6.0f%6.0f%6.0f%24sEPOCH OF CURRENT MAP\n", ep[0], ep[1], ep[2], ep[3], ep[4], ep[5], " ");
 
+	IonoModelState ionoState = getIonoModelState(kfState);
+
+	vector<IonexLayerMap> layerMaps;
+	for (int ihgt = 0; ihgt < acsConfig.ionModelOpts.layer_heights.size(); ihgt++)
+	{
+		layerMaps.push_back(renderIonexLayer(time, ihgt, ionoState));
+	}
+
 	list<double> tecrmsList;
 
 	for (int ihgt = 0; ihgt < acsConfig.ionModelOpts.layer_heights.size();	ihgt++)
@@ -143,8 +277,11 @@ int writeIonexEpoch(
 
 			ipp[1] = (ionex_lonmin + ilon * ionex_loninc) * D2R;
 
-			double vari;
-			double iono = ionVtec(time, ipp, ihgt, vari, kfState) / pow(10, IONEX_NEXP);
+			auto&	layerMap	= layerMaps[ihgt];
+			int		node		= ilat * ionex_lonres + ilon;
+
+			double vari = layerMap.variance	(node);
+			double iono = layerMap.vtec		(node) / pow(10, IONEX_NEXP);
 
 			tracepdeex(4, trace, "IPP: %8.4f,%9.4f; layr: %1d; delay: %12.6f; var: %.4e\n",
 					ipp[0]*R2D,
@@ -57,6 +57,28 @@ double ion_coef(
 	}
 }
 
+/** Evaluate all basis functions of the ionosphere model for a batch of observations
+*/
+void ion_coef_block(
+	vector<Obs*>&	obsPtrs,	///< Observations to evaluate the basis functions for
+	MatrixXd&		coefs,		///< Basis function values, one row per observation and one column per basis function
+	bool			slant)		///< Scale by the mapping of vtec to slant delay
+{
+	if (acsConfig.ionModelOpts.model == +E_IonoModel::SPHERICAL_HARMONICS)
+	{
+		ion_coef_block_sphhar(obsPtrs, coefs, slant);
+		return;
+	}
+
+	coefs = MatrixXd::Zero(obsPtrs.size(), acsConfig.ionModelOpts.NBasis);
+
+	for (int i = 0; i < obsPtrs.size(); i++)
+	for (int j = 0; j < acsConfig.ionModelOpts.NBasis; j++)
+	{
+		coefs(i, j) = ion_coef(j, *obsPtrs[i], slant);
+	}
+}
+
 /** Updating the ionosphere model parameters     
  * The ionosphere model should be initialized by calling 'config_ionosph_model'        
  * Ionosphere measurments from stations should be loaded using 'update_station_measr' 
@@ -152,8 +174,9 @@ void updateIonosphereModel(
 		tracepdeex(4, trace,"#IONO_MOD REF STATION for %s: %s\n", sys._to_string(), maxCountSta[sys]);
 	} 
 	
-	//add measurements and create design matrix entries
-	KFMeasEntryList kfMeasEntryList;
+	//find the measurements to use, and evaluate the model basis functions for all of them at once
+	vector<Obs*>		obsPtrs;
+	vector<Station*>	recPtrs;
 
 	for (auto& [id, rec]	: stations)
 	for (auto& obs			: rec.obsList)
@@ -163,6 +186,23 @@ void updateIonosphereModel(
 		if (obs.ionExclude)								{	continue;	}
 		if (stationlist[rec.id][sys] < MIN_NSAT_STA)	{	continue;	}
 		
+		obsPtrs.push_back(&obs);
+		recPtrs.push_back(&rec);
+	}
+	
+	MatrixXd coefs;
+	ion_coef_block(obsPtrs, coefs, true);
+	
+	//add measurements and create design matrix entries
+	KFMeasEntryList kfMeasEntryList;
+
+	for (int o = 0; o < obsPtrs.size(); o++)
+	{
+		Obs&		obs	= *obsPtrs[o];
+		Station&	rec	= *recPtrs[o];
+		
+		E_Sys sys = obs.Sat.sys;
+		
 		/************ Ionosphere Measurements ************/
 		ObsKey obsKey;
 		obsKey.Sat = obs.Sat;
@@ -192,7 +232,7 @@ void updateIonosphereModel(
 		
 		for (int i = 0; i < acsConfig.ionModelOpts.NBasis; i++)
 		{
-			double coef = ion_coef(i, obs, true);
+			double coef = coefs(o, i);
 			
 			KFKey ionModelKey;
 			ionModelKey.type	= KF::IONOSPHERIC;
@@ -61,6 +61,8 @@ extern KFState		iono_KFState;
 int  config_ionosph_model ();
 int  update_receivr_measr (Trace& trace, Station& rec);
 void updateIonosphereModel (Trace& trace, string ionstecFilename, string ionexFilename, StationMap& stationMap, GTime time);
+int  Ipp_in_range(GTime time, double *Ion_pp);
+void ion_coef_block(vector<Obs*>& obsPtrs, MatrixXd& coefs, bool slant = true);
 
 int  ionexFileWrite(
 	Trace&	trace, 
@@ -74,6 +76,7 @@ void writeReceiverMeasurements(Trace& trace, string filename, map<string, Statio
 int configure_iono_model_sphhar (void);
 int Ipp_check_sphhar(GTime time, double *Ion_pp);
 double ion_coef_sphhar(int ind, Obs& obs, bool slant = true);
+void ion_coef_block_sphhar(vector<Obs*>& obsPtrs, MatrixXd& coefs, bool slant = true);
 double ionVtecSphhar(GTime time, double *Ion_pp, int layer, double& vari, KFState& kfState);
 
 
@@ -315,6 +315,94 @@ double ion_coef_sphhar(int ind, Obs& obs, bool slant)
 	return out;
 }
 
+/** Evaluate all spherical harmonic basis functions for a batch of observations.
+* The associated Legendre functions and the longitude harmonics are generated once for all piercing points using their recurrences,
+* with each step applied across the whole batch, rather than expanding the polynomial of each basis function separately.
+*/
+void ion_coef_block_sphhar(
+	vector<Obs*>&	obsPtrs,	///< Observations to evaluate the basis functions for
+	MatrixXd&		coefs,		///< Basis function values, one row per observation and one column per basis function
+	bool			slant)		///< Scale by the mapping of vtec to slant delay
+{
+	int numObs	= obsPtrs.size();
+	int Kmax	= acsConfig.ionModelOpts.function_order + 1;
+	int nlay	= acsConfig.ionModelOpts.layer_heights.size();
+
+	coefs = MatrixXd::Zero(numObs, acsConfig.ionModelOpts.NBasis);
+
+	if (numObs == 0)
+		return;
+
+	for (int j = 0; j < nlay; j++)
+	{
+		ArrayXd lat		(numObs);
+		ArrayXd lon		(numObs);
+		ArrayXd scale	(numObs);
+
+		for (int i = 0; i < numObs; i++)
+		{
+			Obs& obs = *obsPtrs[i];
+
+			lat(i) = obs.latIPP[j];
+			lon(i) = obs.lonIPP[j];
+
+			if (slant)	scale(i) = obs.angIPP[j] * obs.STECtoDELAY;
+			else		scale(i) = 1;
+		}
+
+		ArrayXd sinlat = lat.sin();
+		ArrayXd coslat = lat.cos();
+
+		/* cos(m*lon), sin(m*lon) */
+		vector<ArrayXd> cosM(Kmax);
+		vector<ArrayXd> sinM(Kmax);
+
+		cosM[0] = ArrayXd::Ones		(numObs);
+		sinM[0] = ArrayXd::Zero		(numObs);
+
+		if (Kmax > 1)
+		{
+			cosM[1] = lon.cos();
+			sinM[1] = lon.sin();
+		}
+
+		for (int m = 2; m < Kmax; m++)
+		{
+			cosM[m] = 2 * cosM[1] * cosM[m - 1] - cosM[m - 2];
+			sinM[m] = 2 * cosM[1] * sinM[m - 1] - sinM[m - 2];
+		}
+
+		/* leg[m][n], following the same recurrences used to build the basis polynomials */
+		vector<vector<ArrayXd>> leg(Kmax, vector<ArrayXd>(Kmax));
+
+		for (int m = 0; m < Kmax; m++)
+		{
+			if (m == 0)		leg[0][0] = ArrayXd::Ones(numObs);
+			else			leg[m][m] = -(2 * m - 1) * sinlat * leg[m - 1][m - 1];		/* leg(m,m)		= -(2m-1) * sinlat * leg(m-1,m-1) */
+
+			if (m + 1 < Kmax)
+				leg[m][m + 1] = (2 * m + 1) * coslat * leg[m][m];						/* leg(m,m+1)	=  (2m+1) * coslat * leg(m,m) */
+
+			for (int n = m + 2; n < Kmax; n++)
+			{
+				leg[m][n] = ((2 * n - 1) * coslat * leg[m][n - 1] - (n + m - 1) * leg[m][n - 2]) / (n - m);
+			}
+		}
+
+		for (int ind = 0; ind < acsConfig.ionModelOpts.NBasis; ind++)
+		{
+			Sph_Basis& basis = Sph_Basis_list[ind];
+
+			if (basis.hind != j)
+				continue;
+
+			auto& lonFunc = basis.parity ? sinM[basis.order] : cosM[basis.order];
+
+			coefs.col(ind) = (basis.norm * leg[basis.order][basis.degree] * lonFunc * scale).matrix();
+		}
+	}
+}
+
 /*-------------------------------------------------------------------------
 ion_vtec_sphcap: Estimate Ionosphere VTEC using Spherical Cap Harmonic models
 	gtime_t  time		I		time of solutions (not useful for this one
@@ -5,10 +5,13 @@
 #include <algorithm>
 #include <iostream>
 #include <fstream>
+#include <condition_variable>
 #include <memory>
 #include <chrono>
 #include <thread>
 #include <string>
+#include <mutex>
+#include <list>
 
 #ifdef ENABLE_PARALLELISATION
 	#include "omp.h"
@@ -19,6 +22,7 @@ using std::this_thread::sleep_for;
 using std::chrono::system_clock;
 using std::chrono::time_point;
 using std::string;
+using std::list;
 
 #include <boost/log/utility/setup/console.hpp>
 #include <boost/log/trivial.hpp>
@@ -74,6 +78,10 @@ Navigation		nav		= {};
 int				epoch	= 1;
 GTime			tsync	= GTime::noTime();
 
+std::mutex		inputStreamMutex;		///< Guards the stream containers while inputs are read on a separate thread
+
+thread_local NavRequests* NavRequests::active_ptr = nullptr;
+
 bool fileChanged(
 	string filename)
 {
@@ -544,6 +552,8 @@ void configureDownloadingStreams()
 					replaceString(filename, "<STREAM>",		mount);
 					downloadStream.rtcmTraceFilename = filename;
 				}
+				
+				downloadStream.startDecoding();
 			}
 
 			if (nav == false)		{	obsStreamMultimap.insert({id, std::move(ntripStream_ptr)});		}
@@ -645,6 +655,7 @@ void createTracefiles(
 								acsConfig.ionex_directory,
 								acsConfig.sinex_directory,
 								acsConfig.trace_directory,
+								acsConfig.profile_directory,
 								acsConfig.orbits_directory,
 								acsConfig.clocks_directory,
 								acsConfig.ionstec_directory,
@@ -692,6 +703,9 @@ void createTracefiles(
 				if (newTraceFile)
 				{
 	// 				std::cout << std::endl << "new trace file";
+					closeArchiveStream(net.kfState.rts_basename + FORWARD_SUFFIX);
+					closeArchiveStream(net.kfState.rts_basename + BACKWARD_SUFFIX);
+					
 					std::remove((net.kfState.rts_basename					).c_str());
 					std::remove((net.kfState.rts_basename + FORWARD_SUFFIX	).c_str());
 					std::remove((net.kfState.rts_basename + BACKWARD_SUFFIX	).c_str());
@@ -706,6 +720,9 @@ void createTracefiles(
 				if (newTraceFile)
 				{
 // 					std::cout << std::endl << "new trace file";
+					closeArchiveStream(rec.pppState.rts_basename + FORWARD_SUFFIX);
+					closeArchiveStream(rec.pppState.rts_basename + BACKWARD_SUFFIX);
+					
 					std::remove((rec.pppState.rts_basename					).c_str());
 					std::remove((rec.pppState.rts_basename + FORWARD_SUFFIX	).c_str());
 					std::remove((rec.pppState.rts_basename + BACKWARD_SUFFIX).c_str());
@@ -851,6 +868,11 @@ void createTracefiles(
 	{
 		createNewTraceFile("", 		logptime,	acsConfig.bias_sinex_filename,	fileNames[acsConfig.bias_sinex_filename]);
 	}	
+	
+	if (acsConfig.output_profile)
+	{
+		createNewTraceFile("", 		logptime,	acsConfig.profile_filename,		fileNames[acsConfig.profile_filename]);
+	}
 }
 
 void avoidCollisions(
@@ -913,6 +935,8 @@ void initialiseStation(
 		rec.pppState.max_filter_iter	= acsConfig.pppOpts.max_filter_iter;
 		rec.pppState.max_prefit_remv	= acsConfig.pppOpts.max_prefit_remv;
 		rec.pppState.inverter			= acsConfig.pppOpts.inverter;
+		rec.pppState.block_covariance	= acsConfig.pppOpts.block_covariance;
+		rec.pppState.sparse_measurements	= acsConfig.pppOpts.sparse_measurements;
 		rec.pppState.sigma_threshold	= acsConfig.pppOpts.sigma_threshold;
 		rec.pppState.sigma_check		= acsConfig.pppOpts.sigma_check;
 		rec.pppState.w_test				= acsConfig.pppOpts.w_test;
@@ -1113,10 +1137,13 @@ void mainPerEpochPostProcessingAndOutputs(
 	{
 		if (acsConfig.output_mongo_states)
 		{
-			mongoStates(net.kfState);
+			//the network filter is output once per epoch, so its states may be inserted without searching for earlier values
+			mongoStates(net.kfState, "", false);
 		}
 		
-		KFState KF_ARcopy = net.kfState;
+		//take an estimates-only snapshot for the fixed solution rather than a deep copy of the filter, reusing its storage each epoch
+		static KFState KF_ARcopy;
+		KF_ARcopy.snapshot(net.kfState);
 		
 		if (acsConfig.ambrOpts.NLmode != +E_ARmode::OFF)
 		{
@@ -1190,7 +1217,7 @@ void mainPerEpochPostProcessingAndOutputs(
 		if	(  ARsol_ready() 
 			&& acsConfig.output_ar_clocks)
 		{
-			KFState KF_ARcopy = retrieve_last_ARcopy();
+			KFState& KF_ARcopy = retrieve_last_ARcopy();
 			prepareSsrStates(netTrace, KF_ARcopy,	tsync);
 		}
 		else
@@ -1214,6 +1241,11 @@ void mainPerEpochPostProcessingAndOutputs(
 		outputApriori		(stationMap);
 		outputDeltaClocks	(stationMap);
 	}
+	
+	if (mongo_ptr)
+	{
+		mongoWriter.outputStatistics(netTrace);
+	}
 }
 
 void mainOncePerEpoch(
@@ -1225,12 +1257,21 @@ void mainOncePerEpoch(
 	TestStack	ts			("1/Ep");
 	
 	//load any changes from the config
-	bool newConfig = acsConfig.parse();
+	bool newConfig;
+	{
+		std::unique_lock<std::shared_mutex> guard(configMutex);
+		
+		newConfig = acsConfig.parse();
+	}
 	
 	avoidCollisions(stationMap);
 	
 	//reload any new or modified files
-	reloadInputFiles();
+	{
+		std::lock_guard<std::mutex> guard(inputStreamMutex);
+		
+		reloadInputFiles();
+	}
 
 	addDefaultBiasSinex();
 	
@@ -1239,6 +1280,8 @@ void mainOncePerEpoch(
 	//make any changes to streams.
 	if (newConfig)
 	{
+		std::lock_guard<std::mutex> guard(inputStreamMutex);
+		
 		configureDownloadingStreams();
 		configureUploadingStreams();
 	}
@@ -1264,24 +1307,35 @@ void mainOncePerEpoch(
 			Sat.setSvn(pcvsat_ptr->svn);
 		}
 	}
+	
+	//interpolate precise orbits once for all stations
+	cachePreciseOrbits(time, nav);
 		
 	//do per-station pre processing
+	vector<Station*> stationList;
+	stationList.reserve(stationMap.size());
+	for (auto& [id, rec] : stationMap)
+	{
+		stationList.push_back(&rec);
+	}
+	
 	bool emptyEpoch = true;
 #	ifdef ENABLE_PARALLELISATION
 #	ifndef ENABLE_UNIT_TESTS
-		Eigen::setNbThreads(1);
-#		pragma omp parallel for
+		//start the most expensive stations first, so that the dynamic schedule can fill in around them with the smaller ones
+		std::stable_sort(stationList.begin(), stationList.end(), [](Station* a, Station* b)
+		{
+			return a->obsList.size() > b->obsList.size();
+		});
+		
+#		pragma omp parallel for schedule(dynamic) reduction(&&:emptyEpoch)
 #	endif
 #	endif
-	for (int i = 0; i < stationMap.size(); i++)
+	for (int i = 0; i < stationList.size(); i++)
 	{
-		auto rec_ptr_iterator = stationMap.begin();
-		std::advance(rec_ptr_iterator, i);
-
-		auto& [id, rec] = *rec_ptr_iterator;
+		auto& rec = *stationList[i];
 		mainOncePerEpochPerStation(rec,nav.orography, nav.gptg, emptyEpoch);
 	}
-	Eigen::setNbThreads(0);
 
 	if	(emptyEpoch)
 	{
@@ -1432,332 +1486,358 @@ void mainPostProcessing(
 	outputSummaries(netTrace, stationMap);
 }
 
-int main(
-	int		argc, 
-	char**	argv)
+/** Output the timing of profiled scopes that completed during the last epoch
+*/
+void outputProfiling(
+	Network&	net)
 {
-	tracelevel(5);
-
-	boost::log::core::get()->set_filter (boost::log::trivial::severity >= boost::log::trivial::info);
-	boost::log::add_console_log(std::cout, boost::log::keywords::format = "%Message%");
-
-	BOOST_LOG_TRIVIAL(info)
-	<< "PEA starting... (" << GINAN_BRANCH_NAME << " " GINAN_COMMIT_VERSION " from " << GINAN_COMMIT_DATE << ")" << std::endl;
-
-	auto peaStartTime = boost::posix_time::from_time_t(system_clock::to_time_t(system_clock::now()));
-
-	exitOnErrors();
-	
-	bool pass = configure(argc, argv);
-	if (pass == false)
+	if (acsConfig.output_profile_summary)
 	{
-		BOOST_LOG_TRIVIAL(error) 	<< "Error: Incorrect configuration";
-		BOOST_LOG_TRIVIAL(info) 	<< "PEA finished";
-		NtripSocket::io_service.stop();
-		return EXIT_FAILURE;
+		auto netTrace = getTraceFile(net);
+		
+		Instrument::outputEpochSummary(netTrace);
 	}
 	
-	if (acsConfig.output_log)
+	if (acsConfig.output_profile)
 	{
-		addFileLog();
+		Instrument::outputChromeTrace(fileNames[acsConfig.profile_filename]);
 	}
-	
-
-	TestStack::openData();
-
-	BOOST_LOG_TRIVIAL(info)
-	<< "Threading with " << Eigen::nbThreads()
-	<< " threads" << std::endl;
+}
 
-	
+/** Bounded queue for passing work between threads.
+* Producers wait while the queue is full, consumers wait while it is empty, and closing the queue releases both.
+*/
+template<typename T>
+struct BoundedQueue
+{
+	std::mutex				mutex;
+	std::condition_variable	notFull;
+	std::condition_variable	notEmpty;
+	list<T>					items;
+	size_t					capacity	= 1;
+	bool					closed		= false;
 
-	BOOST_LOG_TRIVIAL(info)
-	<< "Logging with trace level:" << acsConfig.trace_level << std::endl << std::endl;
+	/** Add an item to the back of the queue, waiting for space if required.
+	* Returns false if the queue has been closed
+	*/
+	bool push(
+		T&&	item)		///< Item to add to the queue
+	{
+		std::unique_lock<std::mutex> lock(mutex);
 
-	tracelevel(acsConfig.trace_level);
+		notFull.wait(lock, [&]{ return closed || items.size() < capacity; });
 
-	//read orography file for VMF3
-	{
-		int orog_sucess = false;
-		if 	( acsConfig.model.trop.orography.empty() == false		//todo aaron, check the option, not the filename, or just read anyway
-			&&acsConfig.model.trop.vmf3dir	.empty() == false)
+		if (closed)
 		{
-			orog_sucess = readorog(acsConfig.model.trop.orography, nav.orography);
+			return false;
 		}
 
-		if (orog_sucess == false)
-		{
-			// read gpt2 grid file
-			readgrid(acsConfig.model.trop.gpt2grid, &nav.gptg);
-		}
-	}
+		items.push_back(std::move(item));
 
-	if (acsConfig.input_persistance)
-	{
-		BOOST_LOG_TRIVIAL(info)
-		<< "Loading persistant navigation object to continue processing...";
+		notEmpty.notify_one();
 
-		inputPersistanceNav();
+		return true;
 	}
 
-	if (acsConfig.process_ionosphere)
+	/** Remove an item from the front of the queue, waiting for one to arrive if required.
+	* Returns false if the queue has been closed and emptied
+	*/
+	bool pop(
+		T&	item)		///< Destination for the removed item
 	{
-		bool pass = config_ionosph_model();
-		if	(pass == false)
-		{
-			BOOST_LOG_TRIVIAL(error)
-			<< "Error in Ionosphere Model configuration";
+		std::unique_lock<std::mutex> lock(mutex);
 
-			return EXIT_FAILURE;
+		notEmpty.wait(lock, [&]{ return closed || items.empty() == false; });
+
+		if (items.empty())
+		{
+			return false;
 		}
-	}
-	
-	if	( acsConfig.ambrOpts.NLmode != +E_ARmode::OFF )
-		config_AmbigResl();
 
-	map<string, Station> stationMap;
-	
-	//prepare the satNavMap so that it at least has entries for everything
-	{
-		for (int prn = MINPRNGPS; prn <= MAXPRNGPS; prn++)	{	SatSys s(E_Sys::GPS, prn);	nav.satNavMap[s];	}
-		for (int prn = MINPRNGLO; prn <= MAXPRNGLO; prn++)	{	SatSys s(E_Sys::GLO, prn);	nav.satNavMap[s];	}
-		for (int prn = MINPRNGAL; prn <= MAXPRNGAL; prn++)	{	SatSys s(E_Sys::GAL, prn);	nav.satNavMap[s];	}
-		for (int prn = MINPRNBDS; prn <= MAXPRNBDS; prn++)	{	SatSys s(E_Sys::BDS, prn);	nav.satNavMap[s];	}	
-	}
+		item = std::move(items.front());
+		items.pop_front();
 
-	Network net;
-	{
-		net.kfState.id					= "Net";
-		net.kfState.max_filter_iter		= acsConfig.pppOpts.max_filter_iter;
-		net.kfState.max_prefit_remv		= acsConfig.pppOpts.max_prefit_remv;
-		net.kfState.inverter			= acsConfig.pppOpts.inverter;
-		net.kfState.sigma_check			= acsConfig.pppOpts.sigma_check;
-		net.kfState.sigma_threshold		= acsConfig.pppOpts.sigma_threshold;
-		net.kfState.w_test				= acsConfig.pppOpts.w_test;
-		net.kfState.chi_square_test		= acsConfig.pppOpts.chi_square_test;
-		net.kfState.chi_square_mode		= acsConfig.pppOpts.chi_square_mode;
-		net.kfState.output_residuals	= acsConfig.output_residuals;
-		net.kfState.measRejectCallbacks	.push_back(deweightMeas);
-		net.kfState.measRejectCallbacks	.push_back(incrementPhaseSignalError);
-		net.kfState.stateRejectCallbacks.push_back(deweightByState);
-	}
+		notFull.notify_one();
 
-	if	(  acsConfig.process_rts
-		&& acsConfig.pppOpts.rts_lag)
-	{
-		net.kfState.rts_lag		= acsConfig.pppOpts.rts_lag;
-		iono_KFState.rts_lag	= acsConfig.pppOpts.rts_lag;
+		return true;
 	}
 
-	//initialise mongo
-	mongoooo();
-	
-	if (acsConfig.rts_only)
-	{
-		net.kfState.rts_lag = 4000;
-		net.kfState.rts_basename = acsConfig.pppOpts.rts_filename;
-		
-		RTS_Process(net.kfState);
-		
-		exit(0);
-	}
-	
-	if (acsConfig.input_persistance)
+	/** Prevent any further items being added, and wake any waiting threads
+	*/
+	void close()
 	{
-		BOOST_LOG_TRIVIAL(info)
-		<< "Loading persistant states to continue processing...";
+		std::unique_lock<std::mutex> lock(mutex);
 
-		inputPersistanceStates(stationMap, net.kfState);
+		closed = true;
+
+		notFull .notify_all();
+		notEmpty.notify_all();
 	}
-	
-	initialiseBiasSinex();
+};
 
-	reloadInputFiles();
+/** Configuration used while syncing inputs.
+* Copied at the start of each epoch while the configuration is not being reloaded,
+* so that inputs read on a separate thread see consistent values for the whole epoch.
+* Anything else read from the configuration by the input thread, (eg by decoders), is only read while holding the config mutex
+*/
+struct InputConfig
+{
+	double						epoch_interval		= 1;
+	double						wait_next_epoch		= 0;
+	double						wait_all_stations	= 0;
+	bool						require_obs			= true;
+	int							max_epochs			= 0;
+	boost::posix_time::ptime	end_epoch			{ boost::posix_time::not_a_date_time };
+};
+
+/** Returns a copy of the configuration used while syncing inputs
+*/
+InputConfig getInputConfig()
+{
+	std::shared_lock<std::shared_mutex> guard(configMutex);
 
-	addDefaultBiasSinex();
+	InputConfig inputConfig;
+	inputConfig.epoch_interval		= acsConfig.epoch_interval;
+	inputConfig.wait_next_epoch		= acsConfig.wait_next_epoch;
+	inputConfig.wait_all_stations	= acsConfig.wait_all_stations;
+	inputConfig.require_obs			= acsConfig.require_obs;
+	inputConfig.max_epochs			= acsConfig.max_epochs;
+	inputConfig.end_epoch			= acsConfig.end_epoch;
 
-	NtripSocket::startClients();
+	return inputConfig;
+}
 
-	configureDownloadingStreams();
-	configureUploadingStreams();
-	
-	for (auto& [id, s] : obsStreamMultimap)
-	{
-		auto& rec = stationMap[id];
-		
-		initialiseStation(id, rec);
-	}
-	
-	createTracefiles(stationMap, net);
-	
-	//initialise mongo
-	mongoooo();
-	
-	if (acsConfig.mincon_only)
+/** Observations read from a single station's stream while syncing an epoch
+*/
+struct StationInput
+{
+	list<ObsList>	obsLists;			///< Lists read from the stream in order, each requiring preprocessing. The last is for the synced epoch if ready
+	bool			ready	= false;	///< Observations for the synced epoch were found
+};
+
+/** Inputs synced for an epoch, to be preprocessed and processed by the estimator
+*/
+struct EpochInput
+{
+	GTime						time		= GTime::noTime();	///< Time of the synced epoch
+	int							epoch		= 0;				///< Number of the synced epoch
+	bool						newStart	= false;			///< The epoch time was initialised from the data for this epoch
+	bool						complete	= false;			///< All inputs have finished, no epoch was synced
+	NavRequests					navRequests;					///< Modifications to the navigation data decoded while syncing this epoch
+	map<string, StationInput>	stationInputMap;
+	map<string, PseudoObsList>	pseudoObsListMap;
+};
+
+/** Reads and syncs the inputs for successive epochs.
+* This is the input half of the main processing loop, used directly by the estimator, or by the input thread when epochs are pipelined,
+* so that both have the same timing and waiting behaviour.
+*
+* Inputs never modify data used by the estimator while syncing:
+* modifications to the navigation data are recorded with the epoch's inputs, and observations are left for the estimator to preprocess.
+* Streams are only removed while holding a lock shared with the estimator, which modifies the stream containers when inputs are reloaded.
+*/
+struct EpochSyncer
+{
+	GTime						syncTime;										///< Time of the epoch being synced, if known
+	int							syncEpoch;										///< Number of the epoch being synced
+	int							loopEpochs					= 0;				///< Number of epochs to advance before syncing the next
+	system_clock::time_point	nextNominalLoopStartTime	= system_clock::now() + 10s;	///< Time the next epoch is expected to start - if it doesnt start until after this, it may be skipped
+	InputConfig					inputConfig;									///< Configuration copied at the start of the epoch being synced
+	map<string, PseudoObsList>	pseudoObsListMap;								///< Latest pseudo observations from each stream, retained between epochs
+
+	EpochSyncer(
+		GTime	syncTime,		///< Time of the first epoch to sync, if known
+		int		syncEpoch)		///< Number of the first epoch to sync
+	:	syncTime	(syncTime),
+		syncEpoch	(syncEpoch)
 	{
-		minconOnly(std::cout, stationMap);
+
 	}
-	
-	doDebugs();
 
-	if (acsConfig.start_epoch.is_not_a_date_time() == false)
+	/** Read and sync the inputs for the next epoch, waiting for them to arrive if required
+	*/
+	EpochInput syncNext()
 	{
-		tsync.time = boost::posix_time::to_time_t(acsConfig.start_epoch);
-	}
+		while (true)
+		{
+			inputConfig = getInputConfig();
 
-	BOOST_LOG_TRIVIAL(info)
-	<< std::endl;
-	BOOST_LOG_TRIVIAL(info)
-	<< "Starting to process epochs...";
+			if (syncTime != GTime::noTime())
+			{
+				syncTime.time			+= loopEpochs * inputConfig.epoch_interval;
+			}
 
-	TestStack ts(acsConfig.config_description);
-	
-	//============================================================================
-	// MAIN PROCESSING LOOP														//
-	//============================================================================
+			syncEpoch					+= loopEpochs;
+			nextNominalLoopStartTime	+= loopEpochs * std::chrono::milliseconds((int)(inputConfig.wait_next_epoch * 1000));
 
-	// Read the observations for each station and do stuff
-	bool	complete					= false;							// When all input files are empty the processing is deemed complete - run until then, or until something else breaks the loop
-	int		loopEpochs					= 0;								// A count of how many loops of epoch_interval this loop used up (usually one, but may be more if skipping epochs)
-	auto	nextNominalLoopStartTime	= system_clock::now() + 10s;		// The time the next loop is expected to start - if it doesnt start until after this, it may be skipped
-	while (complete == false)
-	{
-		if (tsync != GTime::noTime())
-		{
-			tsync.time				+= loopEpochs * acsConfig.epoch_interval;
-		}
+			// Calculate the time at which we will stop waiting for data to come in for this epoch
+			auto breakTime	= nextNominalLoopStartTime
+							+ std::chrono::milliseconds((int)(inputConfig.wait_all_stations	* 1000));
 
-		epoch						+= loopEpochs;
-		nextNominalLoopStartTime	+= loopEpochs * std::chrono::milliseconds((int)(acsConfig.wait_next_epoch * 1000));
+			EpochInput	epochInput;
+			bool		complete	= false;
+			{
+				DeferNavRequests deferNav(epochInput.navRequests);
 
-		// Calculate the time at which we will stop waiting for data to come in for this epoch
-		auto breakTime	= nextNominalLoopStartTime
-						+ std::chrono::milliseconds((int)(acsConfig.wait_all_stations	* 1000));
+				complete = syncStreams(epochInput, breakTime);
+			}
 
-		BOOST_LOG_TRIVIAL(info) << std::endl
-		<< "Starting epoch #" << epoch;
+			if (complete)
+			{
+				EpochInput finalInput;
+				finalInput.epoch	= syncEpoch;
+				finalInput.complete	= true;
 
-		TestStack ts("Epoch " + std::to_string(epoch));
-		
-		for (auto& [id, rec] : stationMap)
-		{
-			rec.ready = false;
-			clearSlips(rec.obsList);
+				return finalInput;
+			}
+
+			if (syncTime == GTime::noTime())
+			{
+				if (inputConfig.require_obs)
+					continue;
+
+				syncTime = utc2gpst(timeget());
+			}
+
+			epochInput.time				= syncTime;
+			epochInput.epoch			= syncEpoch;
+			epochInput.pseudoObsListMap	= pseudoObsListMap;
+
+			return epochInput;
 		}
+	}
 
+	/** Poll all streams until observations for the epoch have been found for all stations, or it is time to stop waiting.
+	* Returns true if all inputs have finished
+	*/
+	bool syncStreams(
+		EpochInput&					epochInput,		///< Destination for the inputs of this epoch
+		system_clock::time_point&	breakTime)		///< Time at which to stop waiting for data to come in for this epoch
+	{
 		//get observations from streams (allow some delay between stations, and retry, to ensure all messages for the epoch have arrived)
-		map<string, bool>	dataAvailableMap;
-		bool 				foundFirst	= false;
-		bool				repeat		= true;
+		bool	foundFirst	= false;
+		bool	repeat		= true;
 		while	( repeat
 				&&system_clock::now() < breakTime)
 		{
-			if (acsConfig.require_obs)
+			if (inputConfig.require_obs)
 			{
 				repeat = false;
 			}
+			
+			//decoders and stations read the configuration while streams are polled, keep it from being reloaded until they are done
+			std::shared_lock<std::shared_mutex> configLock(configMutex);
+			
+			int waitingStreams = 0;
 
-			for (auto& [id, s] : navStreamMultimap)
+			multimap<string, ACSObsStreamPtr>		obsStreams;
+			multimap<string, ACSNavStreamPtr>		navStreams;
+			multimap<string, ACSPseudoObsStreamPtr>	pseudoObsStreams;
 			{
-				auto& navStream = *s;
-
-				navStream.getNav();
-			}
+				std::lock_guard<std::mutex> guard(inputStreamMutex);
 
-			//remove any dead streams
-			for (auto iter = obsStreamMultimap.begin(); iter != obsStreamMultimap.end(); )
-			{
-				auto& [dummy, obsStream_ptr]	= *iter;
-				auto& obsStream					= *obsStream_ptr;
-				
-				if (obsStream.isDead())
+				//remove any dead streams
+				for (auto iter = obsStreamMultimap.begin(); iter != obsStreamMultimap.end(); )
 				{
-					BOOST_LOG_TRIVIAL(info)
-					<< "No more data available on " << obsStream.sourceString << std::endl;
+					auto& [dummy, obsStream_ptr]	= *iter;
+					auto& obsStream					= *obsStream_ptr;
+
+					if (obsStream.isDead())
+					{
+						BOOST_LOG_TRIVIAL(info)
+						<< "No more data available on " << obsStream.sourceString << std::endl;
 
-					//record as dead and erase
-					streamDOAMap[obsStream.sourceString] = true;
+						//record as dead and erase
+						streamDOAMap[obsStream.sourceString] = true;
 
-					iter = obsStreamMultimap.erase(iter);
-				}
-				else
-				{
-					iter++;
+						iter = obsStreamMultimap.erase(iter);
+					}
+					else
+					{
+						iter++;
+					}
 				}
+
+				//take copies so that the estimator may modify the containers while these are polled
+				obsStreams			= obsStreamMultimap;
+				navStreams			= navStreamMultimap;
+				pseudoObsStreams	= pseudoObsStreamMultimap;
 			}
 
-			if	(  obsStreamMultimap		.empty()
-				&& pseudoObsStreamMultimap	.empty()
-				&& acsConfig.require_obs)
+			for (auto& [id, s] : navStreams)
 			{
-				BOOST_LOG_TRIVIAL(info)
-				<< std::endl;
-				BOOST_LOG_TRIVIAL(info)
-				<< "Inputs finished at epoch #" << epoch;
-
-				complete = true;
+				auto& navStream = *s;
 
-				break;
+				navStream.getNav();
 			}
 
-			for (auto& [id, s] : obsStreamMultimap)
+			if	(  obsStreams		.empty()
+				&& pseudoObsStreams	.empty()
+				&& inputConfig.require_obs)
 			{
-				ObsStream&	obsStream	= *s;
+				return true;
+			}
 
+			for (auto& [id, s] : obsStreams)
+			{
+				ObsStream&	obsStream		= *s;
+				
 				auto& recOpts = acsConfig.getRecOpts(id);
 
 				if (recOpts.exclude)
 				{
 					continue;
 				}
+				
+				auto&		stationInput	= epochInput.stationInputMap[id];
 
-				auto& rec = stationMap[id];
-
-				//try to get some data (again)
-				if (rec.ready == false)
+				//try to get some data (again), keeping the time of the latest list as the lists are moved out
+				GTime obsTime = GTime::noTime();
+				if (stationInput.ready == false)
 				{
 					bool moreData = true;
 					while (moreData)
 					{
-						rec.obsList = obsStream.getObs(tsync);
+						ObsList obsList = obsStream.getObs(syncTime);
+
+						if (obsList.empty())	obsTime = GTime::noTime();
+						else					obsTime = obsList.front().time;
 
 						switch (obsStream.obsWaitCode)
 						{
-							case E_ObsWaitCode::EARLY_DATA:							preprocessor(rec);	obsStream.eatObs();	break;
-							case E_ObsWaitCode::OK:				moreData = false;	preprocessor(rec);	obsStream.eatObs();	break;
-							case E_ObsWaitCode::NO_DATA_WAIT:	moreData = false;											break;
-							case E_ObsWaitCode::NO_DATA_EVER:	moreData = false;											break;
+							case E_ObsWaitCode::EARLY_DATA:							stationInput.obsLists.push_back(std::move(obsList));	obsStream.eatObs();	break;
+							case E_ObsWaitCode::OK:				moreData = false;	stationInput.obsLists.push_back(std::move(obsList));	obsStream.eatObs();	break;
+							case E_ObsWaitCode::NO_DATA_WAIT:	moreData = false;																break;
+							case E_ObsWaitCode::NO_DATA_EVER:	moreData = false;																break;
 						}
 					}
 				}
-				
-				if (rec.obsList.empty())
+
+				if (obsTime == GTime::noTime())
 				{
 					//failed to get observations
 					if (obsStream.obsWaitCode == +E_ObsWaitCode::NO_DATA_WAIT)
 					{
 						// try again later
 						repeat = true;
-						sleep_for(2ms);
+						waitingStreams++;
 					}
-					
+
 					continue;
 				}
-				
-				if (tsync == GTime::noTime())
+
+				if (syncTime == GTime::noTime())
 				{
-					tsync.time				= ((int) (rec.obsList.front().time / acsConfig.epoch_interval)) * acsConfig.epoch_interval;
-					acsConfig.start_epoch	= boost::posix_time::from_time_t(tsync);
-					
-					if (tsync + 0.5 < rec.obsList.front().time)
+					syncTime.time			= ((int) (obsTime / inputConfig.epoch_interval)) * inputConfig.epoch_interval;
+					epochInput.newStart		= true;
+
+					if (syncTime + 0.5 < obsTime)
 					{
 						repeat = true;
-						continue;	
+						continue;
 					}
 				}
 
-				dataAvailableMap[rec.id] = true;
-				
 				if (foundFirst == false)
 				{
 					foundFirst = true;
@@ -1766,123 +1846,502 @@ int main(
 					//only shorten waiting periods, never extend
 					auto now = system_clock::now();
 
-					auto alternateBreakTime = now + std::chrono::milliseconds((int)(acsConfig.wait_all_stations	* 1000));
-					auto alternateStartTime = now + std::chrono::milliseconds((int)(acsConfig.wait_next_epoch	* 1000));
+					auto alternateBreakTime = now + std::chrono::milliseconds((int)(inputConfig.wait_all_stations	* 1000));
+					auto alternateStartTime = now + std::chrono::milliseconds((int)(inputConfig.wait_next_epoch		* 1000));
 
 					if (alternateBreakTime < breakTime)						{	breakTime					= alternateBreakTime;	}
 					if (alternateStartTime < nextNominalLoopStartTime)		{	nextNominalLoopStartTime	= alternateStartTime;	}
 				}
-				
-				rec.ready = true;
+
+				stationInput.ready = true;
 			}
-			
-			for (auto& [id, s] : pseudoObsStreamMultimap)
+
+			for (auto& [id, s] : pseudoObsStreams)
 			{
 				PseudoObsStream&	pseudoObsStream	= *s;
-	
-				auto& pseudoRec = stationMap[id];
-				
-				if	( (pseudoRec.pseudoObsList.empty()		== false)
-					&&(pseudoRec.pseudoObsList.front().time	== tsync))
+
+				auto& pseudoObsList = pseudoObsListMap[id];
+
+				if	( (pseudoObsList.empty()		== false)
+					&&(pseudoObsList.front().time	== syncTime))
 				{
 					//already have observations for this epoch.
 					continue;
 				}
-				
+
 				//try to get some data
-				pseudoRec.pseudoObsList = pseudoObsStream.getObs(tsync);
+				pseudoObsList = pseudoObsStream.getObs(syncTime);
 
-				if (pseudoRec.pseudoObsList.empty())
+				if (pseudoObsList.empty())
 				{
 					continue;
 				}
-				
-				if (tsync == GTime::noTime())
+
+				if (syncTime == GTime::noTime())
 				{
-					tsync.time				= ((int)(pseudoRec.pseudoObsList.front().time / acsConfig.epoch_interval)) * acsConfig.epoch_interval;
-					acsConfig.start_epoch	= boost::posix_time::from_time_t(tsync);
-					
-					if (tsync + 0.5 < pseudoRec.pseudoObsList.front().time)
+					syncTime.time			= ((int)(pseudoObsList.front().time / inputConfig.epoch_interval)) * inputConfig.epoch_interval;
+					epochInput.newStart		= true;
+
+					if (syncTime + 0.5 < pseudoObsList.front().time)
 					{
 						repeat = true;
-						continue;	
+						continue;
 					}
 				}
 			}
+			
+			configLock.unlock();
+			
+			//give streams without data some time before trying again
+			sleep_for(waitingStreams * 2ms);
 		}
 
-		if (complete)
+		return false;
+	}
+
+	/** Returns true if the last synced epoch is the final epoch to be processed
+	*/
+	bool reachedEnd()
+	{
+		auto boostTime = boost::posix_time::from_time_t(syncTime.time);
+
+		if	(  inputConfig.end_epoch.is_not_a_date_time() == false
+			&& boostTime >= inputConfig.end_epoch)
 		{
-			break;
+			return true;
 		}
 
-		if (tsync == GTime::noTime())
+		if	(  inputConfig.max_epochs	> 0
+			&& syncEpoch				>= inputConfig.max_epochs)
 		{
-			if (acsConfig.require_obs)
-				continue;
-			
-			tsync = utc2gpst(timeget());
+			return true;
 		}
-		
-		BOOST_LOG_TRIVIAL(info)
-		<< "Synced " << dataAvailableMap.size() << " stations...";
-		
-		auto epochStartTime	= boost::posix_time::from_time_t(system_clock::to_time_t(system_clock::now()));
+
+		return false;
+	}
+
+	/** Calculate how many loops need to be skipped based on when the next loop was supposed to begin
+	*/
+	void skipExcessEpochs()
+	{
+		auto loopStopTime		= system_clock::now();
+		auto loopExcessDuration = loopStopTime - (nextNominalLoopStartTime + std::chrono::milliseconds((int)(inputConfig.wait_all_stations * 1000)));
+		int excessLoops			= loopExcessDuration / std::chrono::milliseconds((int)(inputConfig.wait_next_epoch * 1000));
+
+		if (excessLoops < 0)		{	excessLoops = 0;	}
+		if (excessLoops > 0)
 		{
-			mainOncePerEpoch(net, stationMap, tsync);
+			BOOST_LOG_TRIVIAL(warning) << std::endl
+			<< "Warning: Excessive time elapsed, skipping " << excessLoops
+			<< " epochs. Configuration 'wait_next_epoch' is " << inputConfig.wait_next_epoch;
 		}
-		auto epochStopTime	= boost::posix_time::from_time_t(system_clock::to_time_t(system_clock::now()));
 
-		
-		
-		int week;
-		double sec = time2gpst(tsync, &week);
-		auto boostTime = boost::posix_time::from_time_t(tsync.time);
+		loopEpochs = 1 + excessLoops;
+	}
+};
+
+/** Apply the inputs synced for an epoch to the stations.
+* Navigation data decoded while syncing is recorded first, then observations are preprocessed in the order they were received
+*/
+void applyEpochInputs(
+	EpochInput&		epochInput,		///< Inputs synced for the epoch
+	StationMap&		stationMap)		///< Map of stations to apply inputs to
+{
+	epochInput.navRequests.apply();
 
+	for (auto& [id, rec] : stationMap)
+	{
+		rec.ready = false;
+		clearSlips(rec.obsList);
+	}
+
+	int numSynced = 0;
+	for (auto& [id, stationInput] : epochInput.stationInputMap)
+	{
+		auto& recOpts = acsConfig.getRecOpts(id);
+
+		if (recOpts.exclude)
+		{
+			continue;
+		}
+
+		auto& rec = stationMap[id];
+
+		for (auto& obsList : stationInput.obsLists)
+		{
+			rec.obsList = std::move(obsList);
+
+			preprocessor(rec);
+		}
+
+		if (stationInput.ready == false)
+		{
+			rec.obsList.clear();
+
+			continue;
+		}
+
+		rec.ready = true;
+		numSynced++;
+	}
+
+	for (auto& [id, pseudoObsList] : epochInput.pseudoObsListMap)
+	{
+		auto& pseudoRec = stationMap[id];
+
+		pseudoRec.pseudoObsList = std::move(pseudoObsList);
+	}
+
+	BOOST_LOG_TRIVIAL(info)
+	<< "Synced " << numSynced << " stations...";
+}
+
+/** Process the inputs synced for an epoch.
+* Returns false once processing should stop
+*/
+bool processEpoch(
+	Network&		net,			///< Network to process
+	StationMap&		stationMap,		///< Map of stations to process
+	EpochInput&		epochInput)		///< Inputs synced for the epoch
+{
+	epoch = epochInput.epoch;
+
+	if (epochInput.complete)
+	{
 		BOOST_LOG_TRIVIAL(info)
-		<< "Processed epoch #" << epoch
-		<< " - " << "GPS time: " << week << " " << std::setw(6) << sec << " - " << boostTime 
-		<< " (took " << (epochStopTime-epochStartTime) << ")";
+		<< std::endl;
+		BOOST_LOG_TRIVIAL(info)
+		<< "Inputs finished at epoch #" << epoch;
+
+		return false;
+	}
+
+	tsync = epochInput.time;
 
-		// Check end epoch
-		if	(  acsConfig.end_epoch.is_not_a_date_time() == false
-			&& boostTime >= acsConfig.end_epoch)
+	if (epochInput.newStart)
+	{
+		acsConfig.start_epoch = boost::posix_time::from_time_t(tsync);
+	}
+
+	BOOST_LOG_TRIVIAL(info) << std::endl
+	<< "Starting epoch #" << epoch;
+
+	TestStack ts("Epoch " + std::to_string(epoch));
+
+	auto epochStartTime	= boost::posix_time::from_time_t(system_clock::to_time_t(system_clock::now()));
+	{
+		applyEpochInputs(epochInput, stationMap);
+
+		mainOncePerEpoch(net, stationMap, tsync);
+
+		outputProfiling(net);
+	}
+	auto epochStopTime	= boost::posix_time::from_time_t(system_clock::to_time_t(system_clock::now()));
+
+	int week;
+	double sec = time2gpst(tsync, &week);
+	auto boostTime = boost::posix_time::from_time_t(tsync.time);
+
+	BOOST_LOG_TRIVIAL(info)
+	<< "Processed epoch #" << epoch
+	<< " - " << "GPS time: " << week << " " << std::setw(6) << sec << " - " << boostTime
+	<< " (took " << (epochStopTime-epochStartTime) << ")";
+
+	// Check end epoch
+	if	(  acsConfig.end_epoch.is_not_a_date_time() == false
+		&& boostTime >= acsConfig.end_epoch)
+	{
+		BOOST_LOG_TRIVIAL(info)
+		<< "Exiting at epoch " << epoch << " (" << boostTime
+		<< ") as end epoch " << acsConfig.end_epoch
+		<< " has been reached";
+
+		return false;
+	}
+
+	// Check number of epochs
+	if	(  acsConfig.max_epochs	> 0
+		&& epoch					>= acsConfig.max_epochs)
+	{
+		BOOST_LOG_TRIVIAL(info)
+		<< std::endl
+		<< "Exiting at epoch " << epoch << " (" << boostTime
+		<< ") as epoch count " << acsConfig.max_epochs
+		<< " has been reached";
+
+		return false;
+	}
+
+	return true;
+}
+
+/** Sync inputs for successive epochs on a separate thread, passing them to the estimator through a queue
+*/
+void syncEpochInputs(
+	BoundedQueue<EpochInput>&	epochQueue,		///< Queue to pass synced epochs to the estimator
+	EpochSyncer&				epochSyncer)	///< Syncer to read inputs with, used only by this thread until it returns
+{
+	while (true)
+	{
+		EpochInput epochInput = epochSyncer.syncNext();
+
+		bool complete = epochInput.complete;
+
+		//wait here while the estimator catches up
+		bool pass = epochQueue.push(std::move(epochInput));
+
+		if	( pass == false
+			||complete
+			||epochSyncer.reachedEnd())
 		{
-			BOOST_LOG_TRIVIAL(info)
-			<< "Exiting at epoch " << epoch << " (" << boostTime
-			<< ") as end epoch " << acsConfig.end_epoch
-			<< " has been reached";
+			return;
+		}
+
+		epochSyncer.skipExcessEpochs();
+	}
+}
+
+/** Main processing loop for when inputs are read on a separate thread.
+* Epochs are synced by the input thread while the previous epoch is being processed here.
+*/
+void pipelinedProcessingLoop(
+	Network&		net,			///< Network to process
+	StationMap&		stationMap,		///< Map of stations to process
+	EpochSyncer&	epochSyncer)	///< Syncer to read inputs with
+{
+	BoundedQueue<EpochInput> epochQueue;
+	epochQueue.capacity = std::max(1, acsConfig.pipeline_depth);
 
+	std::thread syncThread(syncEpochInputs, std::ref(epochQueue), std::ref(epochSyncer));
+
+	EpochInput epochInput;
+	while (epochQueue.pop(epochInput))
+	{
+		bool pass = processEpoch(net, stationMap, epochInput);
+		if (pass == false)
+		{
 			break;
 		}
+	}
+
+	epochQueue.close();
+	syncThread.join();
+}
+
+int main(
+	int		argc, 
+	char**	argv)
+{
+	tracelevel(5);
+
+	boost::log::core::get()->set_filter (boost::log::trivial::severity >= boost::log::trivial::info);
+	boost::log::add_console_log(std::cout, boost::log::keywords::format = "%Message%");
+
+	BOOST_LOG_TRIVIAL(info)
+	<< "PEA starting... (" << GINAN_BRANCH_NAME << " " GINAN_COMMIT_VERSION " from " << GINAN_COMMIT_DATE << ")" << std::endl;
+
+	auto peaStartTime = boost::posix_time::from_time_t(system_clock::to_time_t(system_clock::now()));
 
-		// Check number of epochs
-		if	(  acsConfig.max_epochs	> 0
-			&& epoch					>= acsConfig.max_epochs)
+	exitOnErrors();
+	
+	bool pass = configure(argc, argv);
+	if (pass == false)
+	{
+		BOOST_LOG_TRIVIAL(error) 	<< "Error: Incorrect configuration";
+		BOOST_LOG_TRIVIAL(info) 	<< "PEA finished";
+		NtripSocket::io_service.stop();
+		return EXIT_FAILURE;
+	}
+	
+	if (acsConfig.output_log)
+	{
+		addFileLog();
+	}
+	
+
+	TestStack::openData();
+
+	//eigen does not start its own threads from within openmp parallel regions, so its thread count is set once for the whole process
+	Eigen::setNbThreads(0);
+
+	BOOST_LOG_TRIVIAL(info)
+	<< "Threading with " << Eigen::nbThreads()
+	<< " threads" << std::endl;
+
+	
+
+	BOOST_LOG_TRIVIAL(info)
+	<< "Logging with trace level:" << acsConfig.trace_level << std::endl << std::endl;
+
+	tracelevel(acsConfig.trace_level);
+
+	//read orography file for VMF3
+	{
+		int orog_sucess = false;
+		if 	( acsConfig.model.trop.orography.empty() == false		//todo aaron, check the option, not the filename, or just read anyway
+			&&acsConfig.model.trop.vmf3dir	.empty() == false)
 		{
-			BOOST_LOG_TRIVIAL(info)
-			<< std::endl
-			<< "Exiting at epoch " << epoch << " (" << boostTime
-			<< ") as epoch count " << acsConfig.max_epochs
-			<< " has been reached";
+			orog_sucess = readorog(acsConfig.model.trop.orography, nav.orography);
+		}
 
-			break;
+		if (orog_sucess == false)
+		{
+			// read gpt2 grid file
+			readgrid(acsConfig.model.trop.gpt2grid, &nav.gptg);
 		}
+	}
 
-		// Calculate how many loops need to be skipped based on when the next loop was supposed to begin
-		auto loopStopTime		= system_clock::now();
-		auto loopExcessDuration = loopStopTime - (nextNominalLoopStartTime + std::chrono::milliseconds((int)(acsConfig.wait_all_stations * 1000)));
-		int excessLoops			= loopExcessDuration / std::chrono::milliseconds((int)(acsConfig.wait_next_epoch * 1000));
+	if (acsConfig.input_persistance)
+	{
+		BOOST_LOG_TRIVIAL(info)
+		<< "Loading persistant navigation object to continue processing...";
 
-		if (excessLoops < 0)		{	excessLoops = 0;	}
-		if (excessLoops > 0)	
+		inputPersistanceNav();
+	}
+
+	if (acsConfig.process_ionosphere)
+	{
+		bool pass = config_ionosph_model();
+		if	(pass == false)
 		{
-			BOOST_LOG_TRIVIAL(warning) << std::endl 
-			<< "Warning: Excessive time elapsed, skipping " << excessLoops 
-			<< " epochs. Configuration 'wait_next_epoch' is " << acsConfig.wait_next_epoch;	
+			BOOST_LOG_TRIVIAL(error)
+			<< "Error in Ionosphere Model configuration";
+
+			return EXIT_FAILURE;
 		}
+	}
+	
+	if	( acsConfig.ambrOpts.NLmode != +E_ARmode::OFF )
+		config_AmbigResl();
 
-		loopEpochs = 1 + excessLoops;
+	map<string, Station> stationMap;
+	
+	//prepare the satNavMap so that it at least has entries for everything
+	{
+		for (int prn = MINPRNGPS; prn <= MAXPRNGPS; prn++)	{	SatSys s(E_Sys::GPS, prn);	nav.satNavMap[s];	}
+		for (int prn = MINPRNGLO; prn <= MAXPRNGLO; prn++)	{	SatSys s(E_Sys::GLO, prn);	nav.satNavMap[s];	}
+		for (int prn = MINPRNGAL; prn <= MAXPRNGAL; prn++)	{	SatSys s(E_Sys::GAL, prn);	nav.satNavMap[s];	}
+		for (int prn = MINPRNBDS; prn <= MAXPRNBDS; prn++)	{	SatSys s(E_Sys::BDS, prn);	nav.satNavMap[s];	}	
+	}
+
+	Network net;
+	{
+		net.kfState.id					= "Net";
+		net.kfState.max_filter_iter		= acsConfig.pppOpts.max_filter_iter;
+		net.kfState.max_prefit_remv		= acsConfig.pppOpts.max_prefit_remv;
+		net.kfState.inverter			= acsConfig.pppOpts.inverter;
+		net.kfState.block_covariance	= acsConfig.pppOpts.block_covariance;
+		net.kfState.sparse_measurements	= acsConfig.pppOpts.sparse_measurements;
+		net.kfState.sigma_check			= acsConfig.pppOpts.sigma_check;
+		net.kfState.sigma_threshold		= acsConfig.pppOpts.sigma_threshold;
+		net.kfState.w_test				= acsConfig.pppOpts.w_test;
+		net.kfState.chi_square_test		= acsConfig.pppOpts.chi_square_test;
+		net.kfState.chi_square_mode		= acsConfig.pppOpts.chi_square_mode;
+		net.kfState.output_residuals	= acsConfig.output_residuals;
+		net.kfState.measRejectCallbacks	.push_back(deweightMeas);
+		net.kfState.measRejectCallbacks	.push_back(incrementPhaseSignalError);
+		net.kfState.stateRejectCallbacks.push_back(deweightByState);
+	}
+
+	if	(  acsConfig.process_rts
+		&& acsConfig.pppOpts.rts_lag)
+	{
+		net.kfState.rts_lag		= acsConfig.pppOpts.rts_lag;
+		iono_KFState.rts_lag	= acsConfig.pppOpts.rts_lag;
+	}
+
+	//initialise mongo
+	mongoooo();
+	
+	if (acsConfig.rts_only)
+	{
+		net.kfState.rts_lag = 4000;
+		net.kfState.rts_basename = acsConfig.pppOpts.rts_filename;
+		
+		RTS_Process(net.kfState);
+		
+		mongoWriter.stop();
+		
+		exit(0);
+	}
+	
+	if (acsConfig.input_persistance)
+	{
+		BOOST_LOG_TRIVIAL(info)
+		<< "Loading persistant states to continue processing...";
+
+		inputPersistanceStates(stationMap, net.kfState);
+	}
+	
+	initialiseBiasSinex();
+
+	reloadInputFiles();
+
+	addDefaultBiasSinex();
+
+	NtripSocket::startClients(acsConfig.ntrip_io_threads);
+
+	configureDownloadingStreams();
+	configureUploadingStreams();
+	
+	ntripBroadcaster.startBroadcast();
+	
+	for (auto& [id, s] : obsStreamMultimap)
+	{
+		auto& rec = stationMap[id];
+		
+		initialiseStation(id, rec);
+	}
+	
+	createTracefiles(stationMap, net);
+	
+	//initialise mongo
+	mongoooo();
+	
+	if (acsConfig.mincon_only)
+	{
+		minconOnly(std::cout, stationMap);
+	}
+	
+	doDebugs();
+
+	if (acsConfig.start_epoch.is_not_a_date_time() == false)
+	{
+		tsync.time = boost::posix_time::to_time_t(acsConfig.start_epoch);
+	}
+
+	BOOST_LOG_TRIVIAL(info)
+	<< std::endl;
+	BOOST_LOG_TRIVIAL(info)
+	<< "Starting to process epochs...";
+
+	TestStack ts(acsConfig.config_description);
+	
+	//============================================================================
+	// MAIN PROCESSING LOOP														//
+	//============================================================================
+
+	EpochSyncer epochSyncer(tsync, epoch);
+
+	if (acsConfig.pipeline_epochs)
+	{
+		pipelinedProcessingLoop(net, stationMap, epochSyncer);
+	}
+	else
+	{
+		// Read the observations for each station and do stuff, until the inputs finish or something else breaks the loop
+		while (true)
+		{
+			EpochInput epochInput = epochSyncer.syncNext();
+
+			bool pass = processEpoch(net, stationMap, epochInput);
+			if (pass == false)
+			{
+				break;
+			}
+
+			epochSyncer.skipExcessEpochs();
+		}
 	}
 
 	// Disconnect the downloading clients and stop the io_service for clean shutdown.
@@ -1890,6 +2349,7 @@ int main(
 	{
 		auto& downStream = *s;
 		downStream.disconnect();
+		downStream.stopDecoding();
 	}
 	ntripBroadcaster.stopBroadcast();
 	NtripSocket::io_service.stop();
@@ -1907,6 +2367,8 @@ int main(
 
 	mainPostProcessing(net, stationMap);
 
+	mongoWriter.stop();
+
 	auto peaStopTime = boost::posix_time::from_time_t(system_clock::to_time_t(system_clock::now()));
 
 	BOOST_LOG_TRIVIAL(info)
@@ -11,6 +11,7 @@ using std::list;
 #include "eigenIncluder.hpp"
 #include "algebraTrace.hpp"
 #include "streamTrace.hpp"
+#include "mongoWrite.hpp"
 #include "acsConfig.hpp"
 #include "station.hpp"
 #include "algebra.hpp"
@@ -118,12 +119,15 @@ void mincon(
 
 	if (acsConfig.mincon_only)
 	{
-		long int startPos = -1;
-		E_SerialObject type = getFilterTypeFromFile(startPos, MINCONONLY_FILENAME);
+		closeArchiveStream(MINCONONLY_FILENAME);
+		
+		ArchiveReverseReader reader(MINCONONLY_FILENAME);
+		E_SerialObject type = reader.nextType();
 		if (type == +E_SerialObject::NONE)
 		{
 			std::cout << std::endl << "Writing backup point for minimum constraints to " << MINCONONLY_FILENAME; 
 			spitFilterToFile(kfStateStations, E_SerialObject::FILTER_PLUS, MINCONONLY_FILENAME);
+			closeArchiveStream(MINCONONLY_FILENAME);
 		}
 	}
 	
@@ -410,6 +414,8 @@ void mincon(
 		kfState.x	= xp;
 		kfState.P	= Pp;
 		kfState.dx	= dx;
+		
+		kfState.covarianceBlocks.correlate(pseudoMeas);
 
 		if (kfState.rts_basename.empty() == false)
 		{
@@ -526,8 +532,10 @@ KFState minconOnly(
 	Trace&		trace,
 	StationMap&	stationMap)
 {
-	long int startPos = -1;
-	E_SerialObject type = getFilterTypeFromFile(startPos, MINCONONLY_FILENAME);
+	closeArchiveStream(MINCONONLY_FILENAME);
+	
+	ArchiveReverseReader reader(MINCONONLY_FILENAME);
+	E_SerialObject type = reader.nextType();
 	if (type != +E_SerialObject::FILTER_PLUS)
 	{
 		return KFState();
@@ -536,7 +544,7 @@ KFState minconOnly(
 	trace << std::endl << "Performing minimum constraints using dataset saved to " << MINCONONLY_FILENAME << std::endl;
 	
 	KFState kalmanPlus;
-	bool pass = getFilterObjectFromFile(type, kalmanPlus, startPos, MINCONONLY_FILENAME);
+	bool pass = reader.getObject(type, kalmanPlus);
 	if (pass == false)
 	{
 		return KFState();
@@ -563,6 +571,8 @@ KFState minconOnly(
 		mincon(trace, kalmanPlus);
 	}
 	
+	mongoWriter.stop();
+	
 	exit(0);
 	return kalmanPlus;
 }
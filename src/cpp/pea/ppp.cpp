@@ -947,8 +947,7 @@ bool deweightMeas(
 {
 	trace << std::endl << "Deweighting " << kfMeas.obsKeys[index] << std::endl;
 
-	kfMeas.R.row(index) *= acsConfig.deweight_factor;
-	kfMeas.R.col(index) *= acsConfig.deweight_factor;
+	kfMeas.scaleNoise(index, acsConfig.deweight_factor);
 	
 	return true;
 }
@@ -974,8 +973,7 @@ bool deweightStationMeas(
 		
 		trace << std::endl << "Deweighting " << kfMeas.obsKeys[i] << std::endl;
 
-		kfMeas.R.row(i) *= acsConfig.deweight_factor;
-		kfMeas.R.col(i) *= acsConfig.deweight_factor;
+		kfMeas.scaleNoise(i, acsConfig.deweight_factor);
 		
 		map<string, void*>& metaDataMap = kfMeas.metaDataMaps[i];
 
@@ -1110,14 +1108,13 @@ bool deweightByState(
 
 	int stateIndex = kfState.getKFIndex(kfKey);
 	
-	for (int meas = 0; meas < kfMeas.H.rows(); meas++)
+	for (int meas = 0; meas < kfMeas.numMeas(); meas++)
 	{
-		if (kfMeas.H(meas, stateIndex))
+		if (kfMeas.designEntry(meas, stateIndex))
 		{
 			trace << "- Deweighting " << kfMeas.obsKeys[meas] << std::endl;
 			
-			kfMeas.R.row(meas) *= acsConfig.deweight_factor;
-			kfMeas.R.col(meas) *= acsConfig.deweight_factor;
+			kfMeas.scaleNoise(meas, acsConfig.deweight_factor);
 		}
 	}
 	
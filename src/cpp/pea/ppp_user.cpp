@@ -328,6 +328,10 @@ int ppp_filter(
 {
 	TestStack ts(__FUNCTION__);
 
+	//intern the strings used in keys once, rather than for every key
+	static const InternedString	codeType = "P";
+	static const InternedString	phasType = "L";
+
 	KFState&	kfState = rec.pppState;
 
 	kfState.initFilterEpoch();
@@ -452,6 +456,7 @@ int ppp_filter(
 		auto&		lam			= obs.satNav_ptr->lamMap;
 		SatStat&	satStat		= *(obs.satStat_ptr);
 		int			biasGroup	= obs.Sat.biasGroup();
+		InternedString	mount		= obs.mount;
 
 		E_FType ft2 = F2;
 		if ( obs.Sat.sys == +E_Sys::GAL ||
@@ -481,7 +486,7 @@ int ppp_filter(
 		//get the previous filter states for linearisation around this operating point
 		for (short i = 0; i < 3; i++)
 		{
-			bool pass = kfState.getKFValue({KF::TROP, {}, obs.mount, i}, tropStates[i]);
+			bool pass = kfState.getKFValue({KF::TROP, {}, mount, i}, tropStates[i]);
 			if	( (i	== 0)
 				&&(pass == false))
 			{
@@ -523,7 +528,7 @@ int ppp_filter(
 					ionInitVari *= ionfact*ionfact;
 
 				}
-				if(kfState.getKFValue({KF::IONOSPHERIC, obs.Sat, obs.mount}, ionoState)) dIono = ionoState;
+				if(kfState.getKFValue({KF::IONOSPHERIC, obs.Sat, mount}, ionoState)) dIono = ionoState;
 				else dIono = ionInitValue;
 				varIono = 0;
 				break;
@@ -633,7 +638,7 @@ int ppp_filter(
 			{
 				posKeys[i].type		= KF::REC_POS;
 				posKeys[i].num		= i;
-				posKeys[i].str		= obs.mount;
+				posKeys[i].str		= mount;
 			}
 
 			KFKey posRateKeys[3];
@@ -641,7 +646,7 @@ int ppp_filter(
 			{
 				posRateKeys[i].type	= KF::REC_POS_RATE;
 				posRateKeys[i].num	= i;
-				posRateKeys[i].str	= obs.mount;
+				posRateKeys[i].str	= mount;
 			}
 
 			KFKey tropKeys[3];
@@ -649,7 +654,7 @@ int ppp_filter(
 			{
 				tropKeys[i].type	= KF::TROP;
 				tropKeys[i].num		= i;
-				tropKeys[i].str		= obs.mount;
+				tropKeys[i].str		= mount;
 				tropKeys[i].rec_ptr	= &rec;
 			}
 
@@ -658,14 +663,14 @@ int ppp_filter(
 				phaseBiasKey.type	= KF::PHASE_BIAS;
 				phaseBiasKey.Sat	= obs.Sat;
 				phaseBiasKey.num	= ft;
-				phaseBiasKey.str	= obs.mount;
+				phaseBiasKey.str	= mount;
 			}
 
 			KFKey systemBiasKey;
 			{
 				systemBiasKey.type		= KF::REC_SYS_BIAS;
 				systemBiasKey.num		= biasGroup;
-				systemBiasKey.str		= obs.mount;
+				systemBiasKey.str		= mount;
 				systemBiasKey.rec_ptr	= &rec;
 			}
 
@@ -673,21 +678,21 @@ int ppp_filter(
 			{
 				systemBiasRateKey.type	= KF::REC_SYS_BIAS_RATE;
 				systemBiasRateKey.num	= biasGroup;
-				systemBiasRateKey.str	= obs.mount;
+				systemBiasRateKey.str	= mount;
 			}
 
 			KFKey dcbKey;
 			{
 				dcbKey.type			= KF::DCB;
 				dcbKey.num			= ft;
-				dcbKey.str			= obs.mount;
+				dcbKey.str			= mount;
 			}
 
 			KFKey ionoKey;
 			{
 				ionoKey.type 		= KF::IONOSPHERIC;
 				ionoKey.Sat			= obs.Sat;
-				ionoKey.str			= obs.mount;
+				ionoKey.str			= mount;
 			}
 			
 			double antDeltaDot = antDelta.dot(satStat.e);
@@ -766,8 +771,8 @@ int ppp_filter(
 								
 // 			tracepdeex(0, std::cout, "%14.6f %14.6f %14.6f %14.6f %14.6f %14.6f\n", sig.codeVar, sig.phasVar, obs.ephVar, varTrop, varIono, varSysIFB);
 
-			ObsKey obsKeyCode = {obs.Sat, obs.mount, "P", ft};
-			ObsKey obsKeyPhas = {obs.Sat, obs.mount, "L", ft};
+			ObsKey obsKeyCode = {obs.Sat, mount, codeType, ft};
+			ObsKey obsKeyPhas = {obs.Sat, mount, phasType, ft};
 
 			KFMeasEntry	codeMeas(&kfState, obsKeyCode);
 			KFMeasEntry	phasMeas(&kfState, obsKeyPhas);
@@ -978,6 +983,8 @@ int ppp_filter(
 	trace << std::endl << "-------DOING KALMAN FILTER --------" << std::endl;
 	kfState.filterKalman(trace, combinedMeas, true);
 
+	combinedMeas.makeDense();
+
 	TestStack::testMat("combinedMeas.V", combinedMeas.V);
 	TestStack::testMat("combinedMeas.H", combinedMeas.H);
 	TestStack::testMat("kfState.x", kfState.x, 0, &kfState.P);
@@ -1,6 +1,7 @@
 
 // #pragma GCC optimize ("O0")
 
+#include <sstream>
 #include <string>
 #include <tuple>
 #include <list>
@@ -89,8 +90,17 @@ KFMeas makeLCs(
 	
 	newMeas.V	= F * combinedMeas.V;
 	newMeas.VV	= newMeas.V;
-	newMeas.H	= F * combinedMeas.H;
-	newMeas.R	= F * combinedMeas.R * F.transpose();
+	if (combinedMeas.sparse)
+	{
+		newMeas.sparse		= true;
+		newMeas.H_sparse	= F * combinedMeas.H_sparse;
+		newMeas.R_sparse	= F * combinedMeas.R_sparse * F.transpose();
+	}
+	else
+	{
+		newMeas.H	= F * combinedMeas.H;
+		newMeas.R	= F * combinedMeas.R * F.transpose();
+	}
 	
 	newMeas.metaDataMaps	= std::move(combinedMeas.metaDataMaps);
 	newMeas.time			= std::move(combinedMeas.time);
@@ -338,27 +348,21 @@ void propagateUncertainty(
 		kfMeasEntryList.push_back(kfMeasEntry);
 	}
 	
-	for (int i = 1; i < kfState.kfIndexMap.size();	i++)
-	for (int j = 0; j < i;							j++)
+	//collect the ambiguity keys once rather than walking the index map for every pair
+	vector<KFKey> ambiguityKeys;
+	for (auto& [key, index] : kfState.kfIndexMap)
 	{
-		auto iti = kfState.kfIndexMap.begin();
-		auto itj = kfState.kfIndexMap.begin();
-		
-		std::advance(iti, i);
-		std::advance(itj, j);
-		
-		auto& [keyi, indexi] = *iti;
-		auto& [keyj, indexj] = *itj;
-		
-		if (keyi.type != KF::AMBIGUITY)
+		if (key.type == KF::AMBIGUITY)
 		{
-			continue;
-		}
-		
-		if (keyj.type != KF::AMBIGUITY)
-		{
-			continue;
+			ambiguityKeys.push_back(key);
 		}
+	}
+	
+	for (int i = 1; i < ambiguityKeys.size();	i++)
+	for (int j = 0; j < i;						j++)
+	{
+		auto& keyi = ambiguityKeys[i];
+		auto& keyj = ambiguityKeys[j];
 		
 		if (keyi.Sat != keyj.Sat)
 		{
@@ -391,6 +395,7 @@ void propagateUncertainty(
 	}
 	
 	KFMeas combinedMeas = kfState.combineKFMeasList(kfMeasEntryList);
+	combinedMeas.makeDense();
 
 	KFState propagatedState;
 	
@@ -425,6 +430,24 @@ void removeBadIonospheres(
 void incrementOutageCount(
 	StationMap&		stations);
 
+#ifdef ENABLE_UNIT_TESTS
+/** Check that the states, transitions, and noise requested of two filters are identical
+*/
+bool sameFilterStructure(
+	KFState&	a,		///< First filter to compare
+	KFState&	b)		///< Second filter to compare
+{
+	return	a.stateTransitionMap	== b.stateTransitionMap
+		&&	a.ZTransitionMap		== b.ZTransitionMap
+		&&	a.ZAdditionMap			== b.ZAdditionMap
+		&&	a.procNoiseMap			== b.procNoiseMap
+		&&	a.initNoiseMap			== b.initNoiseMap
+		&&	a.gaussMarkovTauMap		== b.gaussMarkovTauMap
+		&&	a.gaussMarkovMuMap		== b.gaussMarkovMuMap
+		&&	a.noiseElementMap		== b.noiseElementMap;
+}
+#endif
+
 void PPP(
 	Trace&			trace,			///< Trace to output to
 	StationMap&		stations,		///< List of stations containing observations for this epoch
@@ -467,27 +490,84 @@ void PPP(
 		stationKFEntryListMap[rec.id] = KFMeasEntryList();
 	}
 	
+	//orbit partials are shared by all stations, calculate them once before the stations are processed in parallel
+	for (auto& [satId, satNav] : nav.satNavMap)
+	{
+		SatSys Sat;
+		Sat.fromHash(satId);
+		
+		if (acsConfig.process_sys[Sat.sys] == false)
+		{
+			continue;
+		}
+		
+		auto& satOpts = acsConfig.getSatOpts(Sat);
+		
+		InitialState init	= initialStateFromConfig(satOpts.orb);
+		if (init.estimate)
+			orbPartials(trace, tsync, Sat, satNav.satPartialMat);	
+	}
+	
+	//changes to the filter structure, and trace outputs, from each station, applied after all stations have been processed
+	vector<Station*>			stationList;
+	vector<KFMeasEntryList*>	stationEntryLists;
+	for (auto& [id, rec] : stations)
+	{
+		stationList			.push_back(&rec);
+		stationEntryLists	.push_back(&stationKFEntryListMap[rec.id]);
+	}
+	
+	vector<KFStateRequests>		stationRequests	(stationList.size());
+	vector<std::ostringstream>	stationTraces	(stationList.size());
+	
+#	ifdef ENABLE_UNIT_TESTS
+	//process the stations serially into a copy of the filter, applying their changes immediately, for comparison with the deferred requests below
+	KFState serialState = kfState;
+	for (auto& rec_ptr : stationList)
+	{
+		std::ostringstream	serialTrace;
+		KFMeasEntryList		serialEntryList;
+		
+		stationPPP		(serialTrace, *rec_ptr, serialState, serialEntryList, nav.gptg, nav.orography);
+		stationPseudo	(serialTrace, *rec_ptr, serialState, serialEntryList);
+	}
+#	endif
+	
 	{		
 // 		Instrument instrument("PPP obsOMC");
 	
 		//calculate the measurements for each station
-	// #	ifdef ENABLE_PARALLELISATION
-	// #	ifndef ENABLE_UNIT_TESTS
-	// 			Eigen::setNbThreads(1);
-	// #		pragma omp parallel for
-	// #	endif
-	// #	endif
-		for (int i = 0; i < stations.size(); i++)
+#	ifdef ENABLE_PARALLELISATION
+#	ifndef ENABLE_UNIT_TESTS
+#		pragma omp parallel for
+#	endif
+#	endif
+		for (int i = 0; i < stationList.size(); i++)
 		{
-			auto rec_iterator = stations.begin();
-			std::advance(rec_iterator, i);
+			auto& rec = *stationList[i];
 			
-			auto& [id, rec] = *rec_iterator;
+			DeferStateRequests deferRequests(stationRequests[i]);
 			
-			stationPPP		(std::cout, rec, kfState, stationKFEntryListMap[rec.id], nav.gptg, nav.orography);
-			stationPseudo	(std::cout, rec, kfState, stationKFEntryListMap[rec.id]);
+			stationPPP		(stationTraces[i], rec, kfState, *stationEntryLists[i], nav.gptg, nav.orography);
+			stationPseudo	(stationTraces[i], rec, kfState, *stationEntryLists[i]);
 		}
 	}
+	
+	for (auto& stationTrace : stationTraces)
+	{
+		std::cout << stationTrace.str();
+	}
+	
+	//apply the requests in station order, as if the stations had been processed serially
+	KFStateRequests::applyInOrder(stationRequests);
+	
+#	ifdef ENABLE_UNIT_TESTS
+	if (sameFilterStructure(kfState, serialState) == false)
+	{
+		BOOST_LOG_TRIVIAL(error)
+		<< "Error: Deferred station requests produced a different filter than processing stations serially";
+	}
+#	endif
 
 	//combine all lists of measurements into a single list
 	KFMeasEntryList kfMeasEntryList;
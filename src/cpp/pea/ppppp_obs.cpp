@@ -19,6 +19,23 @@
 
 #define DEFAULT_BIAS_VAR SQR(20)
 
+/** Intern the measurement type strings for every observation code.
+* Called once so that measurement keys need not build and intern new strings for every observation.
+*/
+map<E_ObsCode, InternedString> internMeasTypes(
+	const string&	prefix)		///< Prefix to prepend to the code name
+{
+	map<E_ObsCode, InternedString> measTypes;
+
+	for (int i = 0; i < E_ObsCode::_size(); i++)
+	{
+		E_ObsCode code	= E_ObsCode::_values()[i];
+
+		measTypes[code]	= prefix + code._to_string();
+	}
+
+	return measTypes;
+}
 
 void stationPPP(
 			Trace&				netTrace,			///< Trace to output to
@@ -33,6 +50,20 @@ void stationPPP(
 	
 // 	Instrument	instrument(__FUNCTION__ + rec.id);
 	
+	//intern the strings used in keys once, rather than for every key
+	static const map<E_ObsCode, InternedString>	codeMeasTypes	= internMeasTypes("P-");
+	static const map<E_ObsCode, InternedString>	phasMeasTypes	= internMeasTypes("L-");
+	static const InternedString	satEphType		= "satEph";
+	static const InternedString	recClkType		= "recClk";
+	static const InternedString	ionoType		= "iono";
+	static const InternedString	tropType		= "trop";
+	static const InternedString	recCodeBiasType	= "recCodeBias";
+	static const InternedString	satCodeBiasType	= "satCodeBias";
+	static const InternedString	recPhasBiasType	= "recPhasBias";
+	static const InternedString	satPhasBiasType	= "satPhasBias";
+	
+	InternedString recId = rec.id;
+	
 	if (rec.obsList.empty())
 	{
 		return;
@@ -48,23 +79,6 @@ void stationPPP(
 	Matrix3d i2tMatrix = Matrix3d::Identity();
 	eci2ecef(time, erpv, i2tMatrix);
 	
-	for (auto& [satId, satNav] : nav.satNavMap)
-	{
-		SatSys Sat;
-		Sat.fromHash(satId);
-		
-		if (acsConfig.process_sys[Sat.sys] == false)
-		{
-			continue;
-		}
-		
-		auto& satOpts = acsConfig.getSatOpts(Sat);
-		
-		InitialState init	= initialStateFromConfig(satOpts.orb);
-		if (init.estimate)
-			orbPartials(trace, time, Sat, satNav.satPartialMat);	
-	}
-	
 	for (auto& obs			: rec.obsList)
 	for (int measType		: {PHAS, CODE})
 	for (auto& [ft, sig]	: obs.Sigs)
@@ -162,17 +176,17 @@ void stationPPP(
 		}
 		
 		measEntry.obsKey.Sat	= obs.Sat;
-		measEntry.obsKey.str	= rec.id;
+		measEntry.obsKey.str	= recId;
 		measEntry.obsKey.num	= ft;
-		if		(measType == CODE)		measEntry.obsKey.type = string("P-") + code._to_string();
-		else if	(measType == PHAS)		measEntry.obsKey.type = string("L-") + code._to_string();
+		if		(measType == CODE)		measEntry.obsKey.type = codeMeasTypes.at(code);
+		else if	(measType == PHAS)		measEntry.obsKey.type = phasMeasTypes.at(code);
 		
 		//Start with the observed measurement and its noise
 		
 		measEntry.componentList.push_back({"Observed", -observed, "- Phi"});
 		{
 			ObsKey obsKey;
-			obsKey.str	= rec.id;
+			obsKey.str	= recId;
 			obsKey.Sat	= obs.Sat;
 			obsKey.type	= measEntry.obsKey.type;
 			obsKey.num	= ft;
@@ -208,7 +222,7 @@ void stationPPP(
 				
 				KFKey kfKey;
 				kfKey.type	= KF::REC_POS;
-				kfKey.str	= rec.id;
+				kfKey.str	= recId;
 				kfKey.num	= i;
 				
 				kfState.getKFValue(kfKey, rRec[i]);
@@ -222,7 +236,7 @@ void stationPPP(
 				{
 					KFKey rateKey;
 					rateKey.type	= KF::REC_POS_RATE;
-					rateKey.str	= rec.id;
+					rateKey.str	= recId;
 					rateKey.num	= i;
 					
 					kfState.getKFValue(kfKey, vRec[i]);
@@ -247,7 +261,7 @@ void stationPPP(
 			
 			ObsKey obsKey;
 			obsKey.Sat	= obs.Sat;
-			obsKey.type	= "satEph";
+			obsKey.type	= satEphType;
 			
 			measEntry.addNoiseEntry(obsKey, 1, obs.ephVar);
 		}
@@ -279,7 +293,7 @@ void stationPPP(
 			{
 				KFKey kfKey;
 				kfKey.type		= KF::REC_CLOCK;
-				kfKey.str		= rec.id;
+				kfKey.str		= recId;
 				kfKey.rec_ptr	= &rec;
 				// 			kfKey.num	= i;
 				
@@ -293,8 +307,8 @@ void stationPPP(
 			else
 			{
 				ObsKey obsKey;
-				obsKey.str	= rec.id;
-				obsKey.type	= "recClk";		
+				obsKey.str	= recId;
+				obsKey.type	= recClkType;		
 				measEntry.addNoiseEntry(obsKey, 1, precDtRecVar);
 			}
 				
@@ -474,9 +488,9 @@ void stationPPP(
 			{
 				KFKey kfKey;
 				kfKey.type	= KF::IONO_STEC;
-				kfKey.str	= rec.id;
+				kfKey.str	= recId;
 				kfKey.Sat	= obs.Sat;
-// 				if (acsConfig.common_atmosphere				== false)		{		kfKey.str	= rec.id;		}	//dont use common atmospheres for all receivers
+// 				if (acsConfig.common_atmosphere				== false)		{		kfKey.str	= recId;		}	//dont use common atmospheres for all receivers
 				if (acsConfig.ionoOpts.common_ionosphere	== false)		{		kfKey.num	= measType;		}	//dont use common ionospheres for code and phase
 				
 				double ionosphere_stec  = 0;
@@ -509,9 +523,9 @@ void stationPPP(
 					ionosphere_m = sign * ionC * diono;
 					
 					ObsKey obsKey;
-					obsKey.str	= rec.id;
+					obsKey.str	= recId;
 					obsKey.Sat	= Sat;
-					obsKey.type	= "iono";
+					obsKey.type	= ionoType;
 // 					obsKey.num	= ft + measType * 100;	//todo aaron remove meastype
 					
 					measEntry.addNoiseEntry(obsKey, sign * SQR(ionC), varIono);
@@ -539,7 +553,7 @@ void stationPPP(
 				kfKey.type	= KF::TROP;
 				if (acsConfig.common_atmosphere == false)
 				{
-					kfKey.str	= rec.id;
+					kfKey.str	= recId;
 				}
 				
 				//get the previous filter states for linearisation around this operating point
@@ -583,9 +597,9 @@ void stationPPP(
 			else
 			{
 				ObsKey obsKey;
-				obsKey.str	= rec.id;
+				obsKey.str	= recId;
 				obsKey.Sat	= obs.Sat;
-				obsKey.type	= "trop";
+				obsKey.type	= tropType;
 				measEntry.addNoiseEntry(obsKey, 1, varTrop);
 			}
 			
@@ -624,7 +638,7 @@ void stationPPP(
 			{
 				KFKey kfKey;
 				kfKey.type		= KF::AMBIGUITY;
-				kfKey.str		= rec.id;
+				kfKey.str		= recId;
 				kfKey.Sat		= obs.Sat;
 				kfKey.num		= ft;
 				kfKey.rec_ptr	= &rec;
@@ -660,7 +674,7 @@ void stationPPP(
 				
 				KFKey kfKey;
 				kfKey.type	= KF::CODE_BIAS;
-				kfKey.str	= rec.id;
+				kfKey.str	= recId;
 				kfKey.num	= ft;
 				
 				kfState.getKFValue(kfKey, recCodeBias);
@@ -670,8 +684,8 @@ void stationPPP(
 			else
 			{
 				ObsKey obsKey;
-				obsKey.str	= rec.id;
-				obsKey.type	= "recCodeBias";
+				obsKey.str	= recId;
+				obsKey.type	= recCodeBiasType;
 				obsKey.num	= ft;
 				measEntry.addNoiseEntry(obsKey, 1, recCodeBiasVar);
 			}
@@ -705,7 +719,7 @@ void stationPPP(
 			{
 				ObsKey obsKey;
 				obsKey.Sat	= obs.Sat;
-				obsKey.type	= "satCodeBias";	
+				obsKey.type	= satCodeBiasType;	
 				obsKey.num	= ft;
 				measEntry.addNoiseEntry(obsKey, 1, satCodeBiasVar);
 			}
@@ -727,7 +741,7 @@ void stationPPP(
 			{
 				KFKey kfKey;
 				kfKey.type	= KF::PHASE_BIAS;
-				kfKey.str	= rec.id;
+				kfKey.str	= recId;
 				kfKey.num	= ft;
 				
 				kfState.getKFValue(kfKey, recPhasBias);
@@ -737,8 +751,8 @@ void stationPPP(
 			else
 			{
 				ObsKey obsKey;
-				obsKey.str	= rec.id;
-				obsKey.type	= "recPhasBias";
+				obsKey.str	= recId;
+				obsKey.type	= recPhasBiasType;
 				obsKey.num	= ft;
 				measEntry.addNoiseEntry(obsKey, 1, recPhasBiasVar);
 			}
@@ -771,7 +785,7 @@ void stationPPP(
 			{
 				ObsKey obsKey;
 				obsKey.Sat	= obs.Sat;
-				obsKey.type	= "satPhasBias";
+				obsKey.type	= satPhasBiasType;
 				obsKey.num	= ft;
 				measEntry.addNoiseEntry(obsKey, 1, satPhasBiasVar);
 			}
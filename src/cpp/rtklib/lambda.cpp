@@ -18,6 +18,8 @@
 #include "algebra.hpp"
 #include "common.hpp"
 #include "streamTrace.hpp"
+#include "GNSSambres.hpp"
+#include "lambda.h"
 
 
 /* constants/macros ----------------------------------------------------------*/
@@ -218,166 +220,6 @@ double ffratio(double PfILS,int n,double Pf)
 
 	return mu;
 }
-/* LD factorization (Q=L'*diag(D)*L) -----------------------------------------*/
-int LD(int n, const double *Q, double *L, double *D)
-{
-	int i,j,k,info=0;
-	double a,*A=mat(n,n);
-
-	memcpy(A,Q,sizeof(double)*n*n);
-	for (i=n-1;i>=0;i--)
-	{
-		if ((D[i]=A[i+i*n])<=0.0) {info=-1; break;}
-		a=sqrt(D[i]);
-		for (j=0;j<=i;j++) L[i+j*n]=A[i+j*n]/a;
-		for (j=0;j<=i-1;j++) for (k=0;k<=j;k++) A[j+k*n]-=L[i+k*n]*L[i+j*n];
-		for (j=0;j<=i;j++) L[i+j*n]/=L[i+i*n];
-	}
-	free(A);
-	if (info) fprintf(stderr,"%s : LD factorization error\n",__FILE__);
-	return info;
-}
-/* integer gauss transformation ----------------------------------------------*/
-void gauss(int n, double *L, double *Z, int i, int j)
-{
-	int k,mu;
-
-	if ((mu=(int)ROUND(L[i+j*n]))!=0)
-	{
-		for (k=i;k<n;k++) L[k+n*j]-=(double)mu*L[k+i*n];
-		for (k=0;k<n;k++) Z[k+n*j]-=(double)mu*Z[k+i*n];
-	}
-}
-/* permutations --------------------------------------------------------------*/
-void perm(int n, double *L, double *D, int j, double del, double *Z)
-{
-	int k;
-	double eta,lam,a0,a1;
-
-	eta=D[j]/del;
-	lam=D[j+1]*L[j+1+j*n]/del;
-	D[j]=eta*D[j+1]; D[j+1]=del;
-	for (k=0;k<=j-1;k++)
-	{
-		a0=L[j+k*n]; a1=L[j+1+k*n];
-		L[j+k*n]=-L[j+1+j*n]*a0+a1;
-		L[j+1+k*n]=eta*a0+lam*a1;
-	}
-	L[j+1+j*n]=lam;
-	for (k=j+2;k<n;k++) SWAP(L[k+j*n],L[k+(j+1)*n]);
-	for (k=0;k<n;k++) SWAP(Z[k+j*n],Z[k+(j+1)*n]);
-}
-/* lambda reduction (z=Z'*a, Qz=Z'*Q*Z=L'*diag(D)*L) (ref.[1]) ---------------*/
-void reduction(int n, double *L, double *D, double *Z)
-{
-	int i,j,k;
-	double del;
-
-	j=n-2; k=n-2;
-	while (j>=0)
-	{
-		if (j<=k)
-			for (i=j+1;i<n;i++)
-				gauss(n,L,Z,i,j);
-		del=D[j]+L[j+1+j*n]*L[j+1+j*n]*D[j+1];
-		if (del+1E-6<D[j+1])
-		{ /* compared considering numerical error */
-			perm(n,L,D,j,del,Z);
-			k=j; j=n-2;
-		}
-		else j--;
-	}
-}
-/* modified lambda (mlambda) search (ref. [2]) -------------------------------*/
-int search(
-	int n, 
-	int m, 
-	const double *L, 
-	const double *D,
-	const double *zs,
-	double *zn, 
-	double *s)
-{
-	int i,j,k,c,nn=0,imax=0;
-	double newdist,maxdist=1E99,y;
-	double *S=zeros(n,n),*dist=mat(n,1),*zb=mat(n,1),*z=mat(n,1),*step=mat(n,1);
-
-	k=n-1; dist[k]=0.0;
-	zb[k]=zs[k];
-	z[k]=ROUND(zb[k]); y=zb[k]-z[k]; step[k]=SGN(y);
-	for (c=0;c<LOOPMAX;c++)
-	{
-		newdist=dist[k]+y*y/D[k];
-		if (newdist<maxdist)
-		{
-			if (k!=0)
-			{
-				dist[--k]=newdist;
-				for (i=0;i<=k;i++)
-					S[k+i*n]=S[k+1+i*n]+(z[k+1]-zb[k+1])*L[k+1+i*n];
-				zb[k]=zs[k]+S[k+k*n];
-				z[k]=ROUND(zb[k]);
-				y=zb[k]-z[k];
-				step[k]=SGN(y);
-			}
-			else
-			{
-				if (nn<m)
-				{
-					if (nn==0||newdist>s[imax])
-						imax=nn;
-					for (i=0;i<n;i++)
-						zn[i+nn*n]=z[i];
-					s[nn++]=newdist;
-				}
-				else
-				{
-					if (newdist<s[imax])
-					{
-						for (i=0;i<n;i++)
-							zn[i+imax*n]=z[i];
-						s[imax]=newdist;
-						for (i=imax=0;i<m;i++)
-							if (s[imax]<s[i])
-								imax=i;
-					}
-					maxdist=s[imax];
-				}
-				z[0]+=step[0];
-				y=zb[0]-z[0];
-				step[0]=-step[0]-SGN(step[0]);
-			}
-		}
-		else
-		{
-			if (k==n-1)
-				break;
-			else
-			{
-				k++;
-				z[k]+=step[k]; y=zb[k]-z[k]; step[k]=-step[k]-SGN(step[k]);
-			}
-		}
-	}
-	for (i=0;i<m-1;i++)
-	{ /* sort by s */
-		for (j=i+1;j<m;j++)
-		{
-			if (s[i]<s[j])
-				continue;
-			SWAP(s[i],s[j]);
-			for (k=0;k<n;k++) SWAP(zn[k+i*n],zn[k+j*n]);
-		}
-	}
-	free(S); free(dist); free(zb); free(z); free(step);
-
-	if (c>=LOOPMAX)
-	{
-		fprintf(stderr,"%s : search loop count overflow\n",__FILE__);
-		return -1;
-	}
-	return 0;
-}
 /* lambda/mlambda integer least-square estimation ------------------------------
 * integer least-square estimation. reduction is performed by lambda (ref.[1]),
 * and search by mlambda (ref.[2]).
@@ -404,40 +246,61 @@ int lambda(
 	double Pf, 
 	bool& pass)
 {
-	int info,i;
-	double *L,*D,*Z,*z,*E,ratio,cratio=0,srate=1;
-
 	if (n<=0||m<=0)
 		return -1;
 	
-	L=zeros(n,n); D=mat(n,1); Z=eye(n); z=mat(n,1),E=mat(n,m);
-
+	Eigen::Map<const VectorXd> aflt	(a, n);
+	Eigen::Map<const MatrixXd> Qa	(Q, n, n);
+	
+	MatrixXd L;
+	VectorXd D;
+	
 	/* LD factorization */
-	if (!(info=LD(n,Q,L,D)))
+	if (LTDL_factorization(Qa, L, D) == false)
 	{
-		/* lambda reduction */
-		reduction(n,L,D,Z);
+		fprintf(stderr,"%s : LD factorization error\n",__FILE__);
+		return -1;
+	}
+	
+	/* lambda reduction */
+	MatrixXd Z = MatrixXd::Identity(n, n);
+	lambda_reduction(L, D, Z);
 
-		/* success-rate calculation */
-		for (i=0;i<n;i++)
-			srate *= (2*normcdfar(0.5/sqrt(D[i]),0,1)-1);
+	/* success-rate calculation */
+	double srate = 1;
+	for (int i=0;i<n;i++)
+		srate *= (2*normcdfar(0.5/sqrt(D(i)),0,1)-1);
 
-		/* fixed fail-rate to derive critical value */
-		cratio=ffratio(1-srate,n,Pf);
+	/* fixed fail-rate to derive critical value */
+	double cratio = ffratio(1-srate,n,Pf);
 
-		matmul("TN",n,1,n,1,Z,a,0,z); /* z=Z'*a */
+	VectorXd z = Z.transpose() * aflt;
 
-		/* mlambda search */
-		if (!(info=search(n,m,L,D,z,E,s))) 
-		{
-			info=solve("T",Z,E,n,m,F); /* F=Z'\E */
-		}
-		/* ambiguity validation test */
-		ratio=s[0]/s[1];
-		tracepdeex(2,trace,"  srate = %8.4f %8.2f %8.2f ", srate, 1/cratio, 1/ratio);
-		pass = (ratio <= cratio);
+	/* mlambda search */
+	LambdaSearch search;
+	search.nset		= m;
+	search.maxLoops	= LOOPMAX;
+	
+	MatrixXd E;
+	VectorXd dists;
+	int ncand = lambda_candidates(L, D, z, search, E, dists);
+	if (ncand < 0)
+	{
+		fprintf(stderr,"%s : search loop count overflow\n",__FILE__);
+		return -1;
 	}
-	//if (info==-1&&fppde!=nullptr) fprintf(fppde,"Error\n");
-	free(L); free(D); free(Z); free(z); free(E);
-	return info;
+	
+	Eigen::Map<VectorXd>(s, m) = VectorXd::Zero(m);
+	Eigen::Map<VectorXd>(s, ncand) = dists;
+	
+	/* F=Z'\E */
+	Eigen::Map<MatrixXd>(F, n, m) = MatrixXd::Zero(n, m);
+	Eigen::Map<MatrixXd>(F, n, ncand) = Z.transpose().partialPivLu().solve(E);
+	
+	/* ambiguity validation test */
+	double ratio = s[0]/s[1];
+	tracepdeex(2,trace,"  srate = %8.4f %8.2f %8.2f ", srate, 1/cratio, 1/ratio);
+	pass = (ratio <= cratio);
+	
+	return 0;
 }
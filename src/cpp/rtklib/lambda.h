@@ -2,6 +2,9 @@
 #ifndef __LAMBDA_H_
 #define __LAMBDA_H_
 
+double normcdfar(double x, double mu, double sigma);
+double ffratio(double PfILS, int n, double Pf);
+
 /* integer ambiguity resolution ----------------------------------------------*/
 int lambda(
 	Trace& trace, 
@@ -1013,7 +1013,7 @@ int readrnxobsb(
 			if	(pass)
 			{
 				// save obs data
-				obsList.push_back(rawObs);
+				obsList.push_back(std::move(rawObs));
 			}
 		}
 
@@ -1910,6 +1910,11 @@ int readrnxclk(
 		nav.pclkMap[idString].push_back(preciseClock);
 	}
 
+	for (auto& [id, pclkList] : nav.pclkMap)
+	{
+		pclkList.finalise();
+	}
+
 	return nav.pclkMap.size() > 0;
 }
 